@@ -0,0 +1,133 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "enclosuredownloadjob.h"
+#include "localhttpserver.h"
+#include "settingsmanager.h"
+#include "testutils.h"
+
+// Runs several episode downloads from a local HTTP server at the same time
+// and reports how long the GUI thread was busy handling the downloaded data,
+// both as measured by the jobs and as the longest gap between the timer
+// events of the event loop.  The amount of parallel downloads and the size
+// of every episode in MiB can be set through the KASTS_BENCHMARK_DOWNLOADS
+// and KASTS_BENCHMARK_SIZE environment variables.
+class EnclosureDownloadBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void initMain()
+    {
+        TestUtils::setUpTemporaryEnvironment();
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkParallelDownloads();
+
+private:
+    LocalHttpServer m_server;
+    QTemporaryDir m_dir;
+    QByteArray m_data;
+    int m_downloads = 0;
+};
+
+void EnclosureDownloadBenchmark::initTestCase()
+{
+    QCoreApplication::setOrganizationName(QStringLiteral("KDE"));
+    QCoreApplication::setApplicationName(QStringLiteral("Kasts"));
+
+    m_downloads = TestUtils::parameter("KASTS_BENCHMARK_DOWNLOADS", 4);
+    m_data.resize(qsizetype(TestUtils::parameter("KASTS_BENCHMARK_SIZE", 64)) * 1024 * 1024);
+    for (qsizetype i = 0; i < m_data.size(); ++i) {
+        m_data[i] = static_cast<char>((i * 2654435761U) >> 24);
+    }
+
+    QVERIFY(m_dir.isValid());
+    QVERIFY(m_server.listen());
+    for (int i = 0; i < m_downloads; ++i) {
+        m_server.setResource(QStringLiteral("/episode-%1.mp3").arg(i), m_data, QByteArray("audio/mpeg"));
+    }
+
+    // every download over a single connection, as most of them are
+    SettingsManager::self()->setEpisodeDownloadConnections(1);
+}
+
+void EnclosureDownloadBenchmark::benchmarkParallelDownloads()
+{
+    std::vector<std::unique_ptr<EnclosureDownloadJob>> jobs;
+    for (int i = 0; i < m_downloads; ++i) {
+        jobs.push_back(std::make_unique<EnclosureDownloadJob>(i + 1,
+                                                              m_server.url(QStringLiteral("/episode-%1.mp3").arg(i)).toString(),
+                                                              m_dir.filePath(QStringLiteral("episode-%1.mp3").arg(i)),
+                                                              QStringLiteral("Episode %1").arg(i)));
+        jobs.back()->setAutoDelete(false);
+    }
+
+    // anything that keeps the event loop from running for longer than the
+    // interval of the timer shows up as a gap between its events
+    qint64 maxGap = 0;
+    QElapsedTimer gapTimer;
+    QTimer ticker;
+    ticker.setInterval(1);
+    connect(&ticker, &QTimer::timeout, this, [&maxGap, &gapTimer]() {
+        maxGap = std::max(maxGap, gapTimer.restart());
+    });
+
+    int finished = 0;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        gapTimer.start();
+        ticker.start();
+        for (const auto &job : jobs) {
+            connect(job.get(), &KJob::result, this, [&finished]() {
+                ++finished;
+            });
+            job->start();
+        }
+        QTRY_COMPARE_WITH_TIMEOUT(finished, m_downloads, 600000);
+        ticker.stop();
+    }
+    const double seconds = std::max(timer.elapsed(), qint64(1)) / 1000.0;
+
+    qint64 guiThreadTime = 0;
+    qint64 maxGuiThreadTime = 0;
+    int chunks = 0;
+    for (int i = 0; i < m_downloads; ++i) {
+        QCOMPARE(jobs[i]->error(), 0);
+        QCOMPARE(QFileInfo(m_dir.filePath(QStringLiteral("episode-%1.mp3").arg(i))).size(), m_data.size());
+        guiThreadTime += jobs[i]->guiThreadTime();
+        maxGuiThreadTime = std::max(maxGuiThreadTime, jobs[i]->maxGuiThreadTime());
+        chunks += jobs[i]->writtenChunks();
+    }
+
+    qInfo().noquote() << QStringLiteral(
+                             "%1 parallel downloads of %2 MiB: %3 MiB/s; %4 ms on the GUI thread for %5 chunks, longest %6 µs; longest event loop gap %7 ms")
+                             .arg(m_downloads)
+                             .arg(m_data.size() / (1024 * 1024))
+                             .arg(m_downloads * m_data.size() / (1024.0 * 1024.0) / seconds, 0, 'f', 1)
+                             .arg(guiThreadTime / 1000000.0, 0, 'f', 1)
+                             .arg(chunks)
+                             .arg(maxGuiThreadTime / 1000)
+                             .arg(maxGap);
+}
+
+QTEST_GUILESS_MAIN(EnclosureDownloadBenchmark)
+
+#include "enclosuredownloadbenchmark.moc"
@@ -0,0 +1,197 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+#include <memory>
+
+#include "enclosuredownloadjob.h"
+#include "localhttpserver.h"
+#include "settingsmanager.h"
+#include "testutils.h"
+
+// Downloads episodes from a local HTTP server over one or several
+// connections, including the fall back for servers that don't honour ranges
+// and the resumption of interrupted segmented downloads.
+class EnclosureDownloadJobTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void initMain()
+    {
+        TestUtils::setUpTemporaryEnvironment();
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testSingleDownload();
+    void testSegmentedDownload();
+    void testRangesIgnored();
+    void testSegmentedResume();
+
+private:
+    bool download();
+    QList<QByteArray> requestedRanges() const;
+
+    LocalHttpServer m_server;
+    QTemporaryDir m_dir;
+    QString m_filename;
+    QByteArray m_data;
+
+    inline static const qint64 m_segmentSize = 4 * 1024 * 1024;
+};
+
+void EnclosureDownloadJobTest::initTestCase()
+{
+    QCoreApplication::setOrganizationName(QStringLiteral("KDE"));
+    QCoreApplication::setApplicationName(QStringLiteral("Kasts"));
+
+    // three segments, each of the minimum segment size
+    m_data.resize(3 * m_segmentSize);
+    for (qsizetype i = 0; i < m_data.size(); ++i) {
+        m_data[i] = static_cast<char>((i * 2654435761U) >> 24);
+    }
+
+    QVERIFY(m_dir.isValid());
+    QVERIFY(m_server.listen());
+    m_server.setResource(QStringLiteral("/episode.mp3"), m_data, QByteArray("audio/mpeg"));
+}
+
+void EnclosureDownloadJobTest::init()
+{
+    m_filename = m_dir.filePath(QStringLiteral("episode.mp3"));
+    m_server.clearRequests();
+    m_server.setIgnoreRanges(false);
+    SettingsManager::self()->setEpisodeDownloadConnections(3);
+}
+
+void EnclosureDownloadJobTest::cleanup()
+{
+    QFile::remove(m_filename);
+    EnclosureDownloadJob::removePartialDownload(m_filename);
+}
+
+void EnclosureDownloadJobTest::testSingleDownload()
+{
+    SettingsManager::self()->setEpisodeDownloadConnections(1);
+
+    QVERIFY(download());
+    QCOMPARE(requestedRanges(), QList<QByteArray>{QByteArray()});
+}
+
+void EnclosureDownloadJobTest::testSegmentedDownload()
+{
+    QVERIFY(download());
+
+    QList<QByteArray> ranges = requestedRanges();
+    std::sort(ranges.begin(), ranges.end());
+    QCOMPARE(ranges, (QList<QByteArray>{"bytes=0-4194303", "bytes=4194304-8388607", "bytes=8388608-12582911"}));
+}
+
+void EnclosureDownloadJobTest::testRangesIgnored()
+{
+    // the HEAD request claims range support, but every segment gets the
+    // complete file; the download has to start over over a single connection
+    m_server.setIgnoreRanges(true);
+
+    QVERIFY(download());
+    QCOMPARE(requestedRanges().count(QByteArray()), 1);
+    QCOMPARE(requestedRanges().last(), QByteArray());
+}
+
+void EnclosureDownloadJobTest::testSegmentedResume()
+{
+    // interrupted download: the first segment is partially done, the second
+    // one hasn't started yet and the third one is complete
+    const qint64 firstDone = 1024 * 1024 + 17;
+    QByteArray part(m_data.size(), '\0');
+    part.replace(0, firstDone, m_data.left(firstDone));
+    part.replace(2 * m_segmentSize, m_segmentSize, m_data.mid(2 * m_segmentSize));
+
+    QFile partFile(m_filename + QStringLiteral(".part"));
+    QVERIFY(partFile.open(QIODevice::WriteOnly));
+    partFile.write(part);
+    partFile.close();
+
+    const QJsonArray segments{
+        QJsonObject{{QStringLiteral("start"), 0}, {QStringLiteral("end"), m_segmentSize - 1}, {QStringLiteral("done"), firstDone}},
+        QJsonObject{{QStringLiteral("start"), m_segmentSize}, {QStringLiteral("end"), 2 * m_segmentSize - 1}, {QStringLiteral("done"), 0}},
+        QJsonObject{{QStringLiteral("start"), 2 * m_segmentSize}, {QStringLiteral("end"), 3 * m_segmentSize - 1}, {QStringLiteral("done"), m_segmentSize}},
+    };
+    // the validator is the ETag that the server sends for the file
+    const QString etag = QStringLiteral("\"%1\"").arg(QString::fromLatin1(QCryptographicHash::hash(m_data, QCryptographicHash::Md5).toHex()));
+    const QJsonObject sidecar{
+        {QStringLiteral("size"), m_data.size()},
+        {QStringLiteral("validator"), etag},
+        {QStringLiteral("segments"), segments},
+    };
+    QFile sidecarFile(m_filename + QStringLiteral(".segments"));
+    QVERIFY(sidecarFile.open(QIODevice::WriteOnly));
+    sidecarFile.write(QJsonDocument(sidecar).toJson(QJsonDocument::Compact));
+    sidecarFile.close();
+    QCOMPARE(EnclosureDownloadJob::partialDownloadSize(m_filename), firstDone + m_segmentSize);
+
+    QVERIFY(download());
+    QCOMPARE(EnclosureDownloadJob::partialDownloadSize(m_filename), qint64(0));
+
+    // only the missing data has been requested
+    QList<QByteArray> ranges = requestedRanges();
+    std::sort(ranges.begin(), ranges.end());
+    QCOMPARE(ranges, (QList<QByteArray>{"bytes=1048593-4194303", "bytes=4194304-8388607"}));
+}
+
+bool EnclosureDownloadJobTest::download()
+{
+    auto job = std::make_unique<EnclosureDownloadJob>(1, m_server.url(QStringLiteral("/episode.mp3")).toString(), m_filename, QStringLiteral("Episode"));
+    job->setAutoDelete(false);
+    QSignalSpy spy(job.get(), &KJob::result);
+    job->start();
+    if (!spy.wait(60000)) {
+        qWarning() << "Download did not finish";
+        return false;
+    }
+    if (job->error()) {
+        qWarning() << "Download failed:" << job->errorString();
+        return false;
+    }
+
+    QFile file(m_filename);
+    if (!file.open(QIODevice::ReadOnly) || file.readAll() != m_data) {
+        qWarning() << "Downloaded file differs from the original";
+        return false;
+    }
+
+    // the data of the segmented download has been cleaned up
+    return !QFile::exists(m_filename + QStringLiteral(".part")) && !QFile::exists(m_filename + QStringLiteral(".segments"));
+}
+
+QList<QByteArray> EnclosureDownloadJobTest::requestedRanges() const
+{
+    QList<QByteArray> ranges;
+    const QList<LocalHttpServer::Request> requests = m_server.requests();
+    for (const LocalHttpServer::Request &request : requests) {
+        if (request.method == "GET") {
+            ranges += request.headers.value("range");
+        }
+    }
+    return ranges;
+}
+
+QTEST_GUILESS_MAIN(EnclosureDownloadJobTest)
+
+#include "enclosuredownloadjobtest.moc"
@@ -0,0 +1,121 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QTest>
+
+#include <algorithm>
+
+#include "database.h"
+#include "datamanager.h"
+#include "fetcher.h"
+#include "localhttpserver.h"
+#include "memoryusage.h"
+#include "testutils.h"
+
+// Runs complete feed refreshes against generated feeds served from a local
+// HTTP server and reports feeds/s, items/s, peak memory usage and database
+// size.  The amount of feeds and items per feed can be set through the
+// KASTS_BENCHMARK_FEEDS and KASTS_BENCHMARK_ITEMS environment variables.
+class FetcherBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void initMain()
+    {
+        TestUtils::setUpTemporaryEnvironment();
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkInitialFetchAll();
+    void benchmarkUnchangedFetchAll();
+
+private:
+    void fetchAll(const QString &description);
+    static int rowCount(const QString &table);
+
+    LocalHttpServer m_server;
+    int m_feeds = 0;
+    int m_items = 0;
+};
+
+void FetcherBenchmark::initTestCase()
+{
+    QCoreApplication::setOrganizationName(QStringLiteral("KDE"));
+    QCoreApplication::setApplicationName(QStringLiteral("Kasts"));
+
+    m_feeds = TestUtils::parameter("KASTS_BENCHMARK_FEEDS", 50);
+    m_items = TestUtils::parameter("KASTS_BENCHMARK_ITEMS", 100);
+
+    QVERIFY(m_server.listen());
+    QStringList urls;
+    for (int i = 0; i < m_feeds; ++i) {
+        const QString path = QStringLiteral("/feed-%1.xml").arg(i);
+        m_server.setResource(path, TestUtils::generateFeed(QStringLiteral("feed-%1").arg(i), m_items), QByteArray("application/rss+xml"));
+        urls += m_server.url(path).toString();
+    }
+
+    Database::instance();
+    DataManager::instance().addFeeds(urls, false);
+    QCOMPARE(rowCount(QStringLiteral("Feeds")), m_feeds);
+}
+
+void FetcherBenchmark::benchmarkInitialFetchAll()
+{
+    QBENCHMARK_ONCE {
+        fetchAll(QStringLiteral("initial"));
+    }
+    QCOMPARE(rowCount(QStringLiteral("Entries")), m_feeds * m_items);
+}
+
+void FetcherBenchmark::benchmarkUnchangedFetchAll()
+{
+    // all feeds are answered with 304 Not Modified this time
+    m_server.clearRequests();
+    QBENCHMARK_ONCE {
+        fetchAll(QStringLiteral("unchanged"));
+    }
+    QCOMPARE(m_server.requests().count(), m_feeds);
+    QCOMPARE(rowCount(QStringLiteral("Entries")), m_feeds * m_items);
+}
+
+void FetcherBenchmark::fetchAll(const QString &description)
+{
+    const int entriesBefore = rowCount(QStringLiteral("Entries"));
+
+    QElapsedTimer timer;
+    timer.start();
+    Fetcher::instance().fetchAll();
+    QTRY_VERIFY_WITH_TIMEOUT(!Fetcher::instance().property("updating").toBool(), 600000);
+    const double seconds = std::max(timer.elapsed(), qint64(1)) / 1000.0;
+
+    // items that were parsed, not only the ones that were new
+    const int items = m_feeds * m_items;
+    qInfo().noquote() << QStringLiteral("%1 refresh: %2 feeds/s, %3 items/s, %4 new items, peak RSS %5 KiB, database size %6 KiB")
+                             .arg(description)
+                             .arg(m_feeds / seconds, 0, 'f', 1)
+                             .arg(items / seconds, 0, 'f', 1)
+                             .arg(rowCount(QStringLiteral("Entries")) - entriesBefore)
+                             .arg(MemoryUsage::peakResidentSetSize() / 1024)
+                             .arg(Database::size() / 1024);
+}
+
+int FetcherBenchmark::rowCount(const QString &table)
+{
+    QSqlQuery query;
+    query.prepare(QStringLiteral("SELECT COUNT(*) FROM %1;").arg(table));
+    Database::instance().execute(query);
+    return query.next() ? query.value(0).toInt() : 0;
+}
+
+QTEST_GUILESS_MAIN(FetcherBenchmark)
+
+#include "fetcherbenchmark.moc"
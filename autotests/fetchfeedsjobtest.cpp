@@ -0,0 +1,124 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTest>
+
+#include "database.h"
+#include "datamanager.h"
+#include "fetcher.h"
+#include "localhttpserver.h"
+#include "settingsmanager.h"
+#include "testutils.h"
+
+// Checks the global and per-host limits of the feed update scheduler against
+// a local HTTP server that serves hundreds of small feeds spread over several
+// hosts with an artificial latency.  The amount of feeds and the latency can
+// be set through the KASTS_BENCHMARK_FEEDS and KASTS_BENCHMARK_LATENCY
+// environment variables.
+class FetchFeedsJobTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void initMain()
+    {
+        TestUtils::setUpTemporaryEnvironment();
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testConcurrencyLimits_data();
+    void testConcurrencyLimits();
+
+private:
+    LocalHttpServer m_server;
+    QStringList m_urls;
+    int m_feeds = 0;
+
+    // every address of the loopback network counts as a separate host
+    inline static const QStringList m_hosts = {
+        QStringLiteral("127.0.0.1"),
+        QStringLiteral("127.0.0.2"),
+        QStringLiteral("127.0.0.3"),
+        QStringLiteral("127.0.0.4"),
+    };
+};
+
+void FetchFeedsJobTest::initTestCase()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("Only Linux routes the whole 127.0.0.0/8 network to the loopback interface");
+#endif
+
+    QCoreApplication::setOrganizationName(QStringLiteral("KDE"));
+    QCoreApplication::setApplicationName(QStringLiteral("Kasts"));
+
+    m_feeds = TestUtils::parameter("KASTS_BENCHMARK_FEEDS", 200);
+    m_server.setLatency(TestUtils::parameter("KASTS_BENCHMARK_LATENCY", 50));
+
+    QVERIFY(m_server.listen());
+    for (int i = 0; i < m_feeds; ++i) {
+        const QString path = QStringLiteral("/feed-%1.xml").arg(i);
+        m_server.setResource(path, TestUtils::generateFeed(QStringLiteral("feed-%1").arg(i), 5), QByteArray("application/rss+xml"));
+        m_urls += m_server.url(path, m_hosts.at(i % m_hosts.count())).toString();
+    }
+
+    Database::instance();
+    DataManager::instance().addFeeds(m_urls, false);
+}
+
+void FetchFeedsJobTest::testConcurrencyLimits_data()
+{
+    QTest::addColumn<int>("maxParallel");
+    QTest::addColumn<int>("maxParallelPerHost");
+    QTest::addColumn<bool>("interactive");
+
+    QTest::newRow("limited by host") << 16 << 2 << false;
+    QTest::newRow("limited globally") << 6 << 4 << false;
+    // interactive updates get a single extra slot, not an unlimited amount
+    QTest::newRow("interactive") << 6 << 4 << true;
+}
+
+void FetchFeedsJobTest::testConcurrencyLimits()
+{
+    QFETCH(int, maxParallel);
+    QFETCH(int, maxParallelPerHost);
+    QFETCH(bool, interactive);
+
+    SettingsManager::self()->setMaximumParallelFeedUpdates(maxParallel);
+    SettingsManager::self()->setMaximumParallelFeedUpdatesPerHost(maxParallelPerHost);
+    m_server.clearRequests();
+
+    QElapsedTimer timer;
+    timer.start();
+    if (interactive) {
+        Fetcher::instance().fetch(m_urls, DataTypes::InteractiveFetch);
+    } else {
+        Fetcher::instance().fetchAll();
+    }
+    QTRY_VERIFY_WITH_TIMEOUT(!Fetcher::instance().property("updating").toBool(), 600000);
+    const qint64 elapsed = timer.elapsed();
+
+    qInfo().noquote() << QStringLiteral("%1 feeds on %2 hosts in %3 ms; at most %4 requests at once, %5 per host")
+                             .arg(m_feeds)
+                             .arg(m_hosts.count())
+                             .arg(elapsed)
+                             .arg(m_server.maxConcurrentRequests())
+                             .arg(m_server.maxConcurrentRequestsPerHost());
+
+    QCOMPARE(m_server.requests().count(), m_feeds);
+    QVERIFY(m_server.maxConcurrentRequestsPerHost() <= maxParallelPerHost);
+    QVERIFY(m_server.maxConcurrentRequests() <= maxParallel + (interactive ? 1 : 0));
+    // a single host mustn't serialize the updates of the others
+    QVERIFY(m_server.maxConcurrentRequests() > maxParallelPerHost);
+}
+
+QTEST_GUILESS_MAIN(FetchFeedsJobTest)
+
+#include "fetchfeedsjobtest.moc"
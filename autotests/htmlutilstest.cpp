@@ -0,0 +1,134 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include <QStringList>
+#include <QTest>
+#include <QTextDocumentFragment>
+#include <QXmlStreamReader>
+
+#include <utility>
+
+#include "htmlutils.h"
+#include "testutils.h"
+
+// Checks HtmlUtils::toPlainText() against the expected plain text and, where
+// both should agree, against QTextDocumentFragment, which was used to convert
+// titles before.  The benchmark converts the titles of a generated feed with
+// both; the amount of items can be set through the KASTS_BENCHMARK_ITEMS
+// environment variable.
+class HtmlUtilsTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void initMain()
+    {
+        // QTextDocumentFragment needs a QGuiApplication, but not a display
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+private Q_SLOTS:
+    void testToPlainText_data();
+    void testToPlainText();
+    void benchmarkTitles_data();
+    void benchmarkTitles();
+};
+
+void HtmlUtilsTest::testToPlainText_data()
+{
+    QTest::addColumn<QString>("html");
+    QTest::addColumn<QString>("plainText");
+    // false for input that is deliberately handled differently, like invalid
+    // entities and unterminated tags, which are kept as text
+    QTest::addColumn<bool>("matchesDocument");
+
+    QTest::newRow("plain") << QStringLiteral("Episode 1: the beginning") << QStringLiteral("Episode 1: the beginning") << true;
+    QTest::newRow("empty") << QString() << QString() << true;
+    QTest::newRow("named entities") << QStringLiteral("Tom &amp; Jerry &lt;live&gt; &quot;uncut&quot;") << QStringLiteral("Tom & Jerry <live> \"uncut\"")
+                                    << true;
+    QTest::newRow("typographic entities") << QStringLiteral("Part 1 &ndash; Intro&hellip; &ldquo;quoted&rdquo;")
+                                          << QStringLiteral("Part 1 – Intro… “quoted”") << true;
+    QTest::newRow("decimal code point") << QStringLiteral("Caf&#233; &#8212; bar") << QStringLiteral("Café — bar") << true;
+    QTest::newRow("hexadecimal code point") << QStringLiteral("&#x1F3A7; Podcast &#x2014; news") << QStringLiteral("\U0001F3A7 Podcast — news") << true;
+    QTest::newRow("uppercase hexadecimal code point") << QStringLiteral("A &#X2014; B") << QStringLiteral("A — B") << false;
+    QTest::newRow("zero code point") << QStringLiteral("A &#0; B") << QStringLiteral("A &#0; B") << false;
+    QTest::newRow("code point out of range") << QStringLiteral("A &#x110000; B") << QStringLiteral("A &#x110000; B") << false;
+    QTest::newRow("invalid code point") << QStringLiteral("A &#12ab; B") << QStringLiteral("A &#12ab; B") << false;
+    QTest::newRow("unknown entity") << QStringLiteral("A &unknown; B") << QStringLiteral("A &unknown; B") << false;
+    QTest::newRow("ampersand") << QStringLiteral("Q & A") << QStringLiteral("Q & A") << true;
+    QTest::newRow("inline tags") << QStringLiteral("<b>Bold</b> and <i>italic</i> <a href=\"https://example.org\">link</a>")
+                                 << QStringLiteral("Bold and italic link") << true;
+    QTest::newRow("block tags") << QStringLiteral("<p>One</p><p>Two</p>Three<br/>Four") << QStringLiteral("One\nTwo\nThree\nFour") << true;
+    QTest::newRow("comment") << QStringLiteral("Visible<!-- hidden <b>text</b> -->Text") << QStringLiteral("VisibleText") << true;
+    QTest::newRow("script") << QStringLiteral("Title<script type=\"text/javascript\">if (a < b) alert(1);</script> end")
+                            << QStringLiteral("Title end") << true;
+    QTest::newRow("style") << QStringLiteral("<STYLE>p { color: red; }</Style>Title") << QStringLiteral("Title") << true;
+    QTest::newRow("unterminated script") << QStringLiteral("Title<script>alert(1)") << QStringLiteral("Title") << false;
+    QTest::newRow("less than") << QStringLiteral("1 < 2 and 3 <4") << QStringLiteral("1 < 2 and 3 <4") << false;
+    QTest::newRow("unterminated tag") << QStringLiteral("Title <b and more") << QStringLiteral("Title <b and more") << false;
+    QTest::newRow("unterminated tag after tag") << QStringLiteral("<i>Title</i> <b and more") << QStringLiteral("Title <b and more") << false;
+    QTest::newRow("non-breaking spaces") << QStringLiteral("A&nbsp;&nbsp;B  C") << QStringLiteral("A B C") << true;
+    QTest::newRow("whitespace") << QStringLiteral("  A \n\t B  <p> C </p>  ") << QStringLiteral("A B\nC") << true;
+    QTest::newRow("encoded tags") << QStringLiteral("&lt;b&gt;not bold&lt;/b&gt;") << QStringLiteral("<b>not bold</b>") << true;
+}
+
+void HtmlUtilsTest::testToPlainText()
+{
+    QFETCH(QString, html);
+    QFETCH(QString, plainText);
+    QFETCH(bool, matchesDocument);
+
+    QCOMPARE(HtmlUtils::toPlainText(html), plainText);
+
+    // QTextDocumentFragment keeps some of the whitespace and uses other
+    // separators for block elements, so only the text itself is compared
+    if (matchesDocument) {
+        QCOMPARE(HtmlUtils::toPlainText(html).simplified(), QTextDocumentFragment::fromHtml(html).toPlainText().simplified());
+    }
+}
+
+void HtmlUtilsTest::benchmarkTitles_data()
+{
+    QTest::addColumn<bool>("document");
+
+    QTest::newRow("HtmlUtils") << false;
+    QTest::newRow("QTextDocumentFragment") << true;
+}
+
+void HtmlUtilsTest::benchmarkTitles()
+{
+    QFETCH(bool, document);
+
+    // the feed title ends up in every item title, so half of the titles
+    // contain markup and entities and the other half is plain text
+    const int items = TestUtils::parameter("KASTS_BENCHMARK_ITEMS", 1000);
+    QStringList titles;
+    for (const QString &feedTitle : {QStringLiteral("Plain feed"), QStringLiteral("Q&amp;amp;A &lt;b&gt;live&lt;/b&gt; &amp;ndash; news")}) {
+        QXmlStreamReader reader(TestUtils::generateFeed(feedTitle, items));
+        bool channelTitle = true;
+        while (!reader.atEnd()) {
+            if (reader.readNext() == QXmlStreamReader::StartElement && reader.name() == QLatin1String("title")) {
+                const QString title = reader.readElementText();
+                if (!std::exchange(channelTitle, false)) {
+                    titles += title;
+                }
+            }
+        }
+        QVERIFY(!reader.hasError());
+    }
+    QCOMPARE(titles.size(), 2 * items);
+
+    qsizetype length = 0;
+    QBENCHMARK {
+        for (const QString &title : std::as_const(titles)) {
+            length += document ? QTextDocumentFragment::fromHtml(title).toPlainText().size() : HtmlUtils::toPlainText(title).size();
+        }
+    }
+    QVERIFY(length > 0);
+}
+
+QTEST_MAIN(HtmlUtilsTest)
+#include "htmlutilstest.moc"
@@ -0,0 +1,180 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "localhttpserver.h"
+
+#include <QCryptographicHash>
+#include <QHostAddress>
+#include <QPointer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+#include <numeric>
+
+LocalHttpServer::LocalHttpServer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, [this]() {
+        while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+                readRequest(socket);
+            });
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+                m_buffers.remove(socket);
+                socket->deleteLater();
+            });
+        }
+    });
+}
+
+bool LocalHttpServer::listen()
+{
+    return m_server.listen(QHostAddress::Any);
+}
+
+QUrl LocalHttpServer::url(const QString &path, const QString &host) const
+{
+    QUrl url;
+    url.setScheme(QStringLiteral("http"));
+    url.setHost(host);
+    url.setPort(m_server.serverPort());
+    url.setPath(path);
+    return url;
+}
+
+void LocalHttpServer::setResource(const QString &path, const QByteArray &data, const QByteArray &contentType)
+{
+    const QByteArray etag = '"' + QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex() + '"';
+    m_resources[path] = Resource{data, contentType, etag};
+}
+
+void LocalHttpServer::setLatency(const int latency)
+{
+    m_latency = latency;
+}
+
+void LocalHttpServer::setIgnoreRanges(const bool ignore)
+{
+    m_ignoreRanges = ignore;
+}
+
+QList<LocalHttpServer::Request> LocalHttpServer::requests() const
+{
+    return m_requests;
+}
+
+void LocalHttpServer::clearRequests()
+{
+    m_requests.clear();
+    m_maxConcurrentRequests = 0;
+    m_maxConcurrentRequestsPerHost = 0;
+}
+
+int LocalHttpServer::maxConcurrentRequests() const
+{
+    return m_maxConcurrentRequests;
+}
+
+int LocalHttpServer::maxConcurrentRequestsPerHost() const
+{
+    return m_maxConcurrentRequestsPerHost;
+}
+
+void LocalHttpServer::readRequest(QTcpSocket *socket)
+{
+    QByteArray &buffer = m_buffers[socket];
+    buffer += socket->readAll();
+
+    // requests without a body only; a connection can be reused for several
+    // requests after each other
+    qsizetype end;
+    while ((end = buffer.indexOf("\r\n\r\n")) >= 0) {
+        const QList<QByteArray> lines = buffer.left(end).split('\n');
+        buffer.remove(0, end + 4);
+
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.count() < 2) {
+            socket->disconnectFromHost();
+            return;
+        }
+
+        Request request;
+        request.method = requestLine.at(0);
+        request.path = requestLine.at(1);
+        for (qsizetype i = 1; i < lines.count(); ++i) {
+            const qsizetype colon = lines.at(i).indexOf(':');
+            if (colon > 0) {
+                request.headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+            }
+        }
+        request.host = request.headers.value("host").split(':').first();
+        m_requests += request;
+
+        sendResponse(socket, request);
+    }
+}
+
+void LocalHttpServer::sendResponse(QTcpSocket *socket, const Request &request)
+{
+    // a request counts as being handled until its response has been sent
+    const int active = ++m_activeRequests[request.host];
+    m_maxConcurrentRequestsPerHost = std::max(m_maxConcurrentRequestsPerHost, active);
+    m_maxConcurrentRequests = std::max(m_maxConcurrentRequests, std::accumulate(m_activeRequests.cbegin(), m_activeRequests.cend(), 0));
+
+    QTimer::singleShot(m_latency, this, [this, socket = QPointer<QTcpSocket>(socket), request]() {
+        --m_activeRequests[request.host];
+        if (socket) {
+            socket->write(response(request));
+        }
+    });
+}
+
+QByteArray LocalHttpServer::response(const Request &request) const
+{
+    const auto it = m_resources.constFind(QString::fromUtf8(request.path));
+    if (it == m_resources.constEnd()) {
+        return QByteArray("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+    }
+
+    const Resource &resource = it.value();
+    const QByteArray headers = "ETag: " + resource.etag + "\r\nContent-Type: " + resource.contentType + "\r\nAccept-Ranges: bytes\r\n";
+
+    if (request.headers.value("if-none-match") == resource.etag) {
+        return "HTTP/1.1 304 Not Modified\r\n" + headers + "Content-Length: 0\r\n\r\n";
+    }
+
+    // single ranges only, which is all that Kasts requests; If-Range falls
+    // back to the complete resource if it has changed
+    qint64 start = 0;
+    qint64 end = resource.data.size() - 1;
+    const QByteArray range = request.headers.value("range");
+    const bool partial = range.startsWith("bytes=") && !m_ignoreRanges
+        && (!request.headers.contains("if-range") || request.headers.value("if-range") == resource.etag);
+    if (partial) {
+        const QList<QByteArray> bounds = range.mid(6).split('-');
+        start = bounds.value(0).toLongLong();
+        if (!bounds.value(1).isEmpty()) {
+            end = std::min(end, bounds.value(1).toLongLong());
+        }
+        if (start > end) {
+            return "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */" + QByteArray::number(resource.data.size()) + "\r\nContent-Length: 0\r\n\r\n";
+        }
+    }
+
+    QByteArray response;
+    if (partial) {
+        response = "HTTP/1.1 206 Partial Content\r\n" + headers + "Content-Range: bytes " + QByteArray::number(start) + "-" + QByteArray::number(end) + "/"
+            + QByteArray::number(resource.data.size()) + "\r\n";
+    } else {
+        response = "HTTP/1.1 200 OK\r\n" + headers;
+    }
+    response += "Content-Length: " + QByteArray::number(end + 1 - start) + "\r\n\r\n";
+    if (request.method != "HEAD") {
+        response += resource.data.mid(start, end + 1 - start);
+    }
+    return response;
+}
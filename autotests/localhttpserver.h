@@ -0,0 +1,75 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+#include <QUrl>
+
+class QTcpSocket;
+
+// Minimal HTTP/1.1 server that stands in for podcast hosts in the tests and
+// benchmarks.  It serves static resources and supports conditional requests
+// through ETags, HEAD requests, byte ranges and an artificial latency.
+class LocalHttpServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Request {
+        QByteArray method;
+        QByteArray path;
+        QByteArray host; // without the port
+        QHash<QByteArray, QByteArray> headers; // names in lower case
+    };
+
+    explicit LocalHttpServer(QObject *parent = nullptr);
+
+    // listens on all addresses, such that every address of the loopback
+    // network (127.0.0.1, 127.0.0.2, ...) can be used as a separate host
+    bool listen();
+    QUrl url(const QString &path, const QString &host = QStringLiteral("127.0.0.1")) const;
+
+    void setResource(const QString &path, const QByteArray &data, const QByteArray &contentType = QByteArray("application/octet-stream"));
+    void setLatency(const int latency); // in milliseconds, added to every response
+    // advertises range support, but answers range requests with the complete
+    // resource anyway, as some misconfigured servers do
+    void setIgnoreRanges(const bool ignore);
+
+    QList<Request> requests() const;
+    void clearRequests();
+
+    // highest number of requests that were being handled at the same time
+    int maxConcurrentRequests() const;
+    int maxConcurrentRequestsPerHost() const;
+
+private:
+    struct Resource {
+        QByteArray data;
+        QByteArray contentType;
+        QByteArray etag;
+    };
+
+    void readRequest(QTcpSocket *socket);
+    void sendResponse(QTcpSocket *socket, const Request &request);
+    QByteArray response(const Request &request) const;
+
+    QTcpServer m_server;
+    QHash<QString, Resource> m_resources;
+    QHash<QTcpSocket *, QByteArray> m_buffers;
+    QList<Request> m_requests;
+    int m_latency = 0;
+    bool m_ignoreRanges = false;
+
+    QHash<QByteArray, int> m_activeRequests; // per host
+    int m_maxConcurrentRequests = 0;
+    int m_maxConcurrentRequestsPerHost = 0;
+};
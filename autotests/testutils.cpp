@@ -0,0 +1,63 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "testutils.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QLocale>
+#include <QTemporaryDir>
+#include <QTimeZone>
+
+void TestUtils::setUpTemporaryEnvironment()
+{
+    // removed again when the test exits
+    static QTemporaryDir dir;
+    Q_ASSERT(dir.isValid());
+
+    for (const char *variable : {"XDG_DATA_HOME", "XDG_CONFIG_HOME", "XDG_CACHE_HOME", "XDG_STATE_HOME"}) {
+        const QString path = dir.filePath(QString::fromLatin1(variable).toLower());
+        QDir().mkpath(path);
+        qputenv(variable, QFile::encodeName(path));
+    }
+}
+
+QByteArray TestUtils::generateFeed(const QString &title, const int items)
+{
+    const QDateTime published(QDate(2025, 1, 1), QTime(12, 0), QTimeZone::UTC);
+    const QString dateFormat = QStringLiteral("ddd, dd MMM yyyy hh:mm:ss +0000");
+
+    QString feed = QStringLiteral(
+                       "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                       "<rss version=\"2.0\" xmlns:itunes=\"http://www.itunes.com/dtds/podcast-1.0.dtd\">\n"
+                       "<channel>\n<title>%1</title>\n<link>https://example.org/</link>\n<description>Generated feed %1</description>\n"
+                       "<itunes:author>Kasts</itunes:author>\n")
+                       .arg(title);
+
+    for (int i = items; i > 0; --i) {
+        feed += QStringLiteral(
+                    "<item>\n<title>%1 episode %2</title>\n<guid isPermaLink=\"false\">%1-%2</guid>\n<pubDate>%3</pubDate>\n"
+                    "<description>&lt;p&gt;Show notes of episode %2 of %1 with a &lt;a href=\"https://example.org/%2\"&gt;link&lt;/a&gt;.&lt;/p&gt;</description>\n"
+                    "<itunes:duration>%4</itunes:duration>\n"
+                    "<enclosure url=\"https://example.org/%1/episode-%2.mp3\" length=\"%5\" type=\"audio/mpeg\"/>\n</item>\n")
+                    .arg(title)
+                    .arg(i)
+                    .arg(QLocale::c().toString(published.addDays(i - items), dateFormat))
+                    .arg(1800 + i)
+                    .arg(10000000 + i);
+    }
+
+    feed += QStringLiteral("</channel>\n</rss>\n");
+    return feed.toUtf8();
+}
+
+int TestUtils::parameter(const char *name, const int defaultValue)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
@@ -0,0 +1,25 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+namespace TestUtils
+{
+// redirects the database, settings and downloads to a temporary directory;
+// has to be called before the application object is created, i.e. from
+// initMain() of the test
+void setUpTemporaryEnvironment();
+
+// RSS feed with the given number of items, each with an enclosure
+QByteArray generateFeed(const QString &title, const int items);
+
+// integer parameter of a benchmark that can be overridden through the
+// environment variable name
+int parameter(const char *name, const int defaultValue);
+}
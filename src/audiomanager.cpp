@@ -104,6 +104,7 @@ AudioManager::AudioManager(QObject *parent)
     connect(this, &AudioManager::logError, &ErrorLogModel::instance(), &ErrorLogModel::monitorErrorMessages);
 
     connect(this, &AudioManager::positionChanged, this, &AudioManager::savePlayPositionToDB);
+    connect(this, &AudioManager::entryuidChanged, &Fetcher::instance(), &Fetcher::setPlayingEntryuid);
 
     // Encapsulated in singleShot to avoid a circular dependency of the Entry and AudioManager objects
     QTimer::singleShot(0, this, [this]() {
@@ -353,7 +354,7 @@ void AudioManager::setEntryuid(const qint64 entryuid)
             }
 
             d->m_tryingRedirectedUrl = false;
-            prepareAudio(QUrl(entry->enclosure()->url()));
+            prepareAudio(Fetcher::instance().cachedRedirect(QUrl(entry->enclosure()->url())));
         }
 
     } else {
@@ -572,6 +573,7 @@ void AudioManager::mediaStatusChanged()
             // redirects
             d->m_tryingRedirectedUrl = true;
             QUrl loadUrl = QUrl(d->m_entry->enclosure()->url());
+            Fetcher::instance().removeCachedRedirect(loadUrl); // in case the cached target is no longer valid
             Fetcher::instance().getRedirectedUrl(loadUrl);
             connect(&Fetcher::instance(), &Fetcher::foundRedirectedUrl, this, [this, loadUrl](const QUrl &oldUrl, const QUrl &newUrl) {
                 qCDebug(kastsAudio) << oldUrl << newUrl;
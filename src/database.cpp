@@ -90,7 +90,21 @@ bool Database::migrate()
         TRUE_OR_RETURN(migrateTo14());
     if (dbversion < 15)
         TRUE_OR_RETURN(migrateTo15());
-    if (dbversion > 15) {
+    if (dbversion < 16)
+        TRUE_OR_RETURN(migrateTo16());
+    if (dbversion < 17)
+        TRUE_OR_RETURN(migrateTo17());
+    if (dbversion < 18)
+        TRUE_OR_RETURN(migrateTo18());
+    if (dbversion < 19)
+        TRUE_OR_RETURN(migrateTo19());
+    if (dbversion < 20)
+        TRUE_OR_RETURN(migrateTo20());
+    if (dbversion < 21)
+        TRUE_OR_RETURN(migrateTo21());
+    if (dbversion < 22)
+        TRUE_OR_RETURN(migrateTo22());
+    if (dbversion > 22) {
         qCritical() << "Database version number" << dbversion
                     << "is larger than the highest version supported by the app. You've likely downgraded the app. Stopping now since continuing will lead to "
                        "corruption of the database.";
@@ -736,6 +750,141 @@ bool Database::migrateTo15()
     return true;
 }
 
+bool Database::migrateTo16()
+{
+    qDebug() << "Migrating database to version 16";
+
+    // no backup needed since we only add extra columns
+
+    TRUE_OR_RETURN(transaction());
+    TRUE_OR_RETURN(execute(QStringLiteral("ALTER TABLE Feeds ADD COLUMN etag TEXT DEFAULT '';")));
+    TRUE_OR_RETURN(execute(QStringLiteral("ALTER TABLE Feeds ADD COLUMN lastModified TEXT DEFAULT '';")));
+    TRUE_OR_RETURN(execute(QStringLiteral("ALTER TABLE Feeds ADD COLUMN lastSize INTEGER DEFAULT 0;")));
+    TRUE_OR_RETURN(execute(QStringLiteral("PRAGMA user_version = 16;")));
+    TRUE_OR_RETURN(commit());
+    return true;
+}
+
+bool Database::migrateTo17()
+{
+    qDebug() << "Migrating database to version 17";
+
+    // no backup needed since we only add an extra column
+
+    TRUE_OR_RETURN(transaction());
+    TRUE_OR_RETURN(execute(QStringLiteral("ALTER TABLE Feeds ADD COLUMN nextUpdate INTEGER DEFAULT 0;")));
+    TRUE_OR_RETURN(execute(QStringLiteral("PRAGMA user_version = 17;")));
+    TRUE_OR_RETURN(commit());
+    return true;
+}
+
+bool Database::migrateTo18()
+{
+    qDebug() << "Migrating database to version 18";
+
+    // no backup needed since we only add an extra column
+
+    TRUE_OR_RETURN(transaction());
+    TRUE_OR_RETURN(execute(QStringLiteral("ALTER TABLE Entries ADD COLUMN contentHash TEXT DEFAULT '';")));
+    TRUE_OR_RETURN(execute(QStringLiteral("PRAGMA user_version = 18;")));
+    TRUE_OR_RETURN(commit());
+    return true;
+}
+
+bool Database::migrateTo19()
+{
+    qDebug() << "Migrating database to version 19";
+
+    // no backup needed since we only add a new table
+
+    TRUE_OR_RETURN(transaction());
+    TRUE_OR_RETURN(
+        execute(QStringLiteral("CREATE TABLE IF NOT EXISTS FeedStats ("
+                               "    feeduid INTEGER,"
+                               "    time INTEGER,"
+                               "    outcome INTEGER,"
+                               "    lookupTime INTEGER,"
+                               "    connectTime INTEGER,"
+                               "    firstByteTime INTEGER,"
+                               "    downloadTime INTEGER,"
+                               "    bytes INTEGER,"
+                               "    parseTime INTEGER,"
+                               "    processTime INTEGER,"
+                               "    writeTime INTEGER,"
+                               "    items INTEGER,"
+                               "    processedItems INTEGER,"
+                               "    skippedItems INTEGER,"
+                               "    FOREIGN KEY(feeduid) REFERENCES Feeds(feeduid));")));
+    TRUE_OR_RETURN(execute(QStringLiteral("CREATE INDEX IF NOT EXISTS FeedStatsFeeduid ON FeedStats (feeduid);")));
+    TRUE_OR_RETURN(execute(QStringLiteral("PRAGMA user_version = 19;")));
+    TRUE_OR_RETURN(commit());
+    return true;
+}
+
+bool Database::migrateTo20()
+{
+    qDebug() << "Migrating database to version 20";
+
+    // no backup needed since we only add extra columns
+
+    TRUE_OR_RETURN(transaction());
+    TRUE_OR_RETURN(execute(QStringLiteral("ALTER TABLE Feeds ADD COLUMN failureCount INTEGER DEFAULT 0;")));
+    TRUE_OR_RETURN(execute(QStringLiteral("ALTER TABLE Feeds ADD COLUMN retryAfter INTEGER DEFAULT 0;")));
+    TRUE_OR_RETURN(execute(QStringLiteral("ALTER TABLE Feeds ADD COLUMN paused BOOL DEFAULT 0;")));
+    TRUE_OR_RETURN(execute(QStringLiteral("PRAGMA user_version = 20;")));
+    TRUE_OR_RETURN(commit());
+    return true;
+}
+
+bool Database::migrateTo21()
+{
+    qDebug() << "Migrating database to version 21";
+
+    // no backup needed since we only add a new table
+
+    TRUE_OR_RETURN(transaction());
+    TRUE_OR_RETURN(
+        execute(QStringLiteral("CREATE TABLE IF NOT EXISTS FeedRedirects ("
+                               "    feeduid INTEGER,"
+                               "    oldUrl TEXT,"
+                               "    newUrl TEXT,"
+                               "    timestamp INTEGER,"
+                               "    FOREIGN KEY(feeduid) REFERENCES Feeds(feeduid));")));
+    TRUE_OR_RETURN(execute(QStringLiteral("CREATE INDEX IF NOT EXISTS FeedRedirectsOldUrl ON FeedRedirects (oldUrl);")));
+    TRUE_OR_RETURN(execute(QStringLiteral("PRAGMA user_version = 21;")));
+    TRUE_OR_RETURN(commit());
+    return true;
+}
+
+bool Database::migrateTo22()
+{
+    qDebug() << "Migrating database to version 22";
+
+    // no backup needed since we only add a new table
+
+    TRUE_OR_RETURN(transaction());
+    TRUE_OR_RETURN(
+        execute(QStringLiteral("CREATE TABLE IF NOT EXISTS DownloadQueue ("
+                               "    entryuid INTEGER UNIQUE,"
+                               "    state INTEGER,"
+                               "    priority INTEGER,"
+                               "    bytesDone INTEGER DEFAULT 0,"
+                               "    totalSize INTEGER DEFAULT 0,"
+                               "    etag TEXT,"
+                               "    lastModified TEXT,"
+                               "    queued INTEGER,"
+                               "    FOREIGN KEY(entryuid) REFERENCES Entries(entryuid));")));
+    // downloads that were running or queued when the app was last closed
+    // have been lost so far; pick them up again as interrupted downloads
+    // with normal priority
+    TRUE_OR_RETURN(
+        execute(QStringLiteral("INSERT OR IGNORE INTO DownloadQueue (entryuid, state, priority, queued) SELECT entryuid, 2, 1, CAST(strftime('%s', 'now') AS INTEGER) FROM "
+                               "Enclosures WHERE downloaded IN (1, 2);")));
+    TRUE_OR_RETURN(execute(QStringLiteral("PRAGMA user_version = 22;")));
+    TRUE_OR_RETURN(commit());
+    return true;
+}
+
 bool Database::execute(const QString &queryString)
 {
     QSqlQuery q;
@@ -808,6 +957,12 @@ void Database::createBackup(const QString &suffix)
     }
 }
 
+qint64 Database::size()
+{
+    const QString databaseFile = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/") + m_dbName;
+    return QFileInfo(databaseFile).size() + QFileInfo(databaseFile + QStringLiteral("-wal")).size();
+}
+
 int Database::version()
 {
     QSqlQuery query;
@@ -42,6 +42,9 @@ public:
     // to be used in separate threads; error reporting has to be done manually in thread!
     static bool executeThread(QSqlQuery &query);
 
+    // size on disk in bytes, including the write-ahead log
+    static qint64 size();
+
 Q_SIGNALS:
     void error(Error::Type type, const QString &url, const QString &id, const int errorId, const QString &errorString, const QString &title);
 
@@ -67,6 +70,13 @@ private:
     bool migrateTo13();
     bool migrateTo14();
     bool migrateTo15();
+    bool migrateTo16();
+    bool migrateTo17();
+    bool migrateTo18();
+    bool migrateTo19();
+    bool migrateTo20();
+    bool migrateTo21();
+    bool migrateTo22();
 
     void createBackup(const QString &suffix);
     void cleanup();
@@ -9,17 +9,22 @@
 
 #include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QHash>
 #include <QList>
 #include <QSqlDatabase>
 #include <QSqlError>
+#include <QSqlRecord>
 #include <QStandardPaths>
 #include <QUrl>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 #include <QtAssert>
+#include <algorithm>
 #include <utility>
 
+#include "audiomanager.h"
 #include "database.h"
 #include "entry.h"
 #include "feed.h"
@@ -28,6 +33,7 @@
 #include "queuemodel.h"
 #include "settingsmanager.h"
 #include "sync/sync.h"
+#include "utils/enclosuredownloadjob.h"
 #include "utils/storagemanager.h"
 
 DataManager::DataManager()
@@ -61,14 +67,37 @@ DataManager::DataManager()
                     feed->setRefreshing(true);
                 }
             });
-    connect(&Fetcher::instance(), &Fetcher::entryAdded, this, [this](const qint64 entryuid) {
-        // Only add the new entry to m_entries
-        m_entries[entryuid] = nullptr;
+    connect(&Fetcher::instance(), &Fetcher::entriesAdded, this, [this](const qint64 feeduid, const QSet<qint64> &entryuids) {
+        // Only add the new entries to m_entries; this is done immediately
+        // such that getEntry works as soon as the entries are in the database
+        for (const qint64 entryuid : entryuids) {
+            m_entries[entryuid] = nullptr;
+        }
+        m_pendingAddedEntries[feeduid] += entryuids;
+        m_pendingUpdatedFeeds += feeduid;
+        scheduleChangeNotification();
+    });
+    connect(&Fetcher::instance(), &Fetcher::entriesUpdated, this, [this](const qint64 feeduid, const QSet<qint64> &entryuids) {
+        m_pendingUpdatedEntries[feeduid] += entryuids;
+        scheduleChangeNotification();
     });
     connect(&Fetcher::instance(), &Fetcher::feedUpdated, this, [this](const qint64 feeduid) {
-        Q_EMIT feedEntriesUpdated(feeduid);
+        m_pendingUpdatedFeeds += feeduid;
+        scheduleChangeNotification();
+    });
+    connect(&Fetcher::instance(), &Fetcher::feedUrlChanged, this, [this](const qint64 feeduid, const QString &oldUrl, const QString &newUrl) {
+        qCDebug(kastsDataManager) << "Feed" << feeduid << "has moved from" << oldUrl << "to" << newUrl;
+        // the Feed object only has to be updated if it has already been loaded
+        if (Feed *feed = m_feeds.value(feeduid)) {
+            feed->setUrl(newUrl);
+        }
+        // sync services identify subscriptions by their url
+        Sync::instance().storeChangeFeedUrlAction(feeduid, oldUrl, newUrl);
     });
 
+    m_changeNotificationTimer.setSingleShot(true);
+    connect(&m_changeNotificationTimer, &QTimer::timeout, this, &DataManager::flushChangeNotifications);
+
     // Only read unique feeduids and entryuids from the database.
     // The feed and entry datastructures will be loaded lazily.
     QSqlQuery query;
@@ -113,6 +142,54 @@ Entry *DataManager::getEntry(const qint64 entryuid) const
     return nullptr;
 }
 
+void DataManager::prefetchEntries(const QList<qint64> &entryuids) const
+{
+    QStringList uidsToLoad;
+    for (const qint64 entryuid : entryuids) {
+        if (m_entries.contains(entryuid) && m_entries[entryuid] == nullptr) {
+            uidsToLoad += QString::number(entryuid);
+        }
+    }
+    if (uidsToLoad.isEmpty()) {
+        return;
+    }
+
+    // The entryuids are integers, so they can safely be put directly into
+    // the query string instead of binding them one by one
+    const QString uidList = uidsToLoad.join(QLatin1Char(','));
+    QHash<qint64, QSqlRecord> entryRecords, enclosureRecords;
+    QHash<qint64, QStringList> authors;
+
+    QSqlQuery query;
+    query.prepare(QStringLiteral("SELECT * FROM Entries WHERE entryuid IN (%1);").arg(uidList));
+    Database::instance().execute(query);
+    while (query.next()) {
+        entryRecords[query.value(QStringLiteral("entryuid")).toLongLong()] = query.record();
+    }
+
+    query.prepare(QStringLiteral("SELECT * FROM Enclosures WHERE entryuid IN (%1);").arg(uidList));
+    Database::instance().execute(query);
+    while (query.next()) {
+        const qint64 entryuid = query.value(QStringLiteral("entryuid")).toLongLong();
+        if (!enclosureRecords.contains(entryuid)) {
+            enclosureRecords[entryuid] = query.record();
+        }
+    }
+
+    query.prepare(QStringLiteral("SELECT entryuid, name FROM EntryAuthors WHERE entryuid IN (%1);").arg(uidList));
+    Database::instance().execute(query);
+    while (query.next()) {
+        authors[query.value(QStringLiteral("entryuid")).toLongLong()] += query.value(QStringLiteral("name")).toString();
+    }
+    query.finish();
+
+    for (auto it = entryRecords.cbegin(); it != entryRecords.cend(); ++it) {
+        m_entries[it.key()] = new Entry(it.key(), it.value(), authors.value(it.key()), enclosureRecords.value(it.key()));
+    }
+
+    qCDebug(kastsDataManager) << "Prefetched" << entryRecords.count() << "entries";
+}
+
 Entry *DataManager::getEntry(const QString &id) const
 {
     // Apply fuzzy logic to find matching entryuid
@@ -220,6 +297,11 @@ void DataManager::removeFeeds(const QList<Feed *> &feeds)
             query.bindValue(QStringLiteral(":feeduid"), feeduid);
             Database::instance().execute(query);
 
+            // Delete DownloadQueue
+            query.prepare(QStringLiteral("DELETE FROM DownloadQueue WHERE entryuid IN (SELECT entryuid FROM Entries WHERE feeduid=:feeduid);"));
+            query.bindValue(QStringLiteral(":feeduid"), feeduid);
+            Database::instance().execute(query);
+
             // Delete Enclosures
             query.prepare(QStringLiteral("DELETE FROM Enclosures WHERE entryuid IN (SELECT entryuid FROM Entries WHERE feeduid=:feeduid);"));
             query.bindValue(QStringLiteral(":feeduid"), feeduid);
@@ -230,6 +312,16 @@ void DataManager::removeFeeds(const QList<Feed *> &feeds)
             query.bindValue(QStringLiteral(":feeduid"), feeduid);
             Database::instance().execute(query);
 
+            // Delete FeedStats
+            query.prepare(QStringLiteral("DELETE FROM FeedStats WHERE feeduid=:feeduid;"));
+            query.bindValue(QStringLiteral(":feeduid"), feeduid);
+            Database::instance().execute(query);
+
+            // Delete FeedRedirects
+            query.prepare(QStringLiteral("DELETE FROM FeedRedirects WHERE feeduid=:feeduid;"));
+            query.bindValue(QStringLiteral(":feeduid"), feeduid);
+            Database::instance().execute(query);
+
             // Delete Entries
             query.prepare(QStringLiteral("DELETE FROM Entries WHERE feeduid=:feeduid;"));
             query.bindValue(QStringLiteral(":feeduid"), feeduid);
@@ -321,7 +413,9 @@ void DataManager::addFeeds(const QStringList &urls, const bool fetch)
     }
 
     if (fetch) {
-        Fetcher::instance().fetch(newUrls);
+        // a single podcast that has just been added by the user should show
+        // up as soon as possible; bulk imports don't get that preference
+        Fetcher::instance().fetch(newUrls, newUrls.count() == 1 ? DataTypes::InteractiveFetch : DataTypes::NormalFetch);
     }
 
     // if settings allow, upload these changes immediately to sync servers
@@ -448,8 +542,10 @@ bool DataManager::feedExists(const QString &url)
     QString cleanedUrl = cleanUrl(url);
     QStringList urls;
 
+    // the urls of feeds that have moved permanently are still considered to
+    // be part of the subscriptions
     QSqlQuery query;
-    query.prepare(QStringLiteral("SELECT url FROM Feeds;"));
+    query.prepare(QStringLiteral("SELECT url FROM Feeds UNION SELECT oldUrl AS url FROM FeedRedirects;"));
     Database::instance().execute(query);
     while (query.next()) {
         urls += cleanUrl(query.value(QStringLiteral("url")).toString());
@@ -518,6 +614,156 @@ void DataManager::bulkMarkRead(bool state, const QList<qint64> &entryuids) const
     }
 }
 
+void DataManager::markFeedPlayed(const qint64 feeduid) const
+{
+    markPlayed(QStringLiteral("feeduid=%1").arg(feeduid));
+}
+
+void DataManager::markAllPlayed(const AbstractEpisodeProxyModel::FilterType filter) const
+{
+    QString condition;
+    switch (filter) {
+    case AbstractEpisodeProxyModel::ReadFilter:
+        return; // these entries have all been marked as played already
+    case AbstractEpisodeProxyModel::NewFilter:
+        condition = QStringLiteral("new=1");
+        break;
+    case AbstractEpisodeProxyModel::NotNewFilter:
+        condition = QStringLiteral("new=0");
+        break;
+    case AbstractEpisodeProxyModel::FavoriteFilter:
+        condition = QStringLiteral("favorite=1");
+        break;
+    case AbstractEpisodeProxyModel::NotFavoriteFilter:
+        condition = QStringLiteral("favorite=0");
+        break;
+    case AbstractEpisodeProxyModel::NoFilter:
+    case AbstractEpisodeProxyModel::NotReadFilter:
+    default:
+        condition = QStringLiteral("1");
+        break;
+    }
+    markPlayed(condition);
+}
+
+void DataManager::markPlayed(const QString &condition) const
+{
+    // This does the same as bulkMarkRead(true, ...), but the entries are
+    // selected and modified using a handful of set-based statements rather
+    // than row by row.  The unplayed entries matching the condition are
+    // collected in the temporary MarkPlayed table, which is then used by all
+    // follow-up actions, including the sync actions logged by
+    // Sync::storeMarkPlayedEpisodeActions.
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<qint64> entryuids, queuedEntryuids, feeduids, deletedEntryuids;
+    QStringList deletedPaths;
+    const bool resetPositions = SettingsManager::self()->resetPositionOnPlayed();
+    const bool deleteEnclosures = SettingsManager::self()->autoDeleteOnPlayed() == 1;
+
+    QSqlQuery query;
+    auto execute = [&query](const QString &statement) {
+        query.prepare(statement);
+        return Database::instance().execute(query);
+    };
+
+    Database::instance().transaction();
+    execute(QStringLiteral("DROP TABLE IF EXISTS temp.MarkPlayed;"));
+    execute(QStringLiteral("CREATE TEMP TABLE MarkPlayed (entryuid INTEGER PRIMARY KEY, feeduid INTEGER);"));
+    execute(QStringLiteral("INSERT INTO temp.MarkPlayed (entryuid, feeduid) SELECT entryuid, feeduid FROM Entries WHERE read=0 AND (%1);").arg(condition));
+
+    execute(QStringLiteral("SELECT entryuid FROM temp.MarkPlayed;"));
+    while (query.next()) {
+        entryuids += query.value(0).toLongLong();
+    }
+    execute(QStringLiteral("SELECT DISTINCT feeduid FROM temp.MarkPlayed;"));
+    while (query.next()) {
+        feeduids += query.value(0).toLongLong();
+    }
+    execute(QStringLiteral("SELECT entryuid FROM Queue WHERE entryuid IN (SELECT entryuid FROM temp.MarkPlayed);"));
+    while (query.next()) {
+        queuedEntryuids += query.value(0).toLongLong();
+    }
+    if (deleteEnclosures) {
+        query.prepare(
+            QStringLiteral("SELECT Enclosures.entryuid, Entries.title, Enclosures.url, Feeds.dirname FROM Enclosures "
+                           "JOIN Entries ON Entries.entryuid = Enclosures.entryuid JOIN Feeds ON Feeds.feeduid = Entries.feeduid "
+                           "WHERE (downloaded=:downloaded OR downloaded=:partiallydownloaded) "
+                           "AND Enclosures.entryuid IN (SELECT entryuid FROM temp.MarkPlayed);"));
+        query.bindValue(QStringLiteral(":downloaded"), Enclosure::statusToDb(Enclosure::Downloaded));
+        query.bindValue(QStringLiteral(":partiallydownloaded"), Enclosure::statusToDb(Enclosure::PartiallyDownloaded));
+        Database::instance().execute(query);
+        while (query.next()) {
+            deletedEntryuids += query.value(0).toLongLong();
+            deletedPaths +=
+                StorageManager::instance().enclosurePath(query.value(1).toString(), query.value(2).toString(), query.value(3).toString());
+        }
+    }
+
+    // The sync actions are logged before the play positions are reset, such
+    // that only the positions that actually change are logged
+    Sync::instance().storeMarkPlayedEpisodeActions(resetPositions);
+
+    // Marking as played also removes the "new" label (this is normally done
+    // as a side-effect of removing the entry from the queue)
+    execute(QStringLiteral("UPDATE Entries SET read=1, new=0 WHERE entryuid IN (SELECT entryuid FROM temp.MarkPlayed);"));
+    execute(QStringLiteral("DELETE FROM Queue WHERE entryuid IN (SELECT entryuid FROM temp.MarkPlayed);"));
+    if (resetPositions) {
+        execute(QStringLiteral("UPDATE Enclosures SET playposition=0 WHERE entryuid IN (SELECT entryuid FROM temp.MarkPlayed);"));
+    }
+    if (deleteEnclosures) {
+        query.prepare(
+            QStringLiteral("UPDATE Enclosures SET downloaded=:downloadable WHERE (downloaded=:downloaded OR downloaded=:partiallydownloaded) AND entryuid IN "
+                           "(SELECT entryuid FROM temp.MarkPlayed);"));
+        query.bindValue(QStringLiteral(":downloadable"), Enclosure::statusToDb(Enclosure::Downloadable));
+        query.bindValue(QStringLiteral(":downloaded"), Enclosure::statusToDb(Enclosure::Downloaded));
+        query.bindValue(QStringLiteral(":partiallydownloaded"), Enclosure::statusToDb(Enclosure::PartiallyDownloaded));
+        Database::instance().execute(query);
+    }
+    execute(QStringLiteral("DROP TABLE temp.MarkPlayed;"));
+    query.finish();
+    Database::instance().commit();
+
+    qCDebug(kastsDataManager) << "Marked" << entryuids.count() << "entries as played in" << timer.elapsed() << "ms";
+
+    if (entryuids.isEmpty()) {
+        return;
+    }
+
+    // The queue and the instantiated objects are only informed about the
+    // entries that are actually affected, with one signal per type of change
+    if (!queuedEntryuids.isEmpty()) {
+        QueueModel::instance().removedFromQueue(queuedEntryuids);
+        Q_EMIT entryQueueStatusChanged(false, queuedEntryuids);
+    }
+    Q_EMIT entryReadStatusChanged(true, entryuids);
+    Q_EMIT entryNewStatusChanged(false, entryuids);
+    if (resetPositions) {
+        Q_EMIT entryPlayPositionsChanged(QList<qint64>(entryuids.count(), 0), entryuids);
+    }
+    for (const qint64 feeduid : std::as_const(feeduids)) {
+        Q_EMIT unreadEntryCountChanged(feeduid);
+        Q_EMIT newEntryCountChanged(feeduid);
+    }
+
+    if (!deletedEntryuids.isEmpty()) {
+        // like Enclosure::deleteFile, a track that is still playing is
+        // unloaded before its file is removed
+        if (deletedEntryuids.contains(AudioManager::instance().entryuid())) {
+            AudioManager::instance().setEntryuid(0);
+        }
+        for (const QString &path : std::as_const(deletedPaths)) {
+            QFile::remove(path);
+            EnclosureDownloadJob::removePartialDownload(path);
+        }
+        Q_EMIT enclosureStatusesChanged(QList<Enclosure::Status>(deletedEntryuids.count(), Enclosure::Downloadable), deletedEntryuids);
+    }
+
+    // if settings allow, upload these changes immediately to sync servers
+    Sync::instance().doQuickSync();
+}
+
 void DataManager::bulkMarkNewByIndex(bool state, const QModelIndexList &list) const
 {
     bulkMarkNew(state, getEntryuidsFromModelIndexList(list));
@@ -618,10 +864,66 @@ void DataManager::bulkDownloadEnclosures(const QList<qint64> &entryuids) const
 {
     // TODO: move away from instantiation of entries
     bulkQueueStatus(true, entryuids);
+    const bool bulk = (entryuids.count() > 1);
+    if (bulk) {
+        prefetchEntries(entryuids);
+        Fetcher::instance().preloadDownloadValidators(entryuids);
+    }
     for (const qint64 &entryuid : std::as_const(entryuids)) {
-        if (getEntry(entryuid)->hasEnclosure()) {
-            getEntry(entryuid)->enclosure()->download();
+        Entry *entry = getEntry(entryuid);
+        if (entry && entry->hasEnclosure()) {
+            entry->enclosure()->download(bulk);
+        }
+    }
+}
+
+void DataManager::resumeEnclosureDownloads() const
+{
+    // the validators of the earlier attempts are loaded along with the
+    // queue, and downloads of enclosures that no longer exist or that have
+    // been downloaded in the meantime are dropped without loading the entry
+    QList<qint64> entryuids, obsoleteEntryuids;
+    QList<int> priorities;
+    QHash<qint64, Fetcher::DownloadValidators> validators;
+    QSqlQuery query;
+    query.prepare(
+        QStringLiteral("SELECT DownloadQueue.entryuid, DownloadQueue.priority, DownloadQueue.etag, DownloadQueue.lastModified, Enclosures.downloaded "
+                       "FROM DownloadQueue LEFT JOIN Enclosures ON Enclosures.entryuid=DownloadQueue.entryuid "
+                       "ORDER BY DownloadQueue.state=:running DESC, DownloadQueue.priority DESC, DownloadQueue.queued ASC;"));
+    query.bindValue(QStringLiteral(":running"), DataTypes::DownloadRunning);
+    Database::instance().execute(query);
+    while (query.next()) {
+        const qint64 entryuid = query.value(QStringLiteral("entryuid")).toLongLong();
+        if (validators.contains(entryuid) || obsoleteEntryuids.contains(entryuid)) {
+            continue; // only the first enclosure of an entry is used
+        }
+        const QVariant downloaded = query.value(QStringLiteral("downloaded"));
+        if (downloaded.isNull() || Enclosure::dbToStatus(downloaded.toInt()) == Enclosure::Downloaded) {
+            obsoleteEntryuids += entryuid;
+            continue;
         }
+        entryuids += entryuid;
+        priorities += query.value(QStringLiteral("priority")).toInt();
+        validators[entryuid] = Fetcher::DownloadValidators{.etag = query.value(QStringLiteral("etag")).toString(),
+                                                           .lastModified = query.value(QStringLiteral("lastModified")).toString()};
+    }
+    query.finish();
+
+    qCDebug(kastsDataManager) << "Resuming downloads:" << entryuids;
+
+    for (const qint64 entryuid : std::as_const(obsoleteEntryuids)) {
+        Fetcher::instance().removeQueuedDownload(entryuid);
+    }
+
+    prefetchEntries(entryuids);
+    Fetcher::instance().preloadDownloadValidators(validators);
+    for (int i = 0; i < entryuids.count(); ++i) {
+        Entry *entry = getEntry(entryuids[i]);
+        if (!entry || !entry->hasEnclosure()) {
+            Fetcher::instance().removeQueuedDownload(entryuids[i]);
+            continue;
+        }
+        entry->enclosure()->download(priorities[i] == DownloadRateLimiter::Bulk);
     }
 }
 
@@ -743,6 +1045,41 @@ QString DataManager::cleanUrl(const QString &url)
         + (QUrl(url).hasQuery() ? QStringLiteral("?") + QUrl(url).query(QUrl::FullyDecoded) : QString());
 }
 
+void DataManager::scheduleChangeNotification()
+{
+    // The window starts at the first buffered change and is not extended by
+    // subsequent ones, such that a steady stream of updates still reaches the
+    // GUI at regular intervals.  An interval of 0 flushes on the next
+    // iteration of the event loop.
+    if (!m_changeNotificationTimer.isActive()) {
+        m_changeNotificationTimer.start(std::max(0, SettingsManager::self()->changeNotificationInterval()));
+    }
+}
+
+void DataManager::flushChangeNotifications()
+{
+    const QHash<qint64, QSet<qint64>> addedEntries = std::exchange(m_pendingAddedEntries, {});
+    const QHash<qint64, QSet<qint64>> updatedEntries = std::exchange(m_pendingUpdatedEntries, {});
+    const QSet<qint64> updatedFeeds = std::exchange(m_pendingUpdatedFeeds, {});
+
+    for (auto it = addedEntries.cbegin(); it != addedEntries.cend(); ++it) {
+        qCDebug(kastsDataManager) << "Batched addition of" << it.value().count() << "entries to feed" << it.key();
+        Q_EMIT entriesAdded(it.key(), it.value());
+    }
+
+    for (auto it = updatedEntries.cbegin(); it != updatedEntries.cend(); ++it) {
+        qCDebug(kastsDataManager) << "Batched update of" << it.value().count() << "entries for feed" << it.key();
+        Q_EMIT entriesUpdated(it.key(), it.value());
+    }
+
+    for (const qint64 feeduid : updatedFeeds) {
+        Q_EMIT feedEntriesUpdated(feeduid);
+    }
+    if (!updatedFeeds.isEmpty()) {
+        Q_EMIT feedsEntriesUpdated(updatedFeeds.values());
+    }
+}
+
 qint64 DataManager::getEntryuidFromId(const QString &id) const
 {
     QSqlQuery query;
@@ -869,6 +1206,14 @@ qint64 DataManager::getFeeduidFromUrl(const QString &url) const
     query.prepare(QStringLiteral("SELECT feeduid FROM Feeds WHERE url=:url;"));
     query.bindValue(QStringLiteral(":url"), url);
     Database::instance().execute(query);
+    if (query.next()) {
+        return query.value(QStringLiteral("feeduid")).toLongLong();
+    }
+
+    // fall back to the old urls of feeds that have moved permanently
+    query.prepare(QStringLiteral("SELECT feeduid FROM FeedRedirects WHERE oldUrl=:url ORDER BY timestamp DESC;"));
+    query.bindValue(QStringLiteral(":url"), url);
+    Database::instance().execute(query);
     if (!query.next()) {
         return 0;
     }
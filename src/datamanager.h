@@ -10,8 +10,10 @@
 #include <QObject>
 #include <QPointer>
 #include <QQmlEngine>
+#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QTimer>
 #include <QtQml/qqmlregistration.h>
 
 #include "entry.h"
@@ -37,6 +39,10 @@ public:
 
     Q_INVOKABLE Feed *getFeed(const qint64 feeduid) const;
     Q_INVOKABLE Entry *getEntry(const qint64 entryuid) const;
+    // instantiate all entries in the list that have not been loaded yet using
+    // a fixed number of queries; meant to be called with the rows that are
+    // about to become visible in a view
+    void prefetchEntries(const QList<qint64> &entryuids) const;
 
     // TODO: to be removed
     Q_INVOKABLE Feed *getFeed(const QString &feedurl) const;
@@ -58,6 +64,9 @@ public:
     Q_INVOKABLE void setLastPlayingEntry(const qint64 entryuid);
 
     Q_INVOKABLE void deletePlayedEnclosures();
+    // restarts the downloads that were still queued or running (or got
+    // interrupted) when Kasts was last closed
+    Q_INVOKABLE void resumeEnclosureDownloads() const;
 
     Q_INVOKABLE void importFeeds(const QString &path);
     Q_INVOKABLE void exportFeeds(const QString &path);
@@ -74,6 +83,10 @@ public:
     Q_INVOKABLE void bulkSetEnclosureSizes(const QList<qint64> &sizes, const QList<qint64> &entryuids) const;
     Q_INVOKABLE void bulkSetEnclosureStatuses(const QList<Enclosure::Status> &statuses, const QList<qint64> &entryuids) const;
 
+    // set-based variants of bulkMarkRead(true, ...) for very large selections
+    Q_INVOKABLE void markFeedPlayed(const qint64 feeduid) const;
+    Q_INVOKABLE void markAllPlayed(const AbstractEpisodeProxyModel::FilterType filter = AbstractEpisodeProxyModel::NoFilter) const;
+
     Q_INVOKABLE void bulkMarkReadByIndex(bool state, const QModelIndexList &list) const;
     Q_INVOKABLE void bulkMarkNewByIndex(bool state, const QModelIndexList &list) const;
     Q_INVOKABLE void bulkMarkFavoriteByIndex(bool state, const QModelIndexList &list) const;
@@ -85,6 +98,13 @@ Q_SIGNALS:
     void feedAdded(const qint64 feeduid);
     void feedRemoved(const qint64 feeduid);
     void feedEntriesUpdated(const qint64 feeduid);
+    // emitted once per batch of coalesced feed updates, after the individual
+    // feedEntriesUpdated signals; meant for models spanning several feeds
+    void feedsEntriesUpdated(const QList<qint64> &feeduids);
+    // the entries that have been added to or updated in a feed since the
+    // previous batch
+    void entriesAdded(const qint64 feeduid, const QSet<qint64> &entryuids);
+    void entriesUpdated(const qint64 feeduid, const QSet<qint64> &entryuids);
 
     void entryReadStatusChanged(bool state, const QList<qint64> &entryuids) const;
     void entryNewStatusChanged(bool state, const QList<qint64> &entryuids) const;
@@ -110,8 +130,20 @@ private:
 
     QString cleanUrl(const QString &url);
 
+    void scheduleChangeNotification();
+    void flushChangeNotifications();
+
     QList<qint64> getEntryuidsFromModelIndexList(const QModelIndexList &list) const;
 
+    void markPlayed(const QString &condition) const;
+
     mutable QHash<qint64, QPointer<Feed>> m_feeds; // hash of pointers to all feeds in db, key = feeduid (lazy loading)
     mutable QHash<qint64, QPointer<Entry>> m_entries; // hash of pointers to all entries in db, key = entryuid (lazy loading)
+
+    // changes reported by the feed updater are buffered here and emitted as
+    // one batch per feed when m_changeNotificationTimer fires
+    QHash<qint64, QSet<qint64>> m_pendingAddedEntries; // key = feeduid
+    QHash<qint64, QSet<qint64>> m_pendingUpdatedEntries; // key = feeduid
+    QSet<qint64> m_pendingUpdatedFeeds;
+    QTimer m_changeNotificationTimer;
 };
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <QDateTime>
+#include <QFlags>
 #include <QMetaType>
 #include <QQmlEngine>
 #include <QString>
@@ -26,17 +28,65 @@ enum RecordState {
 };
 Q_ENUM_NS(RecordState)
 
+enum FeedDownloadStatus {
+    DownloadFailed = 0,
+    NotModified,
+    Downloaded,
+};
+Q_ENUM_NS(FeedDownloadStatus)
+
+enum FeedUpdateOutcome {
+    UpdateFailed = 0, // feed could not be downloaded
+    UpdateNotModified, // server reported that the feed has not been modified
+    UpdateUnchanged, // feed has been downloaded, but has not changed
+    UpdateParseFailed, // feed has been downloaded, but could not be parsed
+    UpdateProcessed,
+};
+Q_ENUM_NS(FeedUpdateOutcome)
+
+enum FetchPriority {
+    InteractiveFetch = 0, // explicitly requested by the user
+    NormalFetch,
+    BackgroundFetch, // automatic updates
+};
+Q_ENUM_NS(FetchPriority)
+
+enum DownloadQueueState {
+    DownloadQueued = 0,
+    DownloadRunning,
+    DownloadInterrupted, // stopped by a network error; resumed on the next start
+};
+Q_ENUM_NS(DownloadQueueState)
+
 // structs
+// Rather than keeping a copy of the values that are stored in the database,
+// the structs below only record which fields have been changed.  The
+// changedFields flags are only meaningful in case state == Modified, with one
+// exception: EntryDetails::ContentHash is also set for Unmodified entries,
+// whose stored hash can be outdated even though none of their fields
+// changed.  FeedDatabaseWriter stores the contentHash of any entry that is
+// neither New nor Deleted as long as that flag is set.
 struct AuthorDetails {
+    enum Field {
+        Email = 1 << 0,
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+
     QString name;
     QString email;
     RecordState state;
-
-    // Fields that are only used in case state == Modified
-    QString oldEmail;
+    Fields changedFields;
 };
 
 struct EnclosureDetails {
+    enum Field {
+        Duration = 1 << 0,
+        Size = 1 << 1,
+        Type = 1 << 2,
+        Url = 1 << 3,
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+
     qint64 enclosureuid;
     int duration;
     int size;
@@ -45,28 +95,39 @@ struct EnclosureDetails {
     int playPosition;
     Enclosure::Status downloaded;
     RecordState state;
-
-    // Fields that are only used in case state == Modified
-    int oldDuration;
-    int oldSize;
-    QString oldType;
-    QString oldUrl;
+    Fields changedFields;
 };
 
 struct ChapterDetails {
+    enum Field {
+        Title = 1 << 0,
+        Link = 1 << 1,
+        Image = 1 << 2,
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+
     int start;
     QString title;
     QString link;
     QString image;
     RecordState state;
-
-    // Fields that are only used in case state == Modified
-    QString oldTitle;
-    QString oldLink;
-    QString oldImage;
+    Fields changedFields;
 };
 
 struct EntryDetails {
+    enum Field {
+        Title = 1 << 0,
+        Content = 1 << 1,
+        Created = 1 << 2,
+        Updated = 1 << 3,
+        Link = 1 << 4,
+        Removed = 1 << 5,
+        HasEnclosure = 1 << 6,
+        Image = 1 << 7,
+        ContentHash = 1 << 8,
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+
     qint64 entryuid;
     qint64 feeduid;
     QString id;
@@ -81,25 +142,29 @@ struct EntryDetails {
     bool removed;
     bool hasEnclosure;
     QString image;
+    QString contentHash; // hash of the item in the feed from which this entry was last updated
     QHash<QString, AuthorDetails> authors; // key = author name
     QHash<QString, EnclosureDetails> enclosures; // key = enclosure url
     QHash<int, ChapterDetails> chapters; // key = start
     RecordState state;
-
-    // Fields that are only used in case state == Modified
-    QString oldTitle;
-    QString oldContent;
-    int oldCreated;
-    int oldUpdated;
-    QString oldLink;
-    bool oldRemoved;
-    bool oldHasEnclosure; // TODO: probably don't need this since there is the enclosure QHash anyway
-    QString oldImage;
+    Fields changedFields;
 };
 
 struct FeedDetails {
     QML_VALUE_TYPE(feedDetails) // needed to expose this type to qml
 
+    enum Field {
+        Name = 1 << 0,
+        Url = 1 << 1,
+        Image = 1 << 2,
+        Link = 1 << 3,
+        Description = 1 << 4,
+        LastUpdated = 1 << 5,
+        Dirname = 1 << 6,
+        LastHash = 1 << 7,
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+
     qint64 feeduid;
     QString name;
     QString url;
@@ -111,20 +176,84 @@ struct FeedDetails {
     bool isNew;
     QString dirname;
     QString lastHash;
+    QString etag;
+    QString lastModified;
+    qint64 lastSize = 0;
+    int failureCount = 0;
+    bool paused = false;
     int filterType = 0;
     int sortType = 0;
     QHash<QString, AuthorDetails> authors; // key = author name
     QHash<QString, EntryDetails> entries; // key = id from feed
     RecordState state;
+    Fields changedFields;
+};
+
+// timing and size metrics of a single feed update; all times are in
+// milliseconds
+struct FeedStats {
+    FeedUpdateOutcome outcome = UpdateFailed;
+    qint64 lookupTime = 0; // host lookup, including waiting for a free connection
+    qint64 connectTime = 0; // zero if an existing connection has been reused
+    qint64 firstByteTime = 0;
+    qint64 downloadTime = 0;
+    qint64 bytes = 0;
+    qint64 parseTime = 0;
+    qint64 processTime = 0;
+    qint64 writeTime = 0;
+    int items = 0;
+    int processedItems = 0;
+    int skippedItems = 0;
+};
+
+// changes to a feed that have to be written to the database, handed from
+// the thread processing the feed to the FeedDatabaseWriter
+struct FeedWrite {
+    qint64 feeduid = 0;
+    FeedDetails feed;
+    bool processed = false; // false if the feed has not been processed and only nextUpdate and validators have to be written
+    bool validatorsChanged = false;
+    bool feedDetailsChanged = false;
+    bool entriesChanged = false;
+    QDateTime lastUpdated;
+    qint64 nextUpdate = 0; // 0 means that nextUpdate should not be changed
+    FeedStats stats;
+
+    // consecutive update failures; only written if failureStateChanged is set
+    bool failureStateChanged = false;
+    int failureCount = 0;
+    qint64 retryAfter = 0; // no updates before this time (seconds since epoch)
+    bool paused = false;
 
-    // Fields that are only used in case state == Modified
-    QString oldName;
-    QString oldUrl;
-    QString oldImage;
-    QString oldLink;
-    QString oldDescription;
-    int oldLastUpdated;
-    QString oldDirname;
-    QString oldLastHash;
+    // target of permanent redirects; if set, the stored feed url is replaced
+    // by it and the old url is kept in FeedRedirects
+    QString redirectedUrl;
+};
+
+// result of downloading a feed, handed from the network thread to the
+// thread that parses and processes the feed
+struct FeedDownload {
+    qint64 feeduid = 0;
+    FeedDownloadStatus status = DownloadFailed;
+    QString fileName; // file containing the feed; to be removed by the receiver
+    QString hash;
+    QString etag;
+    QString lastModified;
+    qint64 size = 0;
+    int httpStatus = 0;
+    int networkError = 0; // QNetworkReply::NetworkError of the final request
+    bool writeError = false; // the feed could not be stored locally
+    qint64 retryAfter = 0; // value of the Retry-After header in seconds since epoch; 0 if not set
+    bool connectionReused = false; // an existing connection to the server has been reused
+    bool tlsHandshake = false; // a new TLS session had to be set up
+    bool http2 = false;
+    QString redirectedUrl; // final url if only permanent redirects (301/308) have been followed
+    FeedStats stats; // only the network related metrics are filled in
 };
 }
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(DataTypes::AuthorDetails::Fields)
+Q_DECLARE_OPERATORS_FOR_FLAGS(DataTypes::EnclosureDetails::Fields)
+Q_DECLARE_OPERATORS_FOR_FLAGS(DataTypes::ChapterDetails::Fields)
+Q_DECLARE_OPERATORS_FOR_FLAGS(DataTypes::EntryDetails::Fields)
+Q_DECLARE_OPERATORS_FOR_FLAGS(DataTypes::FeedDetails::Fields)
@@ -37,15 +37,15 @@
 #include "utils/networkconnectionmanager.h"
 #include "utils/storagemanager.h"
 
-Enclosure::Enclosure(Entry *entry)
+Enclosure::Enclosure(Entry *entry, const QSqlRecord &enclosureRecord)
     : QObject(entry)
     , m_entry(entry)
 {
     connect(this, &Enclosure::playPositionChanged, this, &Enclosure::leftDurationChanged);
     connect(this, &Enclosure::statusChanged, &DownloadModel::instance(), &DownloadModel::monitorDownloadStatus);
     connect(this, &Enclosure::downloadError, &ErrorLogModel::instance(), &ErrorLogModel::monitorErrorMessages);
-    connect(&Fetcher::instance(), &Fetcher::entryUpdated, this, [this](const qint64 entryuid) {
-        if (m_entry->entryuid() == entryuid) {
+    connect(&DataManager::instance(), &DataManager::entriesUpdated, this, [this](const qint64, const QSet<qint64> &entryuids) {
+        if (entryuids.contains(m_entryuid)) {
             updateFromDb();
         }
     });
@@ -81,6 +81,12 @@ Enclosure::Enclosure(Entry *entry)
             m_status = statuses[index];
             m_downloadProgress = 0;
             m_downloadSize = 0;
+            // the file may have been removed without going through deleteFile,
+            // see DataManager::markPlayed
+            if (m_status == Downloadable && m_sizeOnDisk != 0) {
+                m_sizeOnDisk = 0;
+                Q_EMIT sizeOnDiskChanged();
+            }
             Q_EMIT statusChanged(m_entry, m_status);
         }
     });
@@ -93,25 +99,31 @@ Enclosure::Enclosure(Entry *entry)
         }
     });
 
-    // TODO: this will just take the first enclosure found; we should handle
-    // multiple ones
-    QSqlQuery query;
-    query.prepare(QStringLiteral("SELECT * FROM Enclosures WHERE entryuid=:entryuid"));
-    query.bindValue(QStringLiteral(":entryuid"), entry->entryuid());
-    Database::instance().execute(query);
-
-    if (!query.next()) {
-        return;
+    // Use the record if it has already been retrieved from the database
+    // (see DataManager::prefetchEntries); otherwise look it up ourselves
+    QSqlRecord record = enclosureRecord;
+    if (record.isEmpty()) {
+        // TODO: this will just take the first enclosure found; we should handle
+        // multiple ones
+        QSqlQuery enclosureQuery;
+        enclosureQuery.prepare(QStringLiteral("SELECT * FROM Enclosures WHERE entryuid=:entryuid"));
+        enclosureQuery.bindValue(QStringLiteral(":entryuid"), entry->entryuid());
+        Database::instance().execute(enclosureQuery);
+
+        if (!enclosureQuery.next()) {
+            return;
+        }
+        record = enclosureQuery.record();
     }
 
-    m_entryuid = query.value(QStringLiteral("entryuid")).toLongLong();
-    m_enclosureuid = query.value(QStringLiteral("enclosureuid")).toLongLong();
-    m_duration = query.value(QStringLiteral("duration")).toInt();
-    m_size = query.value(QStringLiteral("size")).toInt();
-    m_type = query.value(QStringLiteral("type")).toString();
-    m_url = query.value(QStringLiteral("url")).toString();
-    m_playposition = query.value(QStringLiteral("playposition")).toLongLong();
-    m_status = dbToStatus(query.value(QStringLiteral("downloaded")).toInt());
+    m_entryuid = record.value(QStringLiteral("entryuid")).toLongLong();
+    m_enclosureuid = record.value(QStringLiteral("enclosureuid")).toLongLong();
+    m_duration = record.value(QStringLiteral("duration")).toInt();
+    m_size = record.value(QStringLiteral("size")).toInt();
+    m_type = record.value(QStringLiteral("type")).toString();
+    m_url = record.value(QStringLiteral("url")).toString();
+    m_playposition = record.value(QStringLiteral("playposition")).toLongLong();
+    m_status = dbToStatus(record.value(QStringLiteral("downloaded")).toInt());
     m_playposition_dbsave = m_playposition;
 
     // using qtimer to do this update after the constructor so the signals can be picked up correctly
@@ -176,7 +188,7 @@ Enclosure::Status Enclosure::dbToStatus(int value)
     return Enclosure::Status(value);
 }
 
-void Enclosure::download()
+void Enclosure::download(const bool bulk)
 {
     if (m_status == Downloaded) {
         return;
@@ -199,9 +211,12 @@ void Enclosure::download()
     }
 
     checkSizeOnDisk();
-    EnclosureDownloadJob *downloadJob = Fetcher::instance().enqueueEnclosureDownload(m_entryuid, m_url, path(), m_entry->title());
+    EnclosureDownloadJob *downloadJob = Fetcher::instance().enqueueEnclosureDownload(m_entryuid,
+                                                                                     m_url,
+                                                                                     path(),
+                                                                                     m_entry->title(),
+                                                                                     bulk ? DownloadRateLimiter::Bulk : DownloadRateLimiter::Normal);
 
-    qint64 resumedAt = m_sizeOnDisk;
     m_downloadProgress = 0;
     m_downloadSize = 0;
     Q_EMIT downloadProgressChanged();
@@ -214,12 +229,8 @@ void Enclosure::download()
         if (downloadJob->error() == 0) {
             processDownloadedFile();
         } else {
-            QFile file(path());
-            if (file.exists() && file.size() > 0) {
-                setStatus(PartiallyDownloaded);
-            } else {
-                setStatus(Downloadable);
-            }
+            // includes the data of an unfinished segmented download
+            setStatus(m_sizeOnDisk > 0 ? PartiallyDownloaded : Downloadable);
             if (downloadJob->error() != QNetworkReply::OperationCanceledError) {
                 m_entry->feed()->setErrorId(downloadJob->error());
                 m_entry->feed()->setErrorString(downloadJob->errorString());
@@ -238,29 +249,24 @@ void Enclosure::download()
     connect(this, &Enclosure::cancelDownload, this, [this, downloadJob]() {
         downloadJob->doKill();
         checkSizeOnDisk();
-        QFile file(path());
-        if (file.exists() && file.size() > 0) {
-            setStatus(PartiallyDownloaded);
-        } else {
-            setStatus(Downloadable);
-        }
+        setStatus(m_sizeOnDisk > 0 ? PartiallyDownloaded : Downloadable);
         disconnect(this, &Enclosure::cancelDownload, this, nullptr);
     });
 
-    connect(downloadJob, &KJob::processedAmountChanged, this, [this, resumedAt](KJob *kjob, KJob::Unit unit, qulonglong amount) {
+    // the job knows how much had already been downloaded before; this
+    // changes e.g. if the server sends the complete file instead of resuming
+    connect(downloadJob, &KJob::processedAmountChanged, this, [this, downloadJob](KJob *, KJob::Unit unit) {
         Q_ASSERT(unit == KJob::Unit::Bytes);
 
         setStatus(Status::Downloading);
 
-        qint64 totalSize = static_cast<qint64>(kjob->totalAmount(unit));
-        qint64 currentSize = static_cast<qint64>(amount);
-
-        if ((totalSize > 0) && (m_size != totalSize + resumedAt)) {
-            qCDebug(kastsEnclosure) << "Correct filesize for enclosure" << m_entry->title() << "from" << m_size << "to" << totalSize + resumedAt;
-            setSize(totalSize + resumedAt);
+        const qint64 totalSize = downloadJob->totalSize();
+        if ((totalSize > 0) && (m_size != totalSize)) {
+            qCDebug(kastsEnclosure) << "Correct filesize for enclosure" << m_entry->title() << "from" << m_size << "to" << totalSize;
+            setSize(totalSize);
         }
 
-        m_downloadSize = currentSize + resumedAt;
+        m_downloadSize = downloadJob->bytesDone();
         m_downloadProgress = static_cast<double>(m_downloadSize) / static_cast<double>(m_size);
         Q_EMIT downloadProgressChanged();
 
@@ -325,6 +331,7 @@ void Enclosure::deleteFile()
     if (QFile(path()).exists()) {
         QFile(path()).remove();
     }
+    EnclosureDownloadJob::removePartialDownload(path());
 
     // If file disappeared unexpectedly, then still change status to downloadable
     setStatus(Downloadable);
@@ -459,35 +466,31 @@ void Enclosure::checkSizeOnDisk()
     // In principle the database contains this status, we check anyway in case
     // something changed on disk
     QFile file(path());
-    if (file.exists()) {
-        if (file.size() == m_size && file.size() > 0) {
+    qint64 sizeOnDisk = 0;
+    if (file.exists() && file.size() > 0) {
+        sizeOnDisk = file.size();
+        if (sizeOnDisk == m_size) {
             // file is on disk and has correct size, write to database if it
             // wasn't already registered so
             // this should, in principle, never happen unless the db was deleted
             setStatus(Downloaded);
-        } else if (file.size() > 0) {
+        } else {
             // file was downloaded, but there is a size mismatch
             // set to PartiallyDownloaded such that download can be resumed
             setStatus(PartiallyDownloaded);
-        } else {
-            // file is empty
-            setStatus(Downloadable);
-        }
-        if (file.size() != m_sizeOnDisk) {
-            m_sizeOnDisk = file.size();
-            m_downloadSize = m_sizeOnDisk;
-            m_downloadProgress = (m_size == 0) ? 0.0 : static_cast<double>(m_sizeOnDisk) / static_cast<double>(m_size);
-            Q_EMIT sizeOnDiskChanged();
         }
     } else {
-        // file does not exist
-        setStatus(Downloadable);
-        if (m_sizeOnDisk != 0) {
-            m_sizeOnDisk = 0;
-            m_downloadSize = 0;
-            m_downloadProgress = 0.0;
-            Q_EMIT sizeOnDiskChanged();
-        }
+        // an unfinished segmented download is kept in a separate part file
+        // until it's complete
+        sizeOnDisk = EnclosureDownloadJob::partialDownloadSize(path());
+        setStatus(sizeOnDisk > 0 ? PartiallyDownloaded : Downloadable);
+    }
+
+    if (sizeOnDisk != m_sizeOnDisk) {
+        m_sizeOnDisk = sizeOnDisk;
+        m_downloadSize = m_sizeOnDisk;
+        m_downloadProgress = (m_size == 0) ? 0.0 : static_cast<double>(m_sizeOnDisk) / static_cast<double>(m_size);
+        Q_EMIT sizeOnDiskChanged();
     }
 }
 
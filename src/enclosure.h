@@ -10,6 +10,7 @@
 #include <QDebug>
 #include <QObject>
 #include <QQmlEngine>
+#include <QSqlRecord>
 #include <QString>
 
 #include <KFormat>
@@ -42,7 +43,7 @@ class Enclosure : public QObject
     Q_PROPERTY(QString formattedDuration READ formattedDuration NOTIFY durationChanged)
 
 public:
-    Enclosure(Entry *entry);
+    Enclosure(Entry *entry, const QSqlRecord &enclosureRecord = QSqlRecord());
     ~Enclosure();
 
     enum Status {
@@ -58,7 +59,7 @@ public:
     static int statusToDb(Status status); // needed to translate Enclosure::Status values to int for sqlite
     static Status dbToStatus(int value); // needed to translate from int to Enclosure::Status values for sqlite
 
-    Q_INVOKABLE void download();
+    Q_INVOKABLE void download(const bool bulk = false);
     Q_INVOKABLE void deleteFile();
 
     qint64 enclosureuid() const;
@@ -17,15 +17,19 @@
 #include "database.h"
 #include "datamanager.h"
 #include "feed.h"
-#include "fetcher.h"
 #include "objectslogging.h"
 #include "queuemodel.h"
 
 Entry::Entry(const qint64 entryuid, QObject *parent)
+    : Entry(entryuid, QSqlRecord(), QStringList(), QSqlRecord())
+{
+    Q_UNUSED(parent)
+}
+
+Entry::Entry(const qint64 entryuid, const QSqlRecord &entryRecord, const QStringList &authors, const QSqlRecord &enclosureRecord)
     : QObject(&DataManager::instance()) // TODO: remove explicit parenting after refactor
     , m_entryuid(entryuid)
 {
-    Q_UNUSED(parent)
 
     qCDebug(kastsObjects) << "Entry object" << m_entryuid << "constructed";
 
@@ -52,13 +56,18 @@ Entry::Entry(const qint64 entryuid, QObject *parent)
             Q_EMIT queueStatusChanged(state);
         }
     });
-    connect(&Fetcher::instance(), &Fetcher::entryUpdated, this, [this](const qint64 entryuid) {
-        if (m_entryuid == entryuid) {
+    connect(&DataManager::instance(), &DataManager::entriesUpdated, this, [this](const qint64 feeduid, const QSet<qint64> &entryuids) {
+        if (feeduid == m_feeduid && entryuids.contains(m_entryuid)) {
             updateFromDb();
         }
     });
 
-    updateFromDb(false);
+    if (entryRecord.isEmpty()) {
+        updateFromDb(false);
+    } else {
+        updateFromRecord(entryRecord, enclosureRecord, false);
+        setAuthors(authors);
+    }
 }
 
 void Entry::updateFromDb(bool emitSignals)
@@ -72,40 +81,44 @@ void Entry::updateFromDb(bool emitSignals)
         return;
     }
 
-    m_feeduid = entryQuery.value(QStringLiteral("feeduid")).toLongLong();
+    updateFromRecord(entryQuery.record(), QSqlRecord(), emitSignals);
+    updateAuthors();
+}
+
+void Entry::updateFromRecord(const QSqlRecord &entryRecord, const QSqlRecord &enclosureRecord, bool emitSignals)
+{
+    m_feeduid = entryRecord.value(QStringLiteral("feeduid")).toLongLong();
     // TODO: can we get rid of the feed pointer?
     if (m_feed == nullptr) {
         m_feed = DataManager::instance().getFeed(m_feeduid);
     }
 
-    m_id = entryQuery.value(QStringLiteral("id")).toString();
-    setCreated(QDateTime::fromSecsSinceEpoch(entryQuery.value(QStringLiteral("created")).toInt()), emitSignals);
-    setUpdated(QDateTime::fromSecsSinceEpoch(entryQuery.value(QStringLiteral("updated")).toInt()), emitSignals);
-    setTitle(entryQuery.value(QStringLiteral("title")).toString(), emitSignals);
-    setContent(entryQuery.value(QStringLiteral("content")).toString(), emitSignals);
-    setLink(entryQuery.value(QStringLiteral("link")).toString(), emitSignals);
+    m_id = entryRecord.value(QStringLiteral("id")).toString();
+    setCreated(QDateTime::fromSecsSinceEpoch(entryRecord.value(QStringLiteral("created")).toInt()), emitSignals);
+    setUpdated(QDateTime::fromSecsSinceEpoch(entryRecord.value(QStringLiteral("updated")).toInt()), emitSignals);
+    setTitle(entryRecord.value(QStringLiteral("title")).toString(), emitSignals);
+    setContent(entryRecord.value(QStringLiteral("content")).toString(), emitSignals);
+    setLink(entryRecord.value(QStringLiteral("link")).toString(), emitSignals);
 
-    if (m_read != entryQuery.value(QStringLiteral("read")).toBool()) {
-        m_read = entryQuery.value(QStringLiteral("read")).toBool();
+    if (m_read != entryRecord.value(QStringLiteral("read")).toBool()) {
+        m_read = entryRecord.value(QStringLiteral("read")).toBool();
         Q_EMIT readChanged(m_read);
     }
-    if (m_new != entryQuery.value(QStringLiteral("new")).toBool()) {
-        m_new = entryQuery.value(QStringLiteral("new")).toBool();
+    if (m_new != entryRecord.value(QStringLiteral("new")).toBool()) {
+        m_new = entryRecord.value(QStringLiteral("new")).toBool();
         Q_EMIT newChanged(m_new);
     }
-    if (m_favorite != entryQuery.value(QStringLiteral("favorite")).toBool()) {
-        m_favorite = entryQuery.value(QStringLiteral("favorite")).toBool();
+    if (m_favorite != entryRecord.value(QStringLiteral("favorite")).toBool()) {
+        m_favorite = entryRecord.value(QStringLiteral("favorite")).toBool();
         Q_EMIT favoriteChanged(m_favorite);
     }
-    if (m_removed != entryQuery.value(QStringLiteral("removed")).toBool()) {
-        m_removed = entryQuery.value(QStringLiteral("removed")).toBool();
+    if (m_removed != entryRecord.value(QStringLiteral("removed")).toBool()) {
+        m_removed = entryRecord.value(QStringLiteral("removed")).toBool();
         Q_EMIT removedChanged(m_removed);
     }
 
-    setHasEnclosure(entryQuery.value(QStringLiteral("hasEnclosure")).toBool(), emitSignals);
-    setImage(entryQuery.value(QStringLiteral("image")).toString(), emitSignals);
-
-    updateAuthors();
+    setHasEnclosure(entryRecord.value(QStringLiteral("hasEnclosure")).toBool(), emitSignals, enclosureRecord);
+    setImage(entryRecord.value(QStringLiteral("image")).toString(), emitSignals);
 }
 
 Entry::~Entry()
@@ -125,13 +138,17 @@ void Entry::updateAuthors()
         authors += authorQuery.value(QStringLiteral("name")).toString();
     }
 
+    setAuthors(authors);
+}
+
+void Entry::setAuthors(const QStringList &authors)
+{
     if (authors.size() == 1) {
         m_authors = authors[0];
     } else if (authors.size() == 2) {
         m_authors = i18nc("<name> and <name>", "%1 and %2", authors.first(), authors.last());
     } else if (authors.size() > 2) {
-        auto last = authors.takeLast();
-        m_authors = i18nc("<name(s)>, and <name>", "%1, and %2", authors.join(u','), last);
+        m_authors = i18nc("<name(s)>, and <name>", "%1, and %2", authors.first(authors.size() - 1).join(u','), authors.last());
     }
     Q_EMIT authorsChanged(m_authors);
 }
@@ -257,14 +274,14 @@ void Entry::setLink(const QString &link, bool emitSignal)
     }
 }
 
-void Entry::setHasEnclosure(bool hasEnclosure, bool emitSignal)
+void Entry::setHasEnclosure(bool hasEnclosure, bool emitSignal, const QSqlRecord &enclosureRecord)
 {
     if (hasEnclosure) {
         // refresh enclosure anyway since we don't know whether it's been updated.
         if (m_enclosure) {
             delete m_enclosure;
         }
-        m_enclosure = new Enclosure(this);
+        m_enclosure = new Enclosure(this, enclosureRecord);
     } else {
         delete m_enclosure;
         m_enclosure = nullptr;
@@ -10,6 +10,7 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QObject>
+#include <QSqlRecord>
 #include <QString>
 #include <QStringList>
 
@@ -44,6 +45,9 @@ class Entry : public QObject
 
 public:
     Entry(const qint64 entryuid, QObject *parent = nullptr);
+    // construct from data that has already been retrieved from the database,
+    // see DataManager::prefetchEntries
+    Entry(const qint64 entryuid, const QSqlRecord &entryRecord, const QStringList &authors, const QSqlRecord &enclosureRecord);
     ~Entry();
 
     qint64 entryuid() const;
@@ -92,13 +96,15 @@ Q_SIGNALS:
 
 private:
     void updateFromDb(bool emitSignals = true);
+    void updateFromRecord(const QSqlRecord &entryRecord, const QSqlRecord &enclosureRecord, bool emitSignals = true);
     void updateAuthors();
+    void setAuthors(const QStringList &authors);
     void setTitle(const QString &title, bool emitSignal = true);
     void setContent(const QString &content, bool emitSignal = true);
     void setCreated(const QDateTime &created, bool emitSignal = true);
     void setUpdated(const QDateTime &updated, bool emitSignal = true);
     void setLink(const QString &link, bool emitSignal = true);
-    void setHasEnclosure(bool hasEnclosure, bool emitSignal = true);
+    void setHasEnclosure(bool hasEnclosure, bool emitSignal = true, const QSqlRecord &enclosureRecord = QSqlRecord());
     void setImage(const QString &url, bool emitSignal = true);
 
     QPointer<Feed> m_feed;
@@ -47,6 +47,9 @@ Feed::Feed(const qint64 feeduid, QObject *parent)
     int filterTypeValue = query.value(QStringLiteral("filterType")).toInt();
     int sortTypeValue = query.value(QStringLiteral("sortType")).toInt();
     m_dirname = query.value(QStringLiteral("dirname")).toString();
+    m_updateFailureCount = query.value(QStringLiteral("failureCount")).toInt();
+    m_retryAfter.setSecsSinceEpoch(query.value(QStringLiteral("retryAfter")).toLongLong());
+    m_updatesPaused = query.value(QStringLiteral("paused")).toBool();
 
     m_errorId = 0;
     m_errorString = QLatin1String("");
@@ -62,6 +65,17 @@ Feed::Feed(const qint64 feeduid, QObject *parent)
             setRefreshing(status);
         }
     });
+    connect(&Fetcher::instance(),
+            &Fetcher::feedFailureStateChanged,
+            this,
+            [this](const qint64 feeduid, const int failureCount, const QDateTime &retryAfter, const bool paused) {
+                if (feeduid == m_feeduid) {
+                    m_updateFailureCount = failureCount;
+                    m_retryAfter = retryAfter;
+                    m_updatesPaused = paused;
+                    Q_EMIT updateFailureStateChanged();
+                }
+            });
     connect(&DataManager::instance(), &DataManager::feedEntriesUpdated, this, [this](const qint64 feeduid) {
         if (feeduid == m_feeduid) {
             updateEntryCountFromDB();
@@ -316,6 +330,29 @@ QString Feed::errorString() const
     return m_errorString;
 }
 
+int Feed::updateFailureCount() const
+{
+    return m_updateFailureCount;
+}
+
+QDateTime Feed::retryAfter() const
+{
+    return m_retryAfter;
+}
+
+bool Feed::updatesPaused() const
+{
+    return m_updatesPaused;
+}
+
+void Feed::setUrl(const QString &url)
+{
+    if (url != m_url) {
+        m_url = url;
+        Q_EMIT urlChanged(m_url);
+    }
+}
+
 void Feed::setName(const QString &name)
 {
     if (name != m_name) {
@@ -396,3 +433,19 @@ void Feed::refresh()
 {
     Fetcher::instance().fetch(m_url);
 }
+
+void Feed::resumeUpdates()
+{
+    QSqlQuery query;
+    query.prepare(QStringLiteral("UPDATE Feeds SET failureCount=0, retryAfter=0, paused=:paused WHERE feeduid=:feeduid;"));
+    query.bindValue(QStringLiteral(":feeduid"), m_feeduid);
+    query.bindValue(QStringLiteral(":paused"), false);
+    Database::instance().execute(query);
+
+    m_updateFailureCount = 0;
+    m_retryAfter = QDateTime();
+    m_updatesPaused = false;
+    Q_EMIT updateFailureStateChanged();
+
+    refresh();
+}
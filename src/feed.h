@@ -22,7 +22,7 @@ class Feed : public QObject
     QML_UNCREATABLE("")
 
     Q_PROPERTY(qint64 feeduid READ feeduid CONSTANT)
-    Q_PROPERTY(QString url READ url CONSTANT)
+    Q_PROPERTY(QString url READ url NOTIFY urlChanged)
     Q_PROPERTY(QString name READ name NOTIFY nameChanged)
     Q_PROPERTY(QString image READ image NOTIFY imageChanged)
     Q_PROPERTY(QString link READ link NOTIFY linkChanged)
@@ -37,6 +37,9 @@ class Feed : public QObject
     Q_PROPERTY(int favoriteEntryCount READ favoriteEntryCount NOTIFY favoriteEntryCountChanged)
     Q_PROPERTY(int errorId READ errorId WRITE setErrorId NOTIFY errorIdChanged)
     Q_PROPERTY(QString errorString READ errorString WRITE setErrorString NOTIFY errorStringChanged)
+    Q_PROPERTY(int updateFailureCount READ updateFailureCount NOTIFY updateFailureStateChanged)
+    Q_PROPERTY(QDateTime retryAfter READ retryAfter NOTIFY updateFailureStateChanged)
+    Q_PROPERTY(bool updatesPaused READ updatesPaused NOTIFY updateFailureStateChanged)
     Q_PROPERTY(EntriesProxyModel *entries MEMBER m_entries CONSTANT)
 
 public:
@@ -62,9 +65,13 @@ public:
     bool read() const;
     int errorId() const;
     QString errorString() const;
+    int updateFailureCount() const;
+    QDateTime retryAfter() const;
+    bool updatesPaused() const;
 
     bool refreshing() const;
 
+    void setUrl(const QString &url);
     void setName(const QString &name);
     void setImage(const QString &image);
     void setLink(const QString &link);
@@ -76,8 +83,10 @@ public:
     void setErrorString(const QString &errorString);
 
     Q_INVOKABLE void refresh();
+    Q_INVOKABLE void resumeUpdates();
 
 Q_SIGNALS:
+    void urlChanged(const QString &url);
     void nameChanged(const QString &name);
     void imageChanged(const QString &image);
     void linkChanged(const QString &link);
@@ -91,6 +100,7 @@ Q_SIGNALS:
     void favoriteEntryCountChanged();
     void errorIdChanged(int errorId);
     void errorStringChanged(const QString &errorString);
+    void updateFailureStateChanged();
 
     void refreshingChanged(bool refreshing);
 
@@ -114,6 +124,9 @@ private:
     QString m_dirname;
     int m_errorId;
     QString m_errorString;
+    int m_updateFailureCount = 0;
+    QDateTime m_retryAfter;
+    bool m_updatesPaused = false;
     int m_entryCount = -1;
     int m_unreadEntryCount = -1;
     int m_newEntryCount = -1;
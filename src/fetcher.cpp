@@ -9,6 +9,7 @@
 #include "fetcherlogging.h"
 
 #include <KLocalizedString>
+#include <QCoreApplication>
 #include <QDateTime>
 #include <QDebug>
 #include <QDir>
@@ -18,9 +19,13 @@
 #include <QNetworkProxy>
 #include <QNetworkProxyFactory>
 #include <QNetworkReply>
+#include <QSqlQuery>
+#include <QStringList>
 #include <QTime>
 #include <QTimer>
 
+#include <utility>
+
 #include "database.h"
 #include "models/errorlogmodel.h"
 #include "settingsmanager.h"
@@ -51,12 +56,28 @@ Fetcher::Fetcher()
     // setup update timer if required
     initializeUpdateTimer();
     connect(SettingsManager::self(), &SettingsManager::autoFeedUpdateIntervalChanged, this, &Fetcher::initializeUpdateTimer);
+
+    // start deferred bulk downloads once their time window opens
+    m_bulkDownloadTimer = new QTimer(this);
+    m_bulkDownloadTimer->setSingleShot(true);
+    connect(m_bulkDownloadTimer, &QTimer::timeout, this, &Fetcher::processEnclosureDownloadQueue);
+    connect(SettingsManager::self(), &SettingsManager::restrictBulkDownloadsChanged, this, &Fetcher::processEnclosureDownloadQueue);
+    connect(SettingsManager::self(), &SettingsManager::bulkDownloadStartHourChanged, this, &Fetcher::processEnclosureDownloadQueue);
+    connect(SettingsManager::self(), &SettingsManager::bulkDownloadEndHourChanged, this, &Fetcher::processEnclosureDownloadQueue);
+
+    m_queuedDownloadTimer = new QTimer(this);
+    m_queuedDownloadTimer->setSingleShot(true);
+    m_queuedDownloadTimer->setInterval(0);
+    connect(m_queuedDownloadTimer, &QTimer::timeout, this, &Fetcher::writeQueuedDownloads);
+    // don't lose the state of downloads that are interrupted by quitting
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &Fetcher::writeQueuedDownloads);
 }
 
 void Fetcher::fetch(const QString &url)
 {
+    // an explicit request to update a single feed
     QStringList urls(url);
-    fetch(urls);
+    fetch(urls, DataTypes::InteractiveFetch);
 }
 
 void Fetcher::fetchAll()
@@ -73,15 +94,50 @@ void Fetcher::fetchAll()
         }
 
         if (urls.count() > 0) {
-            fetch(urls);
+            fetch(urls, DataTypes::NormalFetch);
         }
     }
 }
 
-void Fetcher::fetch(const QStringList &urls)
+void Fetcher::fetchDue()
 {
     if (m_updating)
-        return; // update is already running, do nothing
+        return; // update is already running; due feeds will be picked up next time
+
+    // add a few seconds as "fuzzy match" to avoid that feeds are delayed by
+    // another check interval due to a difference of just a few milliseconds
+    QStringList urls;
+    QSqlQuery query;
+    query.prepare(QStringLiteral("SELECT url FROM Feeds WHERE nextUpdate<=:now AND paused=:paused;"));
+    query.bindValue(QStringLiteral(":now"), QDateTime::currentDateTimeUtc().addSecs(5).toSecsSinceEpoch());
+    query.bindValue(QStringLiteral(":paused"), false);
+    Database::instance().execute(query);
+    while (query.next()) {
+        urls += query.value(0).toString();
+    }
+
+    qCDebug(kastsFetcher) << "Feeds due for an automatic update:" << urls;
+    if (urls.count() > 0) {
+        fetch(urls, DataTypes::BackgroundFetch);
+    }
+}
+
+void Fetcher::fetch(const QStringList &urls)
+{
+    fetch(urls, DataTypes::NormalFetch);
+}
+
+void Fetcher::fetch(const QStringList &urls, DataTypes::FetchPriority priority)
+{
+    if (m_updating) {
+        // an update is already running; add the feeds to it, such that
+        // e.g. an explicit request by the user doesn't get lost
+        if (m_fetchFeedsJob) {
+            qCDebug(kastsFetcher) << "Adding feeds to running update with priority" << priority << urls;
+            m_fetchFeedsJob->addFeeds(urls, priority);
+        }
+        return;
+    }
 
     m_updating = true;
     m_updateProgress = 0;
@@ -91,7 +147,8 @@ void Fetcher::fetch(const QStringList &urls)
     Q_EMIT updateTotalChanged(m_updateTotal);
 
     qCDebug(kastsFetcher) << "Create fetchFeedsJob";
-    FetchFeedsJob *fetchFeedsJob = new FetchFeedsJob(urls, this);
+    FetchFeedsJob *fetchFeedsJob = new FetchFeedsJob(urls, priority, this);
+    m_fetchFeedsJob = fetchFeedsJob;
     connect(this, &Fetcher::cancelFetching, fetchFeedsJob, &FetchFeedsJob::abort);
     connect(fetchFeedsJob, &FetchFeedsJob::processedAmountChanged, this, [this](KJob *job, KJob::Unit unit, qulonglong amount) {
         qCDebug(kastsFetcher) << "FetchFeedsJob::processedAmountChanged:" << amount;
@@ -100,8 +157,17 @@ void Fetcher::fetch(const QStringList &urls)
         m_updateProgress = amount;
         Q_EMIT updateProgressChanged(m_updateProgress);
     });
+    // feeds that are backing off or paused are not updated and hence not
+    // counted
+    connect(fetchFeedsJob, &FetchFeedsJob::totalAmountChanged, this, [this](KJob *job, KJob::Unit unit, qulonglong amount) {
+        Q_UNUSED(job);
+        Q_ASSERT(unit == KJob::Unit::Items);
+        m_updateTotal = amount;
+        Q_EMIT updateTotalChanged(m_updateTotal);
+    });
     connect(fetchFeedsJob, &FetchFeedsJob::result, this, [this, fetchFeedsJob]() {
         qCDebug(kastsFetcher) << "result slot of FetchFeedsJob";
+        m_fetchFeedsJob = nullptr;
         if (fetchFeedsJob->error() && !fetchFeedsJob->aborted()) {
             Q_EMIT error(Error::Type::FeedUpdate, QString(), QString(), fetchFeedsJob->error(), fetchFeedsJob->errorString(), QString());
         }
@@ -115,9 +181,37 @@ void Fetcher::fetch(const QStringList &urls)
     qCDebug(kastsFetcher) << "end of Fetcher::fetch";
 }
 
-EnclosureDownloadJob *Fetcher::enqueueEnclosureDownload(const qint64 entryuid, const QString &url, const QString &path, const QString &title)
+EnclosureDownloadJob *Fetcher::enqueueEnclosureDownload(const qint64 entryuid,
+                                                        const QString &url,
+                                                        const QString &path,
+                                                        const QString &title,
+                                                        const DownloadRateLimiter::Priority priority)
 {
     QPointer<EnclosureDownloadJob> newDownloadJob = new EnclosureDownloadJob(entryuid, url, path, title);
+    newDownloadJob->setPriority(entryuid == m_playingEntryuid ? DownloadRateLimiter::Playback : priority);
+
+    // pick up the validators of an earlier attempt, such that a partial
+    // download is only resumed if the file hasn't changed in the meantime;
+    // changes that haven't been written yet take precedence over the
+    // database, and bulk downloads have their validators preloaded
+    const auto change = m_queuedDownloadChanges.constFind(entryuid);
+    if (change != m_queuedDownloadChanges.cend() && (change->removed || change->hasProgress)) {
+        newDownloadJob->setValidators(change->etag, change->lastModified);
+    } else if (m_preloadedValidators.contains(entryuid)) {
+        const DownloadValidators validators = m_preloadedValidators.take(entryuid);
+        newDownloadJob->setValidators(validators.etag, validators.lastModified);
+    } else {
+        QSqlQuery query;
+        query.prepare(QStringLiteral("SELECT etag, lastModified FROM DownloadQueue WHERE entryuid=:entryuid;"));
+        query.bindValue(QStringLiteral(":entryuid"), entryuid);
+        Database::instance().execute(query);
+        if (query.next()) {
+            newDownloadJob->setValidators(query.value(QStringLiteral("etag")).toString(), query.value(QStringLiteral("lastModified")).toString());
+        }
+        query.finish();
+    }
+    storeQueuedDownload(newDownloadJob, DataTypes::DownloadQueued);
+
     connect(newDownloadJob, &EnclosureDownloadJob::finished, this, [this, newDownloadJob]() {
         // This is called whenever a DownloadEnclosureJob has finished
         if (m_ongoingEnclosureDownloads.contains(newDownloadJob)) {
@@ -129,6 +223,14 @@ EnclosureDownloadJob *Fetcher::enqueueEnclosureDownload(const qint64 entryuid, c
             m_enclosureDownloadQueue.remove(m_enclosureDownloadQueue.indexOf(newDownloadJob));
         }
 
+        // keep downloads that were interrupted by the network, such that
+        // they're resumed on the next start
+        if (newDownloadJob->error() != 0 && isInterruption(newDownloadJob->error())) {
+            storeQueuedDownload(newDownloadJob, DataTypes::DownloadInterrupted);
+        } else {
+            removeQueuedDownload(newDownloadJob->entryuid());
+        }
+
         processEnclosureDownloadQueue();
     });
 
@@ -140,19 +242,234 @@ EnclosureDownloadJob *Fetcher::enqueueEnclosureDownload(const qint64 entryuid, c
 
 void Fetcher::processEnclosureDownloadQueue()
 {
+    const bool bulkAllowed = bulkDownloadsAllowed();
+    bool bulkDeferred = false;
+
     while (m_ongoingEnclosureDownloads.count() < SettingsManager::self()->maximumParallelEpisodeDownloads() && !m_enclosureDownloadQueue.isEmpty()) {
         qCDebug(kastsFetcher) << "Current m_enclosureDownloadQueue.count()" << m_ongoingEnclosureDownloads.count();
-        QPointer<EnclosureDownloadJob> newJob = m_enclosureDownloadQueue.dequeue();
+
+        // start the job with the highest priority first; jobs with the same
+        // priority are started in the order in which they were queued
+        int next = -1;
+        bulkDeferred = false;
+        for (int i = 0; i < m_enclosureDownloadQueue.count(); ++i) {
+            const EnclosureDownloadJob *job = m_enclosureDownloadQueue[i];
+            if (job->priority() == DownloadRateLimiter::Bulk && !bulkAllowed) {
+                bulkDeferred = true;
+            } else if (next < 0 || job->priority() > m_enclosureDownloadQueue[next]->priority()) {
+                next = i;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+
+        QPointer<EnclosureDownloadJob> newJob = m_enclosureDownloadQueue.takeAt(next);
         if (newJob && newJob->status() == EnclosureDownloadJob::Status::Queued) {
             qCDebug(kastsFetcher) << "Starting queued EnclosureDownloadJob" << newJob;
             m_ongoingEnclosureDownloads += newJob;
+            storeQueuedDownload(newJob, DataTypes::DownloadRunning);
             newJob->start();
         }
     }
+
+    if (bulkDeferred) {
+        qCDebug(kastsFetcher) << "Deferring bulk downloads for" << msecsUntilBulkDownloads() / 1000 << "seconds";
+        m_bulkDownloadTimer->start(msecsUntilBulkDownloads());
+    } else {
+        m_bulkDownloadTimer->stop();
+    }
+}
+
+void Fetcher::storeQueuedDownload(const EnclosureDownloadJob *job, const DataTypes::DownloadQueueState state)
+{
+    m_preloadedValidators.remove(job->entryuid());
+    QueuedDownloadChange &change = m_queuedDownloadChanges[job->entryuid()];
+    change.removed = false;
+    change.state = state;
+    change.priority = job->priority();
+    change.queued = QDateTime::currentSecsSinceEpoch();
+
+    // the progress and validators are only known once the job has run;
+    // otherwise the ones of an earlier change are kept
+    if (job->status() != EnclosureDownloadJob::Status::Queued) {
+        change.hasProgress = true;
+        change.bytesDone = job->bytesDone();
+        change.totalSize = job->totalSize();
+        change.etag = job->etag();
+        change.lastModified = job->lastModified();
+    }
+
+    m_queuedDownloadTimer->start();
+}
+
+void Fetcher::removeQueuedDownload(const qint64 entryuid)
+{
+    m_preloadedValidators.remove(entryuid);
+    m_queuedDownloadChanges[entryuid] = QueuedDownloadChange{.removed = true};
+    m_queuedDownloadTimer->start();
+}
+
+void Fetcher::preloadDownloadValidators(const QHash<qint64, DownloadValidators> &validators)
+{
+    for (auto it = validators.cbegin(); it != validators.cend(); ++it) {
+        if (!m_queuedDownloadChanges.contains(it.key())) {
+            m_preloadedValidators[it.key()] = it.value();
+        }
+    }
+}
+
+void Fetcher::preloadDownloadValidators(const QList<qint64> &entryuids)
+{
+    // downloads that aren't in the queue yet don't have any validators
+    QHash<qint64, DownloadValidators> validators;
+    QStringList uids;
+    for (const qint64 entryuid : entryuids) {
+        validators[entryuid] = DownloadValidators();
+        uids += QString::number(entryuid);
+    }
+    if (uids.isEmpty()) {
+        return;
+    }
+
+    // The entryuids are integers, so they can safely be put directly into
+    // the query string instead of binding them one by one
+    QSqlQuery query;
+    query.prepare(QStringLiteral("SELECT entryuid, etag, lastModified FROM DownloadQueue WHERE entryuid IN (%1);").arg(uids.join(QLatin1Char(','))));
+    Database::instance().execute(query);
+    while (query.next()) {
+        validators[query.value(QStringLiteral("entryuid")).toLongLong()] =
+            DownloadValidators{.etag = query.value(QStringLiteral("etag")).toString(), .lastModified = query.value(QStringLiteral("lastModified")).toString()};
+    }
+    query.finish();
+
+    preloadDownloadValidators(validators);
+}
+
+void Fetcher::writeQueuedDownloads()
+{
+    m_queuedDownloadTimer->stop();
+    if (m_queuedDownloadChanges.isEmpty()) {
+        return;
+    }
+    const QHash<qint64, QueuedDownloadChange> changes = std::exchange(m_queuedDownloadChanges, {});
+
+    Database::instance().transaction();
+    QSqlQuery insertQuery;
+    insertQuery.prepare(QStringLiteral("INSERT OR IGNORE INTO DownloadQueue (entryuid, state, priority, queued) VALUES (:entryuid, :state, :priority, :queued);"));
+    QSqlQuery stateQuery;
+    stateQuery.prepare(QStringLiteral("UPDATE DownloadQueue SET state=:state, priority=:priority WHERE entryuid=:entryuid;"));
+    QSqlQuery progressQuery;
+    progressQuery.prepare(
+        QStringLiteral("UPDATE DownloadQueue SET state=:state, priority=:priority, bytesDone=:bytesDone, totalSize=:totalSize, etag=:etag, "
+                       "lastModified=:lastModified WHERE entryuid=:entryuid;"));
+    QSqlQuery deleteQuery;
+    deleteQuery.prepare(QStringLiteral("DELETE FROM DownloadQueue WHERE entryuid=:entryuid;"));
+
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        const QueuedDownloadChange &change = it.value();
+        if (change.removed) {
+            deleteQuery.bindValue(QStringLiteral(":entryuid"), it.key());
+            Database::instance().execute(deleteQuery);
+            continue;
+        }
+
+        insertQuery.bindValue(QStringLiteral(":entryuid"), it.key());
+        insertQuery.bindValue(QStringLiteral(":state"), change.state);
+        insertQuery.bindValue(QStringLiteral(":priority"), change.priority);
+        insertQuery.bindValue(QStringLiteral(":queued"), change.queued);
+        Database::instance().execute(insertQuery);
+
+        QSqlQuery &updateQuery = change.hasProgress ? progressQuery : stateQuery;
+        if (change.hasProgress) {
+            updateQuery.bindValue(QStringLiteral(":bytesDone"), change.bytesDone);
+            updateQuery.bindValue(QStringLiteral(":totalSize"), change.totalSize);
+            updateQuery.bindValue(QStringLiteral(":etag"), change.etag);
+            updateQuery.bindValue(QStringLiteral(":lastModified"), change.lastModified);
+        }
+        updateQuery.bindValue(QStringLiteral(":entryuid"), it.key());
+        updateQuery.bindValue(QStringLiteral(":state"), change.state);
+        updateQuery.bindValue(QStringLiteral(":priority"), change.priority);
+        Database::instance().execute(updateQuery);
+    }
+    Database::instance().commit();
+
+    const QList<qint64> entryuids = changes.keys();
+    Q_EMIT downloadQueueChanged(QSet<qint64>(entryuids.cbegin(), entryuids.cend()));
+}
+
+bool Fetcher::isInterruption(const int error)
+{
+    switch (error) {
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void Fetcher::setPlayingEntryuid(const qint64 entryuid)
+{
+    m_playingEntryuid = entryuid;
+
+    QList<EnclosureDownloadJob *> jobs = m_ongoingEnclosureDownloads.values();
+    jobs += m_enclosureDownloadQueue;
+    for (EnclosureDownloadJob *job : std::as_const(jobs)) {
+        if (job->entryuid() == entryuid) {
+            job->setPriority(DownloadRateLimiter::Playback);
+        } else if (job->priority() == DownloadRateLimiter::Playback) {
+            job->setPriority(DownloadRateLimiter::Normal);
+        }
+    }
+
+    // the episode in the player might have been waiting for a bulk window
+    processEnclosureDownloadQueue();
+}
+
+bool Fetcher::bulkDownloadsAllowed() const
+{
+    if (!SettingsManager::self()->restrictBulkDownloads()) {
+        return true;
+    }
+
+    const int start = SettingsManager::self()->bulkDownloadStartHour();
+    const int end = SettingsManager::self()->bulkDownloadEndHour();
+    const int hour = QTime::currentTime().hour();
+    if (start == end) {
+        return true;
+    } else if (start < end) {
+        return hour >= start && hour < end;
+    } else {
+        return hour >= start || hour < end; // window spans midnight
+    }
+}
+
+qint64 Fetcher::msecsUntilBulkDownloads() const
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    QDateTime start(now.date(), QTime(SettingsManager::self()->bulkDownloadStartHour(), 0));
+    if (start <= now) {
+        start = start.addDays(1);
+    }
+    return now.msecsTo(start);
 }
 
 void Fetcher::getRedirectedUrl(const QUrl &url)
 {
+    const QUrl cachedUrl = cachedRedirect(url);
+    if (cachedUrl != url) {
+        qCDebug(kastsFetcher) << "using cached redirect; this is the old url and the redirected url:" << url << cachedUrl;
+        QTimer::singleShot(0, this, [this, url, cachedUrl]() {
+            Q_EMIT foundRedirectedUrl(url, cachedUrl);
+        });
+        return;
+    }
+
     QNetworkRequest request((QUrl(url)));
     request.setTransferTimeout(5000); // wait 5 seconds; it will fall back to original url otherwise
 
@@ -162,6 +479,9 @@ void Fetcher::getRedirectedUrl(const QUrl &url)
         qCDebug(kastsFetcher) << "finished looking for redirect; this is the old url and the redirected url:" << url << reply->url();
 
         QUrl newUrl = reply->url();
+        if (!reply->error()) {
+            cacheRedirect(url, newUrl);
+        }
         QTimer::singleShot(0, this, [this, url, newUrl]() {
             Q_EMIT foundRedirectedUrl(url, newUrl);
         });
@@ -169,6 +489,39 @@ void Fetcher::getRedirectedUrl(const QUrl &url)
     });
 }
 
+QUrl Fetcher::cachedRedirect(const QUrl &url)
+{
+    const auto it = m_redirectCache.constFind(url);
+    if (it == m_redirectCache.cend()) {
+        return url;
+    }
+    if (it->expires < QDateTime::currentSecsSinceEpoch()) {
+        m_redirectCache.erase(it);
+        return url;
+    }
+    return it->url;
+}
+
+void Fetcher::cacheRedirect(const QUrl &url, const QUrl &redirectedUrl)
+{
+    if (!redirectedUrl.isValid() || redirectedUrl == url) {
+        return;
+    }
+
+    // get rid of expired entries before adding new ones
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    m_redirectCache.removeIf([now](const std::pair<const QUrl &, CachedRedirect &> &entry) {
+        return entry.second.expires < now;
+    });
+
+    m_redirectCache[url] = {redirectedUrl, now + m_redirectCacheTtl};
+}
+
+void Fetcher::removeCachedRedirect(const QUrl &url)
+{
+    m_redirectCache.remove(url);
+}
+
 QNetworkReply *Fetcher::get(QNetworkRequest &request) const
 {
     return m_manager->get(request);
@@ -179,6 +532,11 @@ QNetworkReply *Fetcher::post(QNetworkRequest &request, const QByteArray &data) c
     return m_manager->post(request, data);
 }
 
+QNetworkReply *Fetcher::head(QNetworkRequest &request) const
+{
+    return m_manager->head(request);
+}
+
 void Fetcher::initializeUpdateTimer()
 {
     qCDebug(kastsFetcher) << "Fetcher::setUpdateTimer";
@@ -205,6 +563,14 @@ void Fetcher::initializeUpdateTimer()
 
 void Fetcher::checkUpdateTimer()
 {
+    // With adaptive updates, every feed has its own next update time and only
+    // the feeds that are due are fetched.  If feeds are updated as part of a
+    // sync, we stick to updating all feeds at the fixed interval.
+    if (SettingsManager::self()->adaptiveFeedUpdates() && !(Sync::instance().syncEnabled() && SettingsManager::self()->syncWhenUpdatingFeeds())) {
+        fetchDue();
+        return;
+    }
+
     qCDebug(kastsFetcher) << "Fetcher::checkUpdateTimer; next automatic feed update in" << m_updateTriggerTime - QDateTime::currentDateTimeUtc();
 
     // add a few seconds as "fuzzy match" to avoid that the trigger is delayed
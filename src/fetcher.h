@@ -9,19 +9,25 @@
 
 #include <QDateTime>
 #include <QFile>
+#include <QHash>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
+#include <QPointer>
 #include <QQmlEngine>
 #include <QQueue>
+#include <QSet>
 #include <QTimer>
 #include <QUrl>
 #include <Syndication/Syndication>
 
+#include "datatypes.h"
 #include "enclosuredownloadjob.h"
 #include "error.h"
 #include "utils/networkaccessmanager.h"
 
+class FetchFeedsJob;
+
 class Fetcher : public QObject
 {
     Q_OBJECT
@@ -46,24 +52,53 @@ public:
 
     Q_INVOKABLE void fetch(const QString &url);
     Q_INVOKABLE void fetch(const QStringList &urls);
+    void fetch(const QStringList &urls, DataTypes::FetchPriority priority);
     Q_INVOKABLE void fetchAll();
+    void fetchDue(); // only fetch feeds that are due according to their nextUpdate
 
-    EnclosureDownloadJob *enqueueEnclosureDownload(const qint64 entryuid, const QString &url, const QString &path, const QString &title);
+    EnclosureDownloadJob *enqueueEnclosureDownload(const qint64 entryuid,
+                                                   const QString &url,
+                                                   const QString &path,
+                                                   const QString &title,
+                                                   const DownloadRateLimiter::Priority priority = DownloadRateLimiter::Normal);
     void processEnclosureDownloadQueue();
+    // the download queue is kept in the database, such that downloads can
+    // be resumed after a restart
+    void removeQueuedDownload(const qint64 entryuid);
+    // validators of earlier attempts of downloads that are about to be
+    // enqueued in bulk, such that enqueueEnclosureDownload doesn't have to
+    // look them up one by one
+    struct DownloadValidators {
+        QString etag;
+        QString lastModified;
+    };
+    void preloadDownloadValidators(const QHash<qint64, DownloadValidators> &validators);
+    void preloadDownloadValidators(const QList<qint64> &entryuids);
+    // true for QNetworkReply errors that mean that the server could not be
+    // reached (e.g. because we're offline) rather than a problem of the server
+    static bool isInterruption(const int error);
+    // gives the download of the episode in the player the highest priority
+    void setPlayingEntryuid(const qint64 entryuid);
 
     QNetworkReply *get(QNetworkRequest &request) const;
     QNetworkReply *post(QNetworkRequest &request, const QByteArray &data) const;
+    QNetworkReply *head(QNetworkRequest &request) const;
 
     void initializeUpdateTimer();
     void checkUpdateTimer();
 
+    // resolves redirects of enclosure urls; results are cached for a while
+    // such that repeated plays and downloads can skip redirect chains
     void getRedirectedUrl(const QUrl &url);
+    QUrl cachedRedirect(const QUrl &url); // returns url itself if no redirect is known
+    void cacheRedirect(const QUrl &url, const QUrl &redirectedUrl);
+    void removeCachedRedirect(const QUrl &url);
     Q_INVOKABLE void setNetworkProxy();
     Q_INVOKABLE bool isSystemProxyDefined();
 
 Q_SIGNALS:
-    void entryAdded(const qint64 entryuid);
-    void entryUpdated(const qint64 entryuid);
+    void entriesAdded(const qint64 feeduid, const QSet<qint64> &entryuids);
+    void entriesUpdated(const qint64 feeduid, const QSet<qint64> &entryuids);
     void feedUpdated(const qint64 feeduid);
     void feedDetailsUpdated(const qint64 feeduid,
                             const QString &url,
@@ -74,6 +109,8 @@ Q_SIGNALS:
                             const QDateTime &lastUpdated,
                             const QString &dirname);
     void feedUpdateStatusChanged(const qint64 feeduid, bool status);
+    void feedUrlChanged(const qint64 feeduid, const QString &oldUrl, const QString &newUrl);
+    void feedFailureStateChanged(const qint64 feeduid, const int failureCount, const QDateTime &retryAfter, const bool paused);
     void cancelFetching();
 
     void updateProgressChanged(int progress);
@@ -83,6 +120,7 @@ Q_SIGNALS:
     void error(Error::Type type, const QString &url, const QString &id, const int errorId, const QString &errorString, const QString &title);
     void downloadFinished(QString url) const;
     void foundRedirectedUrl(const QUrl &url, const QUrl &newUrl);
+    void downloadQueueChanged(const QSet<qint64> &entryuids);
 
 private:
     Fetcher();
@@ -90,11 +128,48 @@ private:
     QSet<QString> m_ongoingImageDownloads;
     QSet<EnclosureDownloadJob *> m_ongoingEnclosureDownloads;
     QQueue<EnclosureDownloadJob *> m_enclosureDownloadQueue;
+    qint64 m_playingEntryuid = 0;
+
+    void storeQueuedDownload(const EnclosureDownloadJob *job, const DataTypes::DownloadQueueState state);
+
+    // changes to the download queue are collected and written to the
+    // database in a single transaction once control returns to the event
+    // loop, since e.g. bulk downloads change many entries at once
+    struct QueuedDownloadChange {
+        bool removed = false;
+        int state = 0;
+        int priority = 0;
+        qint64 queued = 0;
+        bool hasProgress = false; // the job has run, so progress and validators are known
+        qint64 bytesDone = 0;
+        qint64 totalSize = 0;
+        QString etag;
+        QString lastModified;
+    };
+    QHash<qint64, QueuedDownloadChange> m_queuedDownloadChanges; // key = entryuid
+    QHash<qint64, DownloadValidators> m_preloadedValidators; // key = entryuid; only for downloads without pending changes
+    QTimer *m_queuedDownloadTimer;
+    void writeQueuedDownloads();
+
+    // bulk downloads can be restricted to a time window, e.g. at night
+    bool bulkDownloadsAllowed() const;
+    qint64 msecsUntilBulkDownloads() const;
+    QTimer *m_bulkDownloadTimer;
 
     NetworkAccessManager *m_manager;
     int m_updateProgress;
     int m_updateTotal;
     bool m_updating;
+    QPointer<FetchFeedsJob> m_fetchFeedsJob; // currently running feed update
+
+    struct CachedRedirect {
+        QUrl url;
+        qint64 expires; // seconds since epoch
+    };
+    QHash<QUrl, CachedRedirect> m_redirectCache;
+    // redirect targets of enclosures are often signed urls that expire
+    // after some time, so don't keep them too long
+    const qint64 m_redirectCacheTtl = 60 * 60;
 
     const qint64 m_checkInterval = 10 * 60 * 1000; // trigger timer every 10 minutes
     QTimer *m_updateTimer;
@@ -7,6 +7,9 @@
 #include "models/abstractepisodemodel.h"
 
 #include <KLocalizedString>
+#include <QList>
+
+#include <algorithm>
 
 #include "datamanager.h"
 
@@ -14,6 +17,12 @@ AbstractEpisodeProxyModel::AbstractEpisodeProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
 {
     m_searchFlags = SearchFlag::TitleFlag | SearchFlag::ContentFlag | SearchFlag::FeedNameFlag;
+
+    // the rows of the prefetched range no longer match once rows move around
+    connect(this, &AbstractEpisodeProxyModel::modelReset, this, &AbstractEpisodeProxyModel::resetPrefetchedRange);
+    connect(this, &AbstractEpisodeProxyModel::layoutChanged, this, &AbstractEpisodeProxyModel::resetPrefetchedRange);
+    connect(this, &AbstractEpisodeProxyModel::rowsInserted, this, &AbstractEpisodeProxyModel::resetPrefetchedRange);
+    connect(this, &AbstractEpisodeProxyModel::rowsRemoved, this, &AbstractEpisodeProxyModel::resetPrefetchedRange);
 }
 
 bool AbstractEpisodeProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
@@ -73,6 +82,42 @@ bool AbstractEpisodeProxyModel::filterAcceptsRow(int sourceRow, const QModelInde
     return accepted;
 }
 
+QVariant AbstractEpisodeProxyModel::data(const QModelIndex &index, int role) const
+{
+    if (role == AbstractEpisodeModel::Roles::EntryRole) {
+        prefetchEntries(index.row());
+    }
+    return QSortFilterProxyModel::data(index, role);
+}
+
+void AbstractEpisodeProxyModel::prefetchEntries(const int row) const
+{
+    // Only build a new window once the requested row gets close to the edge
+    // of the previous one; the delegates in between are already loaded
+    const int count = rowCount();
+    const bool nearStart = row - m_prefetchBehind / 2 < m_prefetchedFirst && m_prefetchedFirst > 0;
+    const bool nearEnd = row + m_prefetchAhead / 2 > m_prefetchedLast && m_prefetchedLast < count - 1;
+    if (row >= m_prefetchedFirst && row <= m_prefetchedLast && !nearStart && !nearEnd) {
+        return;
+    }
+
+    m_prefetchedFirst = std::max(0, row - m_prefetchBehind);
+    m_prefetchedLast = std::min(count - 1, row + m_prefetchAhead);
+
+    QList<qint64> entryuids;
+    entryuids.reserve(m_prefetchedLast - m_prefetchedFirst + 1);
+    for (int i = m_prefetchedFirst; i <= m_prefetchedLast; ++i) {
+        entryuids += sourceModel()->data(mapToSource(index(i, 0)), AbstractEpisodeModel::Roles::EntryuidRole).value<qint64>();
+    }
+    DataManager::instance().prefetchEntries(entryuids);
+}
+
+void AbstractEpisodeProxyModel::resetPrefetchedRange()
+{
+    m_prefetchedFirst = 0;
+    m_prefetchedLast = -1;
+}
+
 AbstractEpisodeProxyModel::FilterType AbstractEpisodeProxyModel::filterType() const
 {
     return m_currentFilter;
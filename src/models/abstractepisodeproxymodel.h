@@ -10,6 +10,7 @@
 #include <QQmlEngine>
 #include <QSortFilterProxyModel>
 #include <QString>
+#include <QVariant>
 
 class Entry;
 
@@ -55,6 +56,7 @@ public:
     explicit AbstractEpisodeProxyModel(QObject *parent = nullptr);
 
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
     FilterType filterType() const;
     QString filterName() const;
@@ -81,6 +83,18 @@ Q_SIGNALS:
     void sortTypeChanged();
 
 protected:
+    // Make sure the Entry objects around the requested row are loaded in one
+    // go, rather than one by one as the delegates get instantiated.  The
+    // window is taken from the rows of this model, i.e. after sorting and
+    // filtering, since those are the ones that are about to become visible.
+    void prefetchEntries(const int row) const;
+    void resetPrefetchedRange();
+
+    static constexpr int m_prefetchBehind = 10; // number of rows before the requested row to prefetch
+    static constexpr int m_prefetchAhead = 50; // number of rows after the requested row to prefetch
+    mutable int m_prefetchedFirst = 0; // first row of the most recently prefetched range
+    mutable int m_prefetchedLast = -1; // last row of that range; empty if smaller than first
+
     FilterType m_currentFilter = FilterType::NoFilter;
     QString m_searchFilter;
     SearchFlags m_searchFlags;
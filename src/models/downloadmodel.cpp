@@ -8,16 +8,18 @@
 #include "models/downloadmodellogging.h"
 
 #include <QSqlQuery>
+#include <QStringList>
 
 #include "database.h"
 #include "datamanager.h"
 #include "enclosure.h"
-#include "models/abstractepisodemodel.h"
+#include "fetcher.h"
 
 DownloadModel::DownloadModel()
     : QAbstractListModel(nullptr)
 {
     updateInternalState();
+    connect(&Fetcher::instance(), &Fetcher::downloadQueueChanged, this, &DownloadModel::updateQueueDetails);
 }
 
 QVariant DownloadModel::data(const QModelIndex &index, int role) const
@@ -43,6 +45,12 @@ QVariant DownloadModel::data(const QModelIndex &index, int role) const
         return QVariant::fromValue(m_feedNames[index.row()]);
     case AbstractEpisodeModel::Roles::UpdatedRole:
         return QVariant::fromValue(m_entries[index.row()].updated);
+    case Roles::DownloadQueueStateRole:
+        return QVariant::fromValue(m_queueDetails[index.row()].state);
+    case Roles::DownloadPriorityRole:
+        return QVariant::fromValue(m_queueDetails[index.row()].priority);
+    case Roles::BytesDoneRole:
+        return QVariant::fromValue(m_queueDetails[index.row()].bytesDone);
     default:
         return QVariant();
     }
@@ -61,6 +69,9 @@ QHash<int, QByteArray> DownloadModel::roleNames() const
         {AbstractEpisodeModel::Roles::ContentRole, "content"},
         {AbstractEpisodeModel::Roles::FeedNameRole, "feedname"},
         {AbstractEpisodeModel::Roles::UpdatedRole, "updated"},
+        {Roles::DownloadQueueStateRole, "downloadQueueState"},
+        {Roles::DownloadPriorityRole, "downloadPriority"},
+        {Roles::BytesDoneRole, "bytesDone"},
     };
 }
 
@@ -80,39 +91,80 @@ void DownloadModel::monitorDownloadStatus()
 void DownloadModel::updateInternalState()
 {
     m_entries.clear();
-    const QList<Enclosure::Status> statuses = {
-        Enclosure::Status::Downloading,
-        Enclosure::Status::Queued,
-        Enclosure::Status::PartiallyDownloaded,
-        Enclosure::Status::Downloaded,
-    };
+    m_feedNames.clear();
+    m_queueDetails.clear();
+    m_rows.clear();
 
+    // a single query for all statuses; running and queued downloads come
+    // first, in the order in which the download queue will handle them
     QSqlQuery query;
     query.prepare(
-        QStringLiteral("SELECT * FROM Entries JOIN Enclosures ON Enclosures.entryuid = Entries.entryuid JOIN Feeds ON Feeds.feeduid = Entries.feeduid WHERE "
-                       "Enclosures.downloaded=:downloaded "
-                       "ORDER BY updated DESC;"));
-    for (const Enclosure::Status status : statuses) {
-        query.bindValue(QStringLiteral(":downloaded"), Enclosure::statusToDb(status));
-        Database::instance().execute(query);
-        while (query.next()) {
-            DataTypes::EntryDetails entryDetails;
-            entryDetails.entryuid = query.value(QStringLiteral("entryuid")).toLongLong();
-            entryDetails.feeduid = query.value(QStringLiteral("feeduid")).toLongLong();
-            entryDetails.id = query.value(QStringLiteral("id")).toString();
-            entryDetails.title = query.value(QStringLiteral("title")).toString();
-            entryDetails.content = query.value(QStringLiteral("content")).toString();
-            entryDetails.created = query.value(QStringLiteral("created")).toInt();
-            entryDetails.updated = query.value(QStringLiteral("updated")).toInt();
-            entryDetails.read = query.value(QStringLiteral("read")).toBool();
-            entryDetails.isNew = query.value(QStringLiteral("new")).toBool();
-            entryDetails.favorite = query.value(QStringLiteral("favorite")).toBool();
-            entryDetails.link = query.value(QStringLiteral("link")).toString();
-            entryDetails.hasEnclosure = query.value(QStringLiteral("hasEnclosure")).toBool();
-            entryDetails.image = query.value(QStringLiteral("image")).toString();
-            m_entries += entryDetails;
-            m_feedNames += query.value(QStringLiteral("Feeds.name")).toString();
+        QStringLiteral("SELECT *, DownloadQueue.state AS queueState, DownloadQueue.priority AS queuePriority, DownloadQueue.bytesDone AS queueBytesDone "
+                       "FROM Entries JOIN Enclosures ON Enclosures.entryuid = Entries.entryuid JOIN Feeds ON Feeds.feeduid = Entries.feeduid "
+                       "LEFT JOIN DownloadQueue ON DownloadQueue.entryuid = Entries.entryuid "
+                       "WHERE Enclosures.downloaded IN (%1, %2, %3, %4) "
+                       "ORDER BY CASE Enclosures.downloaded WHEN %1 THEN 0 WHEN %2 THEN 1 WHEN %3 THEN 2 ELSE 3 END, "
+                       "DownloadQueue.priority DESC, DownloadQueue.queued ASC, updated DESC;")
+            .arg(Enclosure::statusToDb(Enclosure::Status::Downloading))
+            .arg(Enclosure::statusToDb(Enclosure::Status::Queued))
+            .arg(Enclosure::statusToDb(Enclosure::Status::PartiallyDownloaded))
+            .arg(Enclosure::statusToDb(Enclosure::Status::Downloaded)));
+    Database::instance().execute(query);
+    while (query.next()) {
+        DataTypes::EntryDetails entryDetails;
+        entryDetails.entryuid = query.value(QStringLiteral("entryuid")).toLongLong();
+        entryDetails.feeduid = query.value(QStringLiteral("feeduid")).toLongLong();
+        entryDetails.id = query.value(QStringLiteral("id")).toString();
+        entryDetails.title = query.value(QStringLiteral("title")).toString();
+        entryDetails.content = query.value(QStringLiteral("content")).toString();
+        entryDetails.created = query.value(QStringLiteral("created")).toInt();
+        entryDetails.updated = query.value(QStringLiteral("updated")).toInt();
+        entryDetails.read = query.value(QStringLiteral("read")).toBool();
+        entryDetails.isNew = query.value(QStringLiteral("new")).toBool();
+        entryDetails.favorite = query.value(QStringLiteral("favorite")).toBool();
+        entryDetails.link = query.value(QStringLiteral("link")).toString();
+        entryDetails.hasEnclosure = query.value(QStringLiteral("hasEnclosure")).toBool();
+        entryDetails.image = query.value(QStringLiteral("image")).toString();
+        m_rows[entryDetails.entryuid] = m_entries.count();
+        m_entries += entryDetails;
+        m_feedNames += query.value(QStringLiteral("Feeds.name")).toString();
+
+        QueueDetails queueDetails;
+        if (!query.value(QStringLiteral("queueState")).isNull()) {
+            queueDetails.state = query.value(QStringLiteral("queueState")).toInt();
+            queueDetails.priority = query.value(QStringLiteral("queuePriority")).toInt();
+            queueDetails.bytesDone = query.value(QStringLiteral("queueBytesDone")).toLongLong();
+        }
+        m_queueDetails += queueDetails;
+    }
+}
+
+void DownloadModel::updateQueueDetails(const QSet<qint64> &entryuids)
+{
+    QStringList uids;
+    for (const qint64 entryuid : entryuids) {
+        uids += QString::number(entryuid);
+    }
+
+    QHash<qint64, QueueDetails> queueDetails;
+    QSqlQuery query;
+    query.prepare(QStringLiteral("SELECT entryuid, state, priority, bytesDone FROM DownloadQueue WHERE entryuid IN (%1);").arg(uids.join(QLatin1Char(','))));
+    Database::instance().execute(query);
+    while (query.next()) {
+        queueDetails[query.value(QStringLiteral("entryuid")).toLongLong()] = QueueDetails{query.value(QStringLiteral("state")).toInt(),
+                                                                                          query.value(QStringLiteral("priority")).toInt(),
+                                                                                          query.value(QStringLiteral("bytesDone")).toLongLong()};
+    }
+
+    // entries that have been removed from the queue get the default values
+    for (const qint64 entryuid : entryuids) {
+        const auto row = m_rows.constFind(entryuid);
+        if (row == m_rows.constEnd()) {
+            continue; // rows are added and removed when the enclosure status changes
         }
+        m_queueDetails[row.value()] = queueDetails.value(entryuid);
+        const QModelIndex changedIndex = index(row.value(), 0);
+        Q_EMIT dataChanged(changedIndex, changedIndex, {Roles::DownloadQueueStateRole, Roles::DownloadPriorityRole, Roles::BytesDoneRole});
     }
 }
 
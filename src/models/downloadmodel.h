@@ -10,10 +10,12 @@
 #include <QHash>
 #include <QItemSelection>
 #include <QObject>
+#include <QSet>
 #include <QQmlEngine>
 #include <QVariant>
 
 #include "datatypes.h"
+#include "models/abstractepisodemodel.h"
 
 class DownloadModel : public QAbstractListModel
 {
@@ -22,6 +24,13 @@ class DownloadModel : public QAbstractListModel
     QML_SINGLETON
 
 public:
+    enum Roles {
+        DownloadQueueStateRole = AbstractEpisodeModel::Roles::UpdatedRole + 1, // -1 if not in the download queue
+        DownloadPriorityRole,
+        BytesDoneRole,
+    };
+    Q_ENUM(Roles)
+
     static DownloadModel &instance()
     {
         static DownloadModel _instance;
@@ -46,7 +55,20 @@ private:
     explicit DownloadModel();
 
     void updateInternalState();
+    // only the queue roles of the affected rows change, so there is no need
+    // to reload the whole model
+    void updateQueueDetails(const QSet<qint64> &entryuids);
+
+    // the state of the download queue is retrieved together with the
+    // entries, such that it doesn't need to be looked up separately
+    struct QueueDetails {
+        int state = -1;
+        int priority = -1;
+        qint64 bytesDone = 0;
+    };
 
     QList<DataTypes::EntryDetails> m_entries;
     QStringList m_feedNames;
+    QList<QueueDetails> m_queueDetails;
+    QHash<qint64, int> m_rows; // key = entryuid
 };
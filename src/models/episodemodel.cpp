@@ -18,7 +18,9 @@ EpisodeModel::EpisodeModel(QObject *parent)
     // When feed is updated or removed, the entire model needs to be reset
     // because we cannot know where the new entries will be inserted into the
     // list (or that maybe even items have been removed.
-    connect(&DataManager::instance(), &DataManager::feedEntriesUpdated, this, [this]() {
+    // Feed updates are batched by DataManager, such that the model only gets
+    // reset once for all feeds that have been updated within the same window.
+    connect(&DataManager::instance(), &DataManager::feedsEntriesUpdated, this, [this]() {
         beginResetModel();
         updateInternalState();
         endResetModel();
@@ -0,0 +1,177 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "models/feedstatsmodel.h"
+
+#include <KLocalizedString>
+#include <QSqlQuery>
+
+#include "database.h"
+#include "datamanager.h"
+#include "datatypes.h"
+#include "fetcher.h"
+
+FeedStatsModel::FeedStatsModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    connect(&Fetcher::instance(), &Fetcher::updatingChanged, this, [this](bool state) {
+        if (!state) {
+            refresh();
+        }
+    });
+    connect(&DataManager::instance(), &DataManager::feedRemoved, this, &FeedStatsModel::refresh);
+
+    refresh();
+}
+
+QVariant FeedStatsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_stats.count()) {
+        return QVariant();
+    }
+
+    const FeedStatsSummary &stats = m_stats[index.row()];
+    const qint64 networkTime = stats.lookupTime + stats.connectTime + stats.firstByteTime + stats.downloadTime;
+    switch (role) {
+    case FeeduidRole:
+        return stats.feeduid;
+    case NameRole:
+        return stats.name;
+    case UrlRole:
+        return stats.url;
+    case RunsRole:
+        return stats.runs;
+    case FailuresRole:
+        return stats.failures;
+    case LastOutcomeRole:
+        return outcomeString(stats.lastOutcome);
+    case TotalTimeRole:
+        return networkTime + stats.parseTime + stats.processTime + stats.writeTime;
+    case NetworkTimeRole:
+        return networkTime;
+    case LookupTimeRole:
+        return stats.lookupTime;
+    case ConnectTimeRole:
+        return stats.connectTime;
+    case FirstByteTimeRole:
+        return stats.firstByteTime;
+    case DownloadTimeRole:
+        return stats.downloadTime;
+    case BytesRole:
+        return stats.bytes;
+    case FormattedBytesRole:
+        return m_kformat.formatByteSize(stats.bytes);
+    case ParseTimeRole:
+        return stats.parseTime;
+    case ProcessTimeRole:
+        return stats.processTime;
+    case WriteTimeRole:
+        return stats.writeTime;
+    case ItemsRole:
+        return stats.items;
+    case ProcessedItemsRole:
+        return stats.processedItems;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> FeedStatsModel::roleNames() const
+{
+    return {
+        {FeeduidRole, "feeduid"},
+        {NameRole, "name"},
+        {UrlRole, "url"},
+        {RunsRole, "runs"},
+        {FailuresRole, "failures"},
+        {LastOutcomeRole, "lastOutcome"},
+        {TotalTimeRole, "totalTime"},
+        {NetworkTimeRole, "networkTime"},
+        {LookupTimeRole, "lookupTime"},
+        {ConnectTimeRole, "connectTime"},
+        {FirstByteTimeRole, "firstByteTime"},
+        {DownloadTimeRole, "downloadTime"},
+        {BytesRole, "bytes"},
+        {FormattedBytesRole, "formattedBytes"},
+        {ParseTimeRole, "parseTime"},
+        {ProcessTimeRole, "processTime"},
+        {WriteTimeRole, "writeTime"},
+        {ItemsRole, "items"},
+        {ProcessedItemsRole, "processedItems"},
+    };
+}
+
+int FeedStatsModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_stats.count();
+}
+
+void FeedStatsModel::refresh()
+{
+    beginResetModel();
+    m_stats.clear();
+
+    QSqlQuery query;
+    query.prepare(
+        QStringLiteral("SELECT FeedStats.feeduid, Feeds.name, Feeds.url, COUNT(*) AS runs, SUM(outcome=:failed) AS failures, "
+                       "(SELECT outcome FROM FeedStats AS Last WHERE Last.feeduid=FeedStats.feeduid ORDER BY Last.rowid DESC LIMIT 1) AS lastOutcome, "
+                       "AVG(lookupTime) AS lookupTime, AVG(connectTime) AS connectTime, AVG(firstByteTime) AS firstByteTime, AVG(downloadTime) AS downloadTime, "
+                       "AVG(bytes) AS bytes, AVG(parseTime) AS parseTime, AVG(processTime) AS processTime, AVG(writeTime) AS writeTime, AVG(items) AS items, "
+                       "AVG(processedItems) AS processedItems, "
+                       "AVG(lookupTime + connectTime + firstByteTime + downloadTime + parseTime + processTime + writeTime) AS totalTime "
+                       "FROM FeedStats JOIN Feeds ON Feeds.feeduid=FeedStats.feeduid GROUP BY FeedStats.feeduid ORDER BY totalTime DESC;"));
+    query.bindValue(QStringLiteral(":failed"), static_cast<int>(DataTypes::UpdateFailed));
+    Database::instance().execute(query);
+    while (query.next()) {
+        FeedStatsSummary stats;
+        stats.feeduid = query.value(QStringLiteral("feeduid")).toLongLong();
+        stats.name = query.value(QStringLiteral("name")).toString();
+        stats.url = query.value(QStringLiteral("url")).toString();
+        stats.runs = query.value(QStringLiteral("runs")).toInt();
+        stats.failures = query.value(QStringLiteral("failures")).toInt();
+        stats.lastOutcome = query.value(QStringLiteral("lastOutcome")).toInt();
+        stats.lookupTime = qRound64(query.value(QStringLiteral("lookupTime")).toDouble());
+        stats.connectTime = qRound64(query.value(QStringLiteral("connectTime")).toDouble());
+        stats.firstByteTime = qRound64(query.value(QStringLiteral("firstByteTime")).toDouble());
+        stats.downloadTime = qRound64(query.value(QStringLiteral("downloadTime")).toDouble());
+        stats.bytes = qRound64(query.value(QStringLiteral("bytes")).toDouble());
+        stats.parseTime = qRound64(query.value(QStringLiteral("parseTime")).toDouble());
+        stats.processTime = qRound64(query.value(QStringLiteral("processTime")).toDouble());
+        stats.writeTime = qRound64(query.value(QStringLiteral("writeTime")).toDouble());
+        stats.items = qRound(query.value(QStringLiteral("items")).toDouble());
+        stats.processedItems = qRound(query.value(QStringLiteral("processedItems")).toDouble());
+        m_stats += stats;
+    }
+
+    endResetModel();
+}
+
+void FeedStatsModel::clearAll()
+{
+    QSqlQuery query;
+    query.prepare(QStringLiteral("DELETE FROM FeedStats;"));
+    Database::instance().execute(query);
+
+    refresh();
+}
+
+QString FeedStatsModel::outcomeString(const int outcome) const
+{
+    switch (outcome) {
+    case DataTypes::UpdateNotModified:
+        return i18nc("@info Outcome of a podcast update", "Not modified");
+    case DataTypes::UpdateUnchanged:
+        return i18nc("@info Outcome of a podcast update", "Unchanged");
+    case DataTypes::UpdateParseFailed:
+        return i18nc("@info Outcome of a podcast update", "Could not be parsed");
+    case DataTypes::UpdateProcessed:
+        return i18nc("@info Outcome of a podcast update", "Updated");
+    case DataTypes::UpdateFailed:
+    default:
+        return i18nc("@info Outcome of a podcast update", "Download failed");
+    }
+}
@@ -0,0 +1,82 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <KFormat>
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+#include <QQmlEngine>
+#include <QString>
+#include <QVariant>
+
+// Aggregated update metrics per feed, based on the most recent update runs
+// stored in the FeedStats table.  The feeds are sorted by their average
+// update cost, with the most expensive feeds first.
+class FeedStatsModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+public:
+    enum Roles {
+        FeeduidRole = Qt::UserRole,
+        NameRole,
+        UrlRole,
+        RunsRole,
+        FailuresRole,
+        LastOutcomeRole,
+        TotalTimeRole,
+        NetworkTimeRole,
+        LookupTimeRole,
+        ConnectTimeRole,
+        FirstByteTimeRole,
+        DownloadTimeRole,
+        BytesRole,
+        FormattedBytesRole,
+        ParseTimeRole,
+        ProcessTimeRole,
+        WriteTimeRole,
+        ItemsRole,
+        ProcessedItemsRole,
+    };
+    Q_ENUM(Roles)
+
+    explicit FeedStatsModel(QObject *parent = nullptr);
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    int rowCount(const QModelIndex &parent) const override;
+
+    Q_INVOKABLE void refresh();
+    Q_INVOKABLE void clearAll();
+
+private:
+    struct FeedStatsSummary {
+        qint64 feeduid;
+        QString name;
+        QString url;
+        int runs;
+        int failures;
+        int lastOutcome;
+        // averages over the stored runs; times are in milliseconds
+        qint64 lookupTime;
+        qint64 connectTime;
+        qint64 firstByteTime;
+        qint64 downloadTime;
+        qint64 bytes;
+        qint64 parseTime;
+        qint64 processTime;
+        qint64 writeTime;
+        int items;
+        int processedItems;
+    };
+
+    QString outcomeString(const int outcome) const;
+
+    QList<FeedStatsSummary> m_stats;
+    KFormat m_kformat;
+};
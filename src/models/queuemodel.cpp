@@ -10,6 +10,7 @@
 #include <QThread>
 
 #include <KFormat>
+#include <QSet>
 #include <QSqlQuery>
 #include <qabstractitemmodel.h>
 #include <qhashfunctions.h>
@@ -114,13 +115,20 @@ void QueueModel::addToQueue(const QList<qint64> &entryuids)
 {
     const qint64 beginQueueIndex = m_queue.count();
 
-    // Figure out how many entries actually have to be added (excluding the ones already in the queue)
-    qint64 endQueueIndex = beginQueueIndex - 1;
+    // Figure out which entries actually have to be added (excluding the ones
+    // already in the queue); use a set since both lists can be long
+    QSet<qint64> queued(m_queue.cbegin(), m_queue.cend());
+    QList<qint64> toAdd;
     for (const qint64 entryuid : std::as_const(entryuids)) {
-        if (!m_queue.contains(entryuid)) {
-            ++endQueueIndex;
+        if (!queued.contains(entryuid)) {
+            queued.insert(entryuid);
+            toAdd += entryuid;
         }
     }
+    if (toAdd.isEmpty()) {
+        return;
+    }
+    const qint64 endQueueIndex = beginQueueIndex + toAdd.count() - 1;
 
     beginInsertRows(QModelIndex(), beginQueueIndex, endQueueIndex);
 
@@ -128,20 +136,17 @@ void QueueModel::addToQueue(const QList<qint64> &entryuids)
     Database::instance().transaction();
     QSqlQuery query;
     query.prepare(QStringLiteral("INSERT INTO Queue (listnr, entryuid, playing) VALUES (:listnr, :entryuid, :playing);"));
-    for (const qint64 entryuid : std::as_const(entryuids)) {
-        // If item is already in queue, then don't do anything
-        if (!m_queue.contains(entryuid)) {
-            ++currentQueueIndex; // Increment index first because it's needed as listnr in the database
+    for (const qint64 entryuid : std::as_const(toAdd)) {
+        ++currentQueueIndex; // Increment index first because it's needed as listnr in the database
 
-            // Add to Queue database
-            query.bindValue(QStringLiteral(":listnr"), currentQueueIndex);
-            query.bindValue(QStringLiteral(":entryuid"), entryuid);
-            query.bindValue(QStringLiteral(":playing"), false);
-            Database::instance().execute(query);
+        // Add to Queue database
+        query.bindValue(QStringLiteral(":listnr"), currentQueueIndex);
+        query.bindValue(QStringLiteral(":entryuid"), entryuid);
+        query.bindValue(QStringLiteral(":playing"), false);
+        Database::instance().execute(query);
 
-            // Add to internal queuemap data structure
-            m_queue += entryuid;
-        }
+        // Add to internal queuemap data structure
+        m_queue += entryuid;
     }
     Database::instance().commit();
 
@@ -154,18 +159,37 @@ void QueueModel::addToQueue(const QList<qint64> &entryuids)
 
 void QueueModel::removeFromQueue(const QList<qint64> &entryuids)
 {
+    Database::instance().transaction();
+    QSqlQuery query;
+    query.prepare(QStringLiteral("DELETE FROM Queue WHERE entryuid=:entryuid;"));
+    for (const qint64 entryuid : std::as_const(entryuids)) {
+        // If item is not in queue then don't do anything
+        if (m_queue.contains(entryuid)) {
+            query.bindValue(QStringLiteral(":entryuid"), entryuid);
+            Database::instance().execute(query);
+        }
+    }
+    Database::instance().commit();
+
+    removedFromQueue(entryuids);
+}
+
+void QueueModel::removedFromQueue(const QList<qint64> &entryuids)
+{
+    const QSet<qint64> removed(entryuids.cbegin(), entryuids.cend());
+
     // As long as the amount of items to be removed is low, we can use beginRemoveRows
     // Otherwise we use resetModel
-    bool useResetModel = entryuids.count() > 50;
+    bool useResetModel = removed.count() > 50;
 
     // First we check whether the currently playing track needs to be removed
     // and, if so, skip to the next track on the queue that isn't going to be
     // removed either.
-    if (entryuids.contains(AudioManager::instance().entryuid())) {
+    if (removed.contains(AudioManager::instance().entryuid())) {
         qint64 index = m_queue.indexOf(AudioManager::instance().entryuid()) + 1;
         Q_ASSERT(index > -1);
 
-        while (index < m_queue.count() && entryuids.contains(m_queue[index])) {
+        while (index < m_queue.count() && removed.contains(m_queue[index])) {
             ++index;
         }
 
@@ -180,47 +204,27 @@ void QueueModel::removeFromQueue(const QList<qint64> &entryuids)
 
     if (useResetModel) {
         beginResetModel();
-    }
-
-    Database::instance().transaction();
-    QSqlQuery query;
-    query.prepare(QStringLiteral("DELETE FROM Queue WHERE entryuid=:entryuid;"));
-    // doing a reverse loop here to avoid constantly resetting the currently playing track, which is expensive
-    for (auto i = entryuids.rbegin(); i != entryuids.rend(); ++i) {
-        qint64 entryuid = *i;
-        // If item is not in queue then don't do anything
-        if (m_queue.contains(entryuid)) {
-            const int index = m_queue.indexOf(entryuid);
-            qCDebug(kastsQueueModel) << "m_queue is now:" << m_queue;
-            qCDebug(kastsQueueModel) << "Queue index of item to be removed" << index;
-
-            if (!useResetModel) {
+        m_queue.removeIf([&removed](const qint64 entryuid) {
+            return removed.contains(entryuid);
+        });
+        endResetModel();
+    } else {
+        // doing a reverse loop here to avoid constantly resetting the currently playing track, which is expensive
+        for (auto i = entryuids.rbegin(); i != entryuids.rend(); ++i) {
+            const int index = m_queue.indexOf(*i);
+            // If item is not in queue then don't do anything
+            if (index > -1) {
+                qCDebug(kastsQueueModel) << "Queue index of item to be removed" << index;
                 beginRemoveRows(QModelIndex(), index, index);
-            }
-
-            // Remove the item from the internal data structure
-            m_queue.removeAt(index);
-
-            // Then make sure that the database Queue table reflects these changes
-            query.bindValue(QStringLiteral(":entryuid"), entryuid);
-            Database::instance().execute(query);
-
-            qCDebug(kastsQueueModel) << "Removed entry at index" << index;
-            qCDebug(kastsQueueModel) << "queueCount is" << m_queue.count();
-
-            if (!useResetModel) {
+                m_queue.removeAt(index);
                 endRemoveRows();
             }
         }
     }
-    Database::instance().commit();
 
+    // Then make sure that the database Queue table reflects these changes
     updateQueueListnrs();
 
-    if (useResetModel) {
-        endResetModel();
-    }
-
     qCDebug(kastsQueueModel) << "m_queue is now:" << m_queue;
     Q_EMIT timeLeftChanged();
 }
@@ -50,6 +50,9 @@ public:
 
     void addToQueue(const QList<qint64> &entryuids);
     void removeFromQueue(const QList<qint64> &entryuids);
+    // only updates the model for entries that have already been deleted from
+    // the Queue table, see DataManager::markPlayed
+    void removedFromQueue(const QList<qint64> &entryuids);
     Q_INVOKABLE void moveQueueItem(const qint64 from, const qint64 to);
 
     // TODO: check if any of these can be made private after refactor
@@ -57,6 +57,17 @@ Kirigami.ScrollablePage {
             icon.name: "search"
             text: KI18n.i18nc("@action:intoolbar", "Search")
             checkable: true
+        },
+        Kirigami.Action {
+            // This works directly on the database and therefore ignores the
+            // search filter; only offer it when no search is active
+            text: KI18n.i18nc("@action:inmenu Mark all episodes matching the current filter as played", "Mark All as Played")
+            icon.name: "checkmark"
+            displayHint: Kirigami.DisplayHint.AlwaysHide
+            visible: episodeProxyModel.searchFilter === "" && episodeList.count > 0
+            onTriggered: {
+                DataManager.markAllPlayed(episodeProxyModel.filterType);
+            }
         }
     ]
 
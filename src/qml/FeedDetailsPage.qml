@@ -178,6 +178,13 @@ Kirigami.ScrollablePage {
                                 }
                             }
                         },
+                        Kirigami.Action {
+                            visible: root.isSubscribed
+                            icon.name: "checkmark"
+                            text: KI18n.i18nc("@action:intoolbar Mark all episodes of this podcast as played", "Mark All as Played")
+                            displayHint: Kirigami.DisplayHint.AlwaysHide
+                            onTriggered: DataManager.markFeedPlayed(root.feed.feeduid)
+                        },
                         Kirigami.Action {
                             icon.name: "documentinfo"
                             text: KI18n.i18n("Show Details")
@@ -205,6 +212,31 @@ Kirigami.ScrollablePage {
                 Layout.fillWidth: true
             }
 
+            // state of failed updates
+            Kirigami.InlineMessage {
+                Layout.fillWidth: true
+                Layout.margins: Kirigami.Units.smallSpacing
+                visible: root.isSubscribed && (root.feed.updatesPaused || root.feed.updateFailureCount > 0)
+                type: root.feed.updatesPaused ? Kirigami.MessageType.Error : Kirigami.MessageType.Warning
+                text: {
+                    if (!root.isSubscribed) {
+                        return "";
+                    } else if (root.feed.updatesPaused) {
+                        return KI18n.i18ncp("@info", "Updates of this podcast have been paused after %1 failed update.", "Updates of this podcast have been paused after %1 consecutive failed updates.", root.feed.updateFailureCount);
+                    } else {
+                        return KI18n.i18ncp("@info", "The last update of this podcast failed. It will be retried after %2.", "The last %1 updates of this podcast failed. It will be retried after %2.", root.feed.updateFailureCount, root.feed.retryAfter.toLocaleString(Qt.locale(), Locale.ShortFormat));
+                    }
+                }
+                actions: [
+                    Kirigami.Action {
+                        icon.name: "media-playback-start"
+                        text: KI18n.i18nc("@action:button", "Resume Updates")
+                        visible: root.isSubscribed && root.feed.updatesPaused
+                        onTriggered: root.feed.resumeUpdates()
+                    }
+                ]
+            }
+
             // podcast description
             Controls.Control {
                 Layout.fillHeight: !root.isSubscribed
@@ -98,6 +98,11 @@ Kirigami.ApplicationWindow {
                 Fetcher.fetchAll();
             }
         }
+
+        // Resume episode downloads that were interrupted when Kasts was closed
+        if (NetworkConnectionManager.episodeDownloadsAllowed) {
+            DataManager.resumeEnclosureDownloads();
+        }
     }
 
     Component.onDestruction: {
@@ -0,0 +1,86 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+import QtQuick
+import QtQuick.Controls as Controls
+import QtQuick.Layouts
+
+import org.kde.kirigami as Kirigami
+import org.kde.kirigamiaddons.formcard as FormCard
+import org.kde.ki18n
+
+import org.kde.kasts
+
+FormCard.FormCardPage {
+    id: root
+
+    title: KI18n.i18nc("@title:menu Category in settings", "Update Statistics")
+
+    actions: [
+        Kirigami.Action {
+            icon.name: "view-refresh"
+            text: KI18n.i18nc("@action:button", "Refresh")
+            onTriggered: feedStatsModel.refresh()
+        },
+        Kirigami.Action {
+            icon.name: "edit-clear-all"
+            text: KI18n.i18nc("@action:button", "Clear All")
+            onTriggered: feedStatsModel.clearAll()
+            enabled: statsRepeater.count > 0
+        }
+    ]
+
+    FeedStatsModel {
+        id: feedStatsModel
+    }
+
+    FormCard.FormHeader {
+        Layout.fillWidth: true
+        title: KI18n.i18nc("@title Form header", "Average update cost per podcast, most expensive first")
+    }
+
+    FormCard.FormCard {
+        Layout.fillWidth: true
+
+        FormCard.FormTextDelegate {
+            visible: statsRepeater.count === 0
+            text: KI18n.i18n("No podcast updates recorded yet")
+        }
+
+        Repeater {
+            id: statsRepeater
+            model: feedStatsModel
+
+            delegate: FormCard.FormTextDelegate {
+                required property string name
+                required property int runs
+                required property int failures
+                required property string lastOutcome
+                required property int totalTime
+                required property int lookupTime
+                required property int connectTime
+                required property int firstByteTime
+                required property int downloadTime
+                required property string formattedBytes
+                required property int parseTime
+                required property int processTime
+                required property int writeTime
+                required property int items
+                required property int processedItems
+
+                text: name
+                textItem.wrapMode: Text.Wrap
+                description: KI18n.i18nc("@info Average timings of podcast updates; times in milliseconds",
+                                         "Total: %1 ms · Lookup: %2 ms · Connect: %3 ms · First byte: %4 ms · Download: %5 ms (%6) · Parse: %7 ms · Process: %8 ms · Write: %9 ms",
+                                         totalTime, lookupTime, connectTime, firstByteTime, downloadTime, formattedBytes, parseTime, processTime, writeTime)
+                        + "\n"
+                        + KI18n.i18ncp("@info", "%2 of %3 items processed · last result: %4 · %5 failures in %1 update", "%2 of %3 items processed · last result: %4 · %5 failures in %1 updates",
+                                       runs, processedItems, items, lastOutcome, failures)
+                descriptionItem.wrapMode: Text.Wrap
+            }
+        }
+    }
+}
@@ -174,6 +174,17 @@ FormCard.FormCardPage {
             }
         }
 
+        FormCard.FormSwitchDelegate {
+            id: adaptiveFeedUpdates
+            enabled: SettingsManager.autoFeedUpdateInterval > 0
+            checked: SettingsManager.adaptiveFeedUpdates
+            text: KI18n.i18nc("@option:check", "Check podcasts that rarely publish new episodes less often")
+            onToggled: {
+                SettingsManager.adaptiveFeedUpdates = checked;
+                SettingsManager.save();
+            }
+        }
+
         FormCard.FormSwitchDelegate {
             id: refreshOnStartup
             checked: SettingsManager.refreshOnStartup
@@ -46,6 +46,167 @@ FormCard.FormCardPage {
                 }
             }
         }
+
+        FormCard.FormDelegateSeparator {}
+
+        FormCard.FormTextDelegate {
+            id: episodeDownloadConnections
+            text: KI18n.i18nc("@label:spinbox", "Number of connections per episode download")
+            description: KI18n.i18nc("@info:tooltip", "Using several connections can speed up downloads from servers that limit the speed per connection")
+            textItem.wrapMode: Text.Wrap
+            trailing: Controls.SpinBox {
+                Layout.rightMargin: Kirigami.Units.gridUnit
+                value: SettingsManager.episodeDownloadConnections
+                from: 1
+                to: 8
+                onValueModified: {
+                    SettingsManager.episodeDownloadConnections = value;
+                    SettingsManager.save();
+                }
+            }
+        }
+
+        FormCard.FormDelegateSeparator {}
+
+        FormCard.FormTextDelegate {
+            id: maximumDownloadRate
+            text: KI18n.i18nc("@label:spinbox", "Maximum total download speed (KiB/s)")
+            description: KI18n.i18nc("@info:tooltip", "0 means unlimited; the episode that is currently playing gets the largest share")
+            textItem.wrapMode: Text.Wrap
+            trailing: Controls.SpinBox {
+                Layout.rightMargin: Kirigami.Units.gridUnit
+                value: SettingsManager.maximumDownloadRate
+                from: 0
+                to: 1000000
+                stepSize: 64
+                editable: true
+                onValueModified: {
+                    SettingsManager.maximumDownloadRate = value;
+                    SettingsManager.save();
+                }
+            }
+        }
+
+        FormCard.FormDelegateSeparator {}
+
+        FormCard.FormTextDelegate {
+            id: maximumEpisodeDownloadRate
+            text: KI18n.i18nc("@label:spinbox", "Maximum download speed per episode (KiB/s)")
+            description: KI18n.i18nc("@info:tooltip", "0 means unlimited")
+            textItem.wrapMode: Text.Wrap
+            trailing: Controls.SpinBox {
+                Layout.rightMargin: Kirigami.Units.gridUnit
+                value: SettingsManager.maximumEpisodeDownloadRate
+                from: 0
+                to: 1000000
+                stepSize: 64
+                editable: true
+                onValueModified: {
+                    SettingsManager.maximumEpisodeDownloadRate = value;
+                    SettingsManager.save();
+                }
+            }
+        }
+
+        FormCard.FormDelegateSeparator {}
+
+        FormCard.FormSwitchDelegate {
+            id: restrictBulkDownloads
+            checked: SettingsManager.restrictBulkDownloads
+            text: KI18n.i18nc("@option:check", "Only start automatic and bulk episode downloads within a time window")
+            onToggled: {
+                SettingsManager.restrictBulkDownloads = checked;
+                SettingsManager.save();
+            }
+        }
+
+        FormCard.FormTextDelegate {
+            id: bulkDownloadStartHour
+            visible: SettingsManager.restrictBulkDownloads
+            text: KI18n.i18nc("@label:spinbox", "Time window starts at hour")
+            textItem.wrapMode: Text.Wrap
+            trailing: Controls.SpinBox {
+                Layout.rightMargin: Kirigami.Units.gridUnit
+                value: SettingsManager.bulkDownloadStartHour
+                from: 0
+                to: 23
+                onValueModified: {
+                    SettingsManager.bulkDownloadStartHour = value;
+                    SettingsManager.save();
+                }
+            }
+        }
+
+        FormCard.FormTextDelegate {
+            id: bulkDownloadEndHour
+            visible: SettingsManager.restrictBulkDownloads
+            text: KI18n.i18nc("@label:spinbox", "Time window ends at hour")
+            textItem.wrapMode: Text.Wrap
+            trailing: Controls.SpinBox {
+                Layout.rightMargin: Kirigami.Units.gridUnit
+                value: SettingsManager.bulkDownloadEndHour
+                from: 0
+                to: 23
+                onValueModified: {
+                    SettingsManager.bulkDownloadEndHour = value;
+                    SettingsManager.save();
+                }
+            }
+        }
+
+        FormCard.FormDelegateSeparator {}
+
+        FormCard.FormTextDelegate {
+            id: maximumFeedUpdates
+            text: KI18n.i18nc("@label:spinbox", "Maximum number of parallel podcast updates")
+            textItem.wrapMode: Text.Wrap
+            trailing: Controls.SpinBox {
+                Layout.rightMargin: Kirigami.Units.gridUnit
+                value: SettingsManager.maximumParallelFeedUpdates
+                from: 1
+                to: 32
+                onValueModified: {
+                    SettingsManager.maximumParallelFeedUpdates = value;
+                    SettingsManager.save();
+                }
+            }
+        }
+
+        FormCard.FormDelegateSeparator {}
+
+        FormCard.FormTextDelegate {
+            id: maximumFeedUpdatesPerHost
+            text: KI18n.i18nc("@label:spinbox", "Maximum number of parallel podcast updates from the same server")
+            textItem.wrapMode: Text.Wrap
+            trailing: Controls.SpinBox {
+                Layout.rightMargin: Kirigami.Units.gridUnit
+                value: SettingsManager.maximumParallelFeedUpdatesPerHost
+                from: 1
+                to: 8
+                onValueModified: {
+                    SettingsManager.maximumParallelFeedUpdatesPerHost = value;
+                    SettingsManager.save();
+                }
+            }
+        }
+
+        FormCard.FormDelegateSeparator {}
+
+        FormCard.FormTextDelegate {
+            id: maximumFeedUpdateFailures
+            text: KI18n.i18nc("@label:spinbox", "Pause podcast updates after this number of consecutive failures (0 means never)")
+            textItem.wrapMode: Text.Wrap
+            trailing: Controls.SpinBox {
+                Layout.rightMargin: Kirigami.Units.gridUnit
+                value: SettingsManager.maximumFeedUpdateFailures
+                from: 0
+                to: 100
+                onValueModified: {
+                    SettingsManager.maximumFeedUpdateFailures = value;
+                    SettingsManager.save();
+                }
+            }
+        }
     }
 
     FormCard.FormHeader {
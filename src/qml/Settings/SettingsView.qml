@@ -48,6 +48,12 @@ KirigamiSettings.ConfigurationView {
             icon.name: "error"
             page: () => Qt.createComponent("org.kde.kasts", "ErrorListPage")
         },
+        KirigamiSettings.ConfigurationModule {
+            moduleId: "Update Statistics"
+            text: KI18n.i18nc("@title:menu Category in settings", "Update Statistics")
+            icon.name: "view-statistics"
+            page: () => Qt.createComponent("org.kde.kasts", "FeedStatsPage")
+        },
         KirigamiSettings.ConfigurationModule {
             moduleId: "aboutKasts"
             text: KI18n.i18nc("@title:menu Category in settings", "About Kasts")
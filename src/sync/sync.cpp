@@ -974,6 +974,29 @@ void Sync::storeRemoveFeedAction(const qint64 &feeduid)
     }
 }
 
+void Sync::storeChangeFeedUrlAction(const qint64 &feeduid, const QString &oldUrl, const QString &newUrl)
+{
+    // gpodder has no notion of a subscription that moves, so this is stored
+    // as a removal of the old url and an addition of the new one
+    if (syncEnabled() && m_allowSyncActionLogging) {
+        Database::instance().transaction();
+        QSqlQuery query;
+        query.prepare(QStringLiteral("INSERT INTO FeedActions (feeduid, url, action, timestamp) VALUES (:feeduid, :url, :action, :timestamp);"));
+        query.bindValue(QStringLiteral(":feeduid"), feeduid);
+        query.bindValue(QStringLiteral(":url"), oldUrl);
+        query.bindValue(QStringLiteral(":action"), QStringLiteral("remove"));
+        query.bindValue(QStringLiteral(":timestamp"), QDateTime::currentSecsSinceEpoch());
+        Database::instance().execute(query);
+        query.bindValue(QStringLiteral(":feeduid"), feeduid);
+        query.bindValue(QStringLiteral(":url"), newUrl);
+        query.bindValue(QStringLiteral(":action"), QStringLiteral("add"));
+        query.bindValue(QStringLiteral(":timestamp"), QDateTime::currentSecsSinceEpoch());
+        Database::instance().execute(query);
+        Database::instance().commit();
+        qCDebug(kastsSync) << "Logged a feed url change for feeduid" << feeduid << "from" << oldUrl << "to" << newUrl;
+    }
+}
+
 void Sync::storePlayEpisodeActions(const QList<qint64> &entryuids, const QList<qint64> &startPositions, const QList<qint64> &endPositions)
 {
     Q_ASSERT(entryuids.count() == startPositions.count());
@@ -982,42 +1005,7 @@ void Sync::storePlayEpisodeActions(const QList<qint64> &entryuids, const QList<q
     if (syncEnabled() && m_allowSyncActionLogging) {
         Database::instance().transaction();
         QSqlQuery query;
-        query.prepare(
-            QStringLiteral("WITH Enclmin AS (SELECT "
-                           "    entryuid, "
-                           "    url, "
-                           "    CASE WHEN Enclosures.duration > 0 "
-                           "        THEN Enclosures.duration "
-                           "        ELSE 1 END AS durmin "
-                           "    FROM Enclosures)"
-                           "INSERT INTO EpisodeActions ("
-                           "    entryuid, "
-                           "    feeduid, "
-                           "    podcast, "
-                           "    url, "
-                           "    id, "
-                           "    action, "
-                           "    started, "
-                           "    position, "
-                           "    total, "
-                           "    durationdb,"
-                           "    timestamp) "
-                           "SELECT"
-                           "    Entries.entryuid, "
-                           "    Entries.feeduid, "
-                           "    Feeds.url, "
-                           "    Enclmin.url, "
-                           "    Entries.id, "
-                           "    :action, "
-                           "    :started,"
-                           "    :position, "
-                           "    Enclmin.durmin, "
-                           "    Enclmin.durmin, "
-                           "    :timestamp "
-                           "FROM Entries "
-                           "    JOIN Feeds ON Feeds.feeduid = Entries.feeduid "
-                           "    JOIN Enclmin ON Enclmin.entryuid = Entries.entryuid "
-                           "WHERE Entries.entryuid=:entryuid;"));
+        query.prepare(playEpisodeActionsStatement(QStringLiteral(":started"), QStringLiteral(":position"), QStringLiteral("Entries.entryuid=:entryuid")));
         for (qint64 i = 0; i < entryuids.count(); ++i) {
             const qulonglong started_sec = startPositions[i] / 1000; // convert to seconds
             const qulonglong position_sec = endPositions[i] / 1000; // convert to seconds
@@ -1041,41 +1029,7 @@ void Sync::storePlayedEpisodeActions(const QList<qint64> &entryuids)
         Database::instance().transaction();
         QSqlQuery query;
         query.prepare(
-            QStringLiteral("WITH Enclmin AS (SELECT "
-                           "    entryuid, "
-                           "    url, "
-                           "    CASE WHEN Enclosures.duration > 0 "
-                           "        THEN Enclosures.duration "
-                           "        ELSE 1 END AS durmin "
-                           "    FROM Enclosures)"
-                           "INSERT INTO EpisodeActions ("
-                           "    entryuid, "
-                           "    feeduid, "
-                           "    podcast, "
-                           "    url, "
-                           "    id, "
-                           "    action, "
-                           "    started, "
-                           "    position, "
-                           "    total, "
-                           "    durationdb, "
-                           "    timestamp) "
-                           "SELECT"
-                           "    Entries.entryuid, "
-                           "    Entries.feeduid, "
-                           "    Feeds.url, "
-                           "    Enclmin.url, "
-                           "    Entries.id, "
-                           "    :action, "
-                           "    Enclmin.durmin,"
-                           "    Enclmin.durmin,"
-                           "    Enclmin.durmin,"
-                           "    Enclmin.durmin,"
-                           "    :timestamp "
-                           "FROM Entries "
-                           "    JOIN Feeds ON Feeds.feeduid = Entries.feeduid "
-                           "    JOIN Enclmin ON Enclmin.entryuid = Entries.entryuid "
-                           "WHERE Entries.entryuid=:entryuid;"));
+            playEpisodeActionsStatement(QStringLiteral("Enclmin.durmin"), QStringLiteral("Enclmin.durmin"), QStringLiteral("Entries.entryuid=:entryuid")));
         for (const qint64 entryuid : entryuids) {
             query.bindValue(QStringLiteral(":entryuid"), entryuid);
             query.bindValue(QStringLiteral(":action"), QStringLiteral("play"));
@@ -1086,6 +1040,78 @@ void Sync::storePlayedEpisodeActions(const QList<qint64> &entryuids)
     }
 }
 
+void Sync::storeMarkPlayedEpisodeActions(const bool resetPositions)
+{
+    // Set-based version of storePlayEpisodeActions and
+    // storePlayedEpisodeActions for DataManager::markPlayed, using its
+    // temporary MarkPlayed table.  This runs inside the transaction of the
+    // caller, before the play positions are reset.
+    if (syncEnabled() && m_allowSyncActionLogging) {
+        QSqlQuery query;
+        if (resetPositions) {
+            // only the positions that actually change are logged
+            query.prepare(playEpisodeActionsStatement(
+                QStringLiteral("0"),
+                QStringLiteral("0"),
+                QStringLiteral("Entries.entryuid IN (SELECT entryuid FROM temp.MarkPlayed) AND Entries.entryuid IN (SELECT entryuid FROM Enclosures WHERE "
+                               "playposition!=0)")));
+            query.bindValue(QStringLiteral(":action"), QStringLiteral("play"));
+            query.bindValue(QStringLiteral(":timestamp"), QDateTime::currentSecsSinceEpoch());
+            Database::instance().execute(query);
+        }
+
+        query.prepare(playEpisodeActionsStatement(QStringLiteral("Enclmin.durmin"),
+                                                  QStringLiteral("Enclmin.durmin"),
+                                                  QStringLiteral("Entries.entryuid IN (SELECT entryuid FROM temp.MarkPlayed)")));
+        query.bindValue(QStringLiteral(":action"), QStringLiteral("play"));
+        query.bindValue(QStringLiteral(":timestamp"), QDateTime::currentSecsSinceEpoch());
+        Database::instance().execute(query);
+    }
+}
+
+QString Sync::playEpisodeActionsStatement(const QString &started, const QString &position, const QString &entryCondition)
+{
+    // a "played" action is a play action with both positions set to the end
+    // of the episode, i.e. Enclmin.durmin
+    return QStringLiteral(
+               "WITH Enclmin AS (SELECT "
+               "    entryuid, "
+               "    url, "
+               "    CASE WHEN Enclosures.duration > 0 "
+               "        THEN Enclosures.duration "
+               "        ELSE 1 END AS durmin "
+               "    FROM Enclosures)"
+               "INSERT INTO EpisodeActions ("
+               "    entryuid, "
+               "    feeduid, "
+               "    podcast, "
+               "    url, "
+               "    id, "
+               "    action, "
+               "    started, "
+               "    position, "
+               "    total, "
+               "    durationdb, "
+               "    timestamp) "
+               "SELECT"
+               "    Entries.entryuid, "
+               "    Entries.feeduid, "
+               "    Feeds.url, "
+               "    Enclmin.url, "
+               "    Entries.id, "
+               "    :action, "
+               "    %1, "
+               "    %2, "
+               "    Enclmin.durmin, "
+               "    Enclmin.durmin, "
+               "    :timestamp "
+               "FROM Entries "
+               "    JOIN Feeds ON Feeds.feeduid = Entries.feeduid "
+               "    JOIN Enclmin ON Enclmin.entryuid = Entries.entryuid "
+               "WHERE %3;")
+        .arg(started, position, entryCondition);
+}
+
 void Sync::retrieveAllLocalEpisodeStates()
 {
     QList<SyncUtils::EpisodeAction> actions;
@@ -97,7 +97,9 @@ public:
     // Next are some generic methods to store and apply local changes to be synced
     void storeAddFeedAction(const QString &url);
     void storeRemoveFeedAction(const qint64 &feeduid);
+    void storeChangeFeedUrlAction(const qint64 &feeduid, const QString &oldUrl, const QString &newUrl);
     void storePlayedEpisodeActions(const QList<qint64> &entryuids);
+    void storeMarkPlayedEpisodeActions(const bool resetPositions); // see DataManager::markPlayed
     void storePlayEpisodeActions(const QList<qint64> &entryuids, const QList<qint64> &startPositions, const QList<qint64> &endPositions);
     void applySubscriptionChangesLocally(const QStringList &addList, const QStringList &removeList);
     void applyEpisodeActionsLocally(const QHash<QString, QHash<qint64, SyncUtils::EpisodeAction>> &episodeActionHash);
@@ -133,6 +135,9 @@ private:
     void deletePasswordFromKeychain(const QString &username);
 
     void retrieveAllLocalEpisodeStates();
+    // statement storing play actions with the given start and end positions
+    // (SQL expressions in seconds) for the entries matching entryCondition
+    static QString playEpisodeActionsStatement(const QString &started, const QString &position, const QString &entryCondition);
     void onWriteDummyJobFinished(QKeychain::WritePasswordJob *writeDummyJob, const QString &username);
     void onWritePasswordJobFinished(QKeychain::WritePasswordJob *job, const QString &username, const QString &password);
     void onDeleteJobFinished(QKeychain::DeletePasswordJob *deleteJob, const QString &username);
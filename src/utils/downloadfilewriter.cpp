@@ -0,0 +1,168 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "downloadfilewriter.h"
+#include "enclosuredownloadlogging.h"
+
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#endif
+
+DownloadFileWriter *DownloadFileWriter::open(const QString &filename, const QIODevice::OpenMode mode)
+{
+    DownloadFileWriter *writer = new DownloadFileWriter(filename);
+
+    // the data is already handed over in large chunks, so there is no need
+    // for another buffer in between
+    if (!writer->m_file->open(mode | QIODevice::Unbuffered)) {
+        qCDebug(kastsEnclosureDownload) << "Cannot open" << filename << writer->m_file->errorString();
+        delete writer;
+        return nullptr;
+    }
+
+    writer->moveToThread(writerThread());
+    return writer;
+}
+
+DownloadFileWriter::DownloadFileWriter(const QString &filename)
+    : QObject(nullptr)
+    , m_file(new QFile(filename, this))
+{
+}
+
+void DownloadFileWriter::preallocate(const qint64 size, const bool keepSize)
+{
+    QMetaObject::invokeMethod(
+        this,
+        [this, size, keepSize]() {
+            if (m_failed) {
+                return;
+            }
+
+#ifdef Q_OS_LINUX
+            // reserving the space up front avoids fragmentation and finds out
+            // right away if the file doesn't fit on the disk
+            int result;
+            if (keepSize) {
+                result = (fallocate(m_file->handle(), FALLOC_FL_KEEP_SIZE, m_file->size(), size) == 0) ? 0 : errno;
+            } else {
+                result = posix_fallocate(m_file->handle(), 0, size);
+            }
+
+            if (result == 0) {
+                return;
+            } else if (result == ENOSPC) {
+                fail(qt_error_string(result));
+                return;
+            }
+            // e.g. not supported by the file system
+            qCDebug(kastsEnclosureDownload) << "Could not preallocate" << size << "bytes for" << m_file->fileName() << qt_error_string(result);
+#endif
+
+            if (!keepSize && !m_file->resize(size)) {
+                fail(m_file->errorString());
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+void DownloadFileWriter::write(const qint64 offset, const QByteArray &data)
+{
+    QMetaObject::invokeMethod(
+        this,
+        [this, offset, data]() {
+            if (m_failed) {
+                return;
+            }
+
+            if ((offset >= 0 && !m_file->seek(offset)) || m_file->write(data) != data.size()) {
+                fail(m_file->errorString());
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+void DownloadFileWriter::truncate()
+{
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            if (!m_failed && !m_file->resize(0)) {
+                fail(m_file->errorString());
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+void DownloadFileWriter::saveFile(const QString &filename, const QByteArray &data)
+{
+    QMetaObject::invokeMethod(
+        this,
+        [this, filename, data]() {
+            if (m_failed) {
+                return;
+            }
+
+            QSaveFile file(filename);
+            if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+                qCDebug(kastsEnclosureDownload) << "Could not write" << filename << file.errorString();
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+void DownloadFileWriter::close()
+{
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            m_file->close();
+            Q_EMIT closed(!m_failed, m_errorString);
+            deleteLater();
+        },
+        Qt::QueuedConnection);
+}
+
+void DownloadFileWriter::fail(const QString &errorString)
+{
+    qCDebug(kastsEnclosureDownload) << "Could not write to" << m_file->fileName() << errorString;
+    m_failed = true;
+    m_errorString = errorString;
+    Q_EMIT writeFailed(errorString);
+}
+
+QThread *DownloadFileWriter::writerThread()
+{
+    static QThread *thread = []() {
+        QThread *thread = new QThread(QCoreApplication::instance());
+        thread->setObjectName(QStringLiteral("DownloadFileWriter"));
+
+        // stop the thread only after everything that has been queued so far
+        // has been written, since the progress of interrupted downloads is
+        // derived from what is on disk
+        QObject *context = new QObject;
+        context->moveToThread(thread);
+        QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, thread, [thread, context]() {
+            QMetaObject::invokeMethod(
+                context,
+                [context]() {
+                    delete context;
+                    QThread::currentThread()->quit();
+                },
+                Qt::QueuedConnection);
+            thread->wait();
+        });
+
+        thread->start();
+        return thread;
+    }();
+    return thread;
+}
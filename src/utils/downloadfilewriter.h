@@ -0,0 +1,63 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QIODevice>
+#include <QObject>
+#include <QString>
+
+class QThread;
+
+// Writes the data of an enclosure download to disk.  The actual writes
+// happen in a worker thread that is shared by all downloads, such that slow
+// storage (e.g. SD cards or network shares) can't block the GUI thread.
+// All operations are queued and executed in the order in which they were
+// called.
+class DownloadFileWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    // opens filename in the calling thread and then moves the writer to the
+    // worker thread; returns nullptr if the file can't be opened
+    static DownloadFileWriter *open(const QString &filename, const QIODevice::OpenMode mode);
+
+    // reserves size bytes on disk; if keepSize is true, the space is reserved
+    // behind the current end of the file without changing its size
+    void preallocate(const qint64 size, const bool keepSize);
+
+    // writes data at offset; a negative offset writes at the current position
+    void write(const qint64 offset, const QByteArray &data);
+
+    // discards everything that has been written so far
+    void truncate();
+
+    // atomically replaces filename by data, e.g. to store progress that
+    // should only be written once the data it refers to is on disk
+    void saveFile(const QString &filename, const QByteArray &data);
+
+    // closes the file once everything has been written; the writer deletes
+    // itself after emitting closed()
+    void close();
+
+Q_SIGNALS:
+    void writeFailed(const QString &errorString);
+    void closed(const bool success, const QString &errorString);
+
+private:
+    explicit DownloadFileWriter(const QString &filename);
+
+    void fail(const QString &errorString);
+
+    static QThread *writerThread();
+
+    QFile *m_file;
+    bool m_failed = false;
+    QString m_errorString;
+};
@@ -0,0 +1,124 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "downloadratelimiter.h"
+#include "enclosuredownloadlogging.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "settingsmanager.h"
+
+DownloadRateLimiter::DownloadRateLimiter()
+    : QObject(nullptr)
+{
+    m_timer.setInterval(m_refillInterval);
+    connect(&m_timer, &QTimer::timeout, this, &DownloadRateLimiter::refill);
+}
+
+bool DownloadRateLimiter::isLimited() const
+{
+    return SettingsManager::self()->maximumDownloadRate() > 0 || SettingsManager::self()->maximumEpisodeDownloadRate() > 0;
+}
+
+void DownloadRateLimiter::addClient(const QObject *client, const Priority priority)
+{
+    m_clients.insert(client, Client{priority});
+
+    // the timer keeps running while there are downloads, such that changes
+    // of the settings are picked up right away
+    if (!m_timer.isActive()) {
+        m_lastRefill.start();
+        m_timer.start();
+    }
+}
+
+void DownloadRateLimiter::removeClient(const QObject *client)
+{
+    m_clients.remove(client);
+    if (m_clients.isEmpty()) {
+        m_timer.stop();
+    }
+}
+
+void DownloadRateLimiter::setPriority(const QObject *client, const Priority priority)
+{
+    auto it = m_clients.find(client);
+    if (it != m_clients.end()) {
+        qCDebug(kastsEnclosureDownload) << "Download priority of" << client << "changed to" << priority;
+        it->priority = priority;
+    }
+}
+
+qint64 DownloadRateLimiter::take(const QObject *client, const qint64 available)
+{
+    auto it = m_clients.find(client);
+    if (it == m_clients.end() || !isLimited()) {
+        return available;
+    }
+
+    const qint64 allowed = std::clamp(it->tokens, qint64(0), available);
+    it->tokens -= allowed;
+    if (allowed < available) {
+        it->waiting = true;
+    }
+    return allowed;
+}
+
+void DownloadRateLimiter::consume(const QObject *client, const qint64 bytes)
+{
+    auto it = m_clients.find(client);
+    if (it != m_clients.end() && isLimited()) {
+        it->tokens -= bytes; // paid back during the next refills
+    }
+}
+
+void DownloadRateLimiter::refill()
+{
+    const qint64 elapsed = m_lastRefill.restart();
+    const qint64 globalRate = SettingsManager::self()->maximumDownloadRate() * 1024; // bytes per second
+    const qint64 clientRate = SettingsManager::self()->maximumEpisodeDownloadRate() * 1024;
+
+    // only the downloads that actually wait for bandwidth get a share of it,
+    // such that bandwidth isn't wasted on downloads that are e.g. stalled
+    int totalWeight = 0;
+    for (const Client &client : std::as_const(m_clients)) {
+        if (client.waiting) {
+            totalWeight += weight(client.priority);
+        }
+    }
+
+    for (Client &client : m_clients) {
+        if (!client.waiting) {
+            continue;
+        }
+
+        qint64 share = std::numeric_limits<qint64>::max() / (2 * m_maxBurst);
+        if (globalRate > 0) {
+            share = globalRate * elapsed / 1000 * weight(client.priority) / totalWeight;
+        }
+        if (clientRate > 0) {
+            share = std::min(share, clientRate * elapsed / 1000);
+        }
+        client.tokens = std::min(client.tokens + share, m_maxBurst * share);
+        client.waiting = false;
+    }
+
+    Q_EMIT refilled();
+}
+
+int DownloadRateLimiter::weight(const Priority priority)
+{
+    switch (priority) {
+    case Bulk:
+        return 1;
+    case Normal:
+        return 4;
+    case Playback:
+        return 16;
+    }
+    return 1;
+}
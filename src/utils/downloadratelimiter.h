@@ -0,0 +1,73 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+// Token bucket that limits the bandwidth used by all episode downloads
+// together, as well as by every single download.  The bandwidth is divided
+// between the downloads that are waiting for it according to their priority,
+// such that e.g. the episode that is about to be played gets most of it.
+// Downloads are throttled by only reading as much from their network reply
+// as they're allowed to; Qt then stops reading from the socket once the
+// read buffer of the reply is full.
+class DownloadRateLimiter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        Bulk, // automatic downloads and downloads of several episodes at once
+        Normal,
+        Playback, // the episode that is currently loaded in the player
+    };
+    Q_ENUM(Priority)
+
+    static DownloadRateLimiter &instance()
+    {
+        static DownloadRateLimiter _instance;
+        return _instance;
+    }
+
+    bool isLimited() const;
+
+    void addClient(const QObject *client, const Priority priority);
+    void removeClient(const QObject *client);
+    void setPriority(const QObject *client, const Priority priority);
+
+    // returns how many of the available bytes the client may read right now
+    qint64 take(const QObject *client, const qint64 available);
+
+    // accounts for bytes that had to be read regardless of the budget, e.g.
+    // at the end of a reply
+    void consume(const QObject *client, const qint64 bytes);
+
+Q_SIGNALS:
+    // emitted whenever new bandwidth has been handed out
+    void refilled();
+
+private:
+    DownloadRateLimiter();
+
+    void refill();
+    static int weight(const Priority priority);
+
+    struct Client {
+        Priority priority;
+        qint64 tokens = 0;
+        bool waiting = false; // wanted to read more than it was allowed to
+    };
+    QHash<const QObject *, Client> m_clients;
+    QTimer m_timer;
+    QElapsedTimer m_lastRefill;
+
+    inline static const int m_refillInterval = 100; // milliseconds
+    inline static const int m_maxBurst = 5; // maximum amount of refills a client can save up
+};
@@ -7,13 +7,21 @@
 #include "enclosuredownloadjob.h"
 #include "enclosuredownloadlogging.h"
 
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QNetworkReply>
 #include <QTimer>
 
 #include <KLocalizedString>
 
+#include <algorithm>
+
+#include "downloadfilewriter.h"
 #include "fetcher.h"
 #include "objectslogging.h"
+#include "settingsmanager.h"
 
 EnclosureDownloadJob::EnclosureDownloadJob(const qint64 entryuid, const QString &url, const QString &filename, const QString &title, QObject *parent)
     : KJob(parent)
@@ -28,6 +36,7 @@ EnclosureDownloadJob::EnclosureDownloadJob(const qint64 entryuid, const QString
 
 EnclosureDownloadJob::~EnclosureDownloadJob()
 {
+    DownloadRateLimiter::instance().removeClient(this);
     qCDebug(kastsObjects) << "Destructed EnclosureDownloadJob" << m_entryuid << m_url;
 }
 
@@ -41,6 +50,29 @@ void EnclosureDownloadJob::startDownload()
     m_status = EnclosureDownloadJob::Status::Downloading;
     Q_EMIT statusChanged(m_status);
 
+    // TODO: do we really need the entry title only for the description which is not realy used otherwise?
+    Q_EMIT description(this, i18n("Downloading %1", m_title));
+
+    DownloadRateLimiter::instance().addClient(this, m_priority);
+    // read the data that has been left in the replies because of the bandwidth limit
+    connect(&DownloadRateLimiter::instance(), &DownloadRateLimiter::refilled, this, [this]() {
+        if (m_reply) {
+            writeReplyData(m_reply, -1);
+        }
+        for (int i = 0; i < m_segments.count(); ++i) {
+            readSegment(i);
+        }
+    });
+
+    if (useSegmentedDownload()) {
+        probeSegmentedDownload();
+    } else {
+        startSingleDownload();
+    }
+}
+
+void EnclosureDownloadJob::startSingleDownload()
+{
     m_reply = getNetworkReply(m_url, m_filename);
 
     if (!m_reply) {
@@ -50,93 +82,590 @@ void EnclosureDownloadJob::startDownload()
         return;
     }
 
-    // TODO: do we really need the entry title only for the description which is not realy used otherwise?
-    Q_EMIT description(this, i18n("Downloading %1", m_title));
-
     connect(m_reply, &QNetworkReply::downloadProgress, this, [this](qint64 received, qint64 total) {
         setProcessedAmount(Bytes, received);
         setTotalAmount(Bytes, total);
     });
 
     connect(m_reply, &QNetworkReply::finished, this, [this]() {
+        // the result is emitted once the writer has closed the file
+        writeReplyData(m_reply, -1);
         m_reply->deleteLater();
-        emitResult();
+        m_reply = nullptr;
+        m_writer->close();
     });
 
     connect(m_reply, &QNetworkReply::errorOccurred, this, [this](QNetworkReply::NetworkError code) {
-        setError(code);
-        setErrorText(m_reply->errorString());
+        if (error() == 0) {
+            setError(code);
+            setErrorText(m_reply->errorString());
+        }
     });
 }
 
-QNetworkReply *EnclosureDownloadJob::getNetworkReply(const QString &url, const QString &filePath) const
+QNetworkReply *EnclosureDownloadJob::getNetworkReply(const QString &url, const QString &filePath)
 {
-    QNetworkRequest request((QUrl(url)));
+    // skip the redirect chain if we've recently resolved it
+    const QUrl requestUrl = Fetcher::instance().cachedRedirect(QUrl(url));
+    QNetworkRequest request(requestUrl);
     request.setTransferTimeout();
 
-    bool fileOpenSuccess = false;
-
-    QFile *file = new QFile(filePath);
-    if (file->exists() && file->size() > 0) {
+    const QFileInfo fileInfo(filePath);
+    if (fileInfo.exists() && fileInfo.size() > 0) {
         // try to resume download
-        int resumedAt = file->size();
-        qCDebug(kastsEnclosureDownload) << "Resuming download at" << resumedAt << "bytes";
-        QByteArray rangeHeaderValue = QByteArray("bytes=") + QByteArray::number(resumedAt) + QByteArray("-");
+        m_resumedAt = fileInfo.size();
+        qCDebug(kastsEnclosureDownload) << "Resuming download at" << m_resumedAt << "bytes";
+        QByteArray rangeHeaderValue = QByteArray("bytes=") + QByteArray::number(m_resumedAt) + QByteArray("-");
         request.setRawHeader(QByteArray("Range"), rangeHeaderValue);
-        fileOpenSuccess = file->open(QIODevice::WriteOnly | QIODevice::Append);
+        // only resume if the file on the server is still the same one;
+        // otherwise the server sends the complete new file
+        const QString validator = (!m_etag.isEmpty() && !m_etag.startsWith(QStringLiteral("W/"))) ? m_etag : m_lastModified;
+        if (!validator.isEmpty()) {
+            request.setRawHeader("If-Range", validator.toLatin1());
+        }
+        m_writer = openWriter(filePath, QIODevice::WriteOnly | QIODevice::Append);
     } else {
         qCDebug(kastsEnclosureDownload) << "Starting new download";
-        fileOpenSuccess = file->open(QIODevice::WriteOnly);
+        m_writer = openWriter(filePath, QIODevice::WriteOnly);
     }
 
-    if (!fileOpenSuccess) {
+    if (!m_writer) {
         return nullptr;
     }
 
     QNetworkReply *reply = Fetcher::instance().get(request);
+    reply->setReadBufferSize(m_readBufferSize);
 
-    connect(reply, &QNetworkReply::readyRead, this, [=]() {
-        if (reply->isOpen() && file) {
-            QByteArray data = reply->readAll();
-            file->write(data);
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, reply]() {
+        const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (!m_writer || (statusCode != 200 && statusCode != 206)) {
+            return;
         }
-    });
 
-    connect(reply, &QNetworkReply::finished, this, [reply, url, file]() {
-        if (reply->isOpen() && file) {
-            QByteArray data = reply->readAll();
-            file->write(data);
-            file->close();
+        // remember which version of the file is being downloaded
+        const QString etag = QString::fromLatin1(reply->rawHeader("ETag"));
+        const QString lastModified = QString::fromLatin1(reply->rawHeader("Last-Modified"));
+        if (statusCode == 200 || !etag.isEmpty() || !lastModified.isEmpty()) {
+            m_etag = etag;
+            m_lastModified = lastModified;
         }
 
-        // clean up; close file if still open in case something has gone wrong
-        if (file) {
-            if (file->isOpen()) {
-                file->close();
-            }
-            delete file;
+        // the file has changed in the meantime or the server ignores the
+        // range; either way the data on disk is of no use anymore
+        if (statusCode == 200 && m_resumedAt > 0) {
+            qCDebug(kastsEnclosureDownload) << "Server sent the complete file instead of resuming at" << m_resumedAt << "bytes; starting over";
+            m_resumedAt = 0;
+            m_writer->truncate();
+        }
+
+        // reserve the space for the rest of the file; the size of the file
+        // itself has to stay the same, since an interrupted download is
+        // resumed at the end of the file
+        const qint64 length = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        if (length > 0) {
+            m_writer->preallocate(length, true);
+        }
+    });
+
+    connect(reply, &QNetworkReply::readyRead, this, [this, reply]() {
+        writeReplyData(reply, -1);
+    });
+
+    connect(reply, &QNetworkReply::finished, this, [reply, url, requestUrl]() {
+        if (!reply->error()) {
+            Fetcher::instance().cacheRedirect(QUrl(url), reply->url());
+        } else if (requestUrl != QUrl(url)) {
+            // the cached target might have expired; go through the whole
+            // chain again next time
+            Fetcher::instance().removeCachedRedirect(QUrl(url));
         }
-        reply->deleteLater();
     });
 
     return reply;
 }
 
+DownloadFileWriter *EnclosureDownloadJob::openWriter(const QString &filePath, const QIODevice::OpenMode mode)
+{
+    DownloadFileWriter *writer = DownloadFileWriter::open(filePath, mode);
+    if (!writer) {
+        return nullptr;
+    }
+
+    connect(writer, &DownloadFileWriter::writeFailed, this, [this](const QString &errorString) {
+        if (error() == 0) {
+            setError(1);
+            setErrorText(i18n("Cannot write download to %1: %2", m_filename, errorString));
+        }
+        abortReplies();
+    });
+    connect(writer, &DownloadFileWriter::closed, this, &EnclosureDownloadJob::writerClosed);
+
+    return writer;
+}
+
+qint64 EnclosureDownloadJob::writeReplyData(QNetworkReply *reply, const qint64 offset, const qint64 maxLength)
+{
+    if (!m_writer || !reply->isOpen()) {
+        return 0;
+    }
+
+    // never read more than the caller can use, such that nothing has to be
+    // read and discarded afterwards
+    qint64 length = reply->bytesAvailable();
+    if (maxLength >= 0) {
+        length = std::min(length, maxLength);
+    }
+
+    if (reply->isFinished()) {
+        // everything has already been received
+        DownloadRateLimiter::instance().consume(this, length);
+    } else if (DownloadRateLimiter::instance().isLimited()) {
+        length = DownloadRateLimiter::instance().take(this, length);
+    } else if (length < m_writeChunkSize && length != maxLength) {
+        // leave the data in the buffer of the reply until there is enough of
+        // it to make handing it over to the writer thread worthwhile, unless
+        // that's all the caller still needs
+        length = 0;
+    }
+
+    if (length <= 0) {
+        return 0;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QByteArray data = reply->read(length);
+    if (!data.isEmpty()) {
+        m_writer->write(offset, data);
+    }
+
+    const qint64 elapsed = timer.nsecsElapsed();
+    m_guiThreadTime += elapsed;
+    m_maxGuiThreadTime = std::max(m_maxGuiThreadTime, elapsed);
+    m_writtenChunks++;
+
+    return data.size();
+}
+
+void EnclosureDownloadJob::writerClosed(const bool success, const QString &errorString)
+{
+    // the writer deletes itself
+    m_writer = nullptr;
+
+    if (!success && error() == 0) {
+        setError(1);
+        setErrorText(i18n("Cannot write download to %1: %2", m_filename, errorString));
+    }
+
+    if (!m_segments.isEmpty()) {
+        if (m_fallingBack) {
+            m_fallingBack = false;
+            m_segments.clear();
+            removePartialDownload(m_filename);
+            startSingleDownload();
+            return;
+        }
+
+        if (error() == 0 && segmentedBytesDone() == m_size) {
+            QFile::remove(m_filename); // in case an empty file has been left behind
+            if (QFile::rename(partFileName(m_filename), m_filename)) {
+                QFile::remove(segmentsFileName(m_filename));
+                qCDebug(kastsEnclosureDownload) << "Finished segmented download of" << m_url;
+            } else {
+                setError(1);
+                setErrorText(QStringLiteral("Cannot open file to write download to %1").arg(m_filename));
+            }
+        }
+    }
+
+    // time that the GUI thread has spent on handling the downloaded data,
+    // as opposed to the time spent writing it, which happens elsewhere
+    qCDebug(kastsEnclosureDownload) << "Download of" << m_url << "took" << m_guiThreadTime / 1000 << "µs on the GUI thread for" << m_writtenChunks
+                                    << "chunks; longest:" << m_maxGuiThreadTime / 1000 << "µs";
+
+    emitResult();
+}
+
+void EnclosureDownloadJob::abortReplies()
+{
+    if (m_reply) {
+        m_reply->abort();
+    }
+    for (const Segment &segment : std::as_const(m_segments)) {
+        if (segment.reply) {
+            segment.reply->abort();
+        }
+    }
+}
+
 EnclosureDownloadJob::Status EnclosureDownloadJob::status() const
 {
     return m_status;
 }
 
+qint64 EnclosureDownloadJob::entryuid() const
+{
+    return m_entryuid;
+}
+
+DownloadRateLimiter::Priority EnclosureDownloadJob::priority() const
+{
+    return m_priority;
+}
+
+void EnclosureDownloadJob::setValidators(const QString &etag, const QString &lastModified)
+{
+    m_etag = etag;
+    m_lastModified = lastModified;
+}
+
+QString EnclosureDownloadJob::etag() const
+{
+    return m_etag;
+}
+
+QString EnclosureDownloadJob::lastModified() const
+{
+    return m_lastModified;
+}
+
+qint64 EnclosureDownloadJob::bytesDone() const
+{
+    if (!m_segments.isEmpty()) {
+        return segmentedBytesDone();
+    }
+    return m_resumedAt + static_cast<qint64>(processedAmount(Bytes));
+}
+
+qint64 EnclosureDownloadJob::totalSize() const
+{
+    if (!m_segments.isEmpty()) {
+        return m_size;
+    }
+    return totalAmount(Bytes) > 0 ? m_resumedAt + static_cast<qint64>(totalAmount(Bytes)) : 0;
+}
+
+qint64 EnclosureDownloadJob::guiThreadTime() const
+{
+    return m_guiThreadTime;
+}
+
+qint64 EnclosureDownloadJob::maxGuiThreadTime() const
+{
+    return m_maxGuiThreadTime;
+}
+
+int EnclosureDownloadJob::writtenChunks() const
+{
+    return m_writtenChunks;
+}
+
+void EnclosureDownloadJob::setPriority(const DownloadRateLimiter::Priority priority)
+{
+    m_priority = priority;
+    DownloadRateLimiter::instance().setPriority(this, priority);
+}
+
 bool EnclosureDownloadJob::doKill()
 {
     m_status = EnclosureDownloadJob::Status::Canceled;
     Q_EMIT statusChanged(m_status);
 
-    if (m_reply) {
-        m_reply->abort();
+    if (m_probeReply) {
+        m_probeReply->abort();
+    } else if (m_writer) {
+        // the result is emitted once the writer has closed the file
+        abortReplies();
     } else {
         emitResult();
     }
 
     return true;
 }
+
+void EnclosureDownloadJob::removePartialDownload(const QString &filename)
+{
+    QFile::remove(partFileName(filename));
+    QFile::remove(segmentsFileName(filename));
+}
+
+qint64 EnclosureDownloadJob::partialDownloadSize(const QString &filename)
+{
+    QFile file(segmentsFileName(filename));
+    if (!QFileInfo::exists(partFileName(filename)) || !file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    qint64 done = 0;
+    const QJsonArray segmentArray = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("segments")).toArray();
+    for (const QJsonValue &value : segmentArray) {
+        done += std::max(value.toObject().value(QStringLiteral("done")).toInteger(), qint64(0));
+    }
+    return done;
+}
+
+bool EnclosureDownloadJob::useSegmentedDownload() const
+{
+    if (SettingsManager::self()->episodeDownloadConnections() < 2) {
+        return false;
+    }
+
+    // a file that has already been partially downloaded over a single
+    // connection is resumed that way
+    const QFileInfo fileInfo(m_filename);
+    return !(fileInfo.exists() && fileInfo.size() > 0);
+}
+
+void EnclosureDownloadJob::probeSegmentedDownload()
+{
+    // find out whether the server supports range requests and how large the
+    // file is; this also resolves any redirects only once for all segments
+    QNetworkRequest request(Fetcher::instance().cachedRedirect(QUrl(m_url)));
+    request.setTransferTimeout();
+    m_probeReply = Fetcher::instance().head(request);
+
+    connect(m_probeReply, &QNetworkReply::finished, this, [this]() {
+        QNetworkReply *reply = m_probeReply;
+        m_probeReply = nullptr;
+        reply->deleteLater();
+
+        if (m_status == EnclosureDownloadJob::Status::Canceled) {
+            setError(QNetworkReply::OperationCanceledError);
+            setErrorText(reply->errorString());
+            emitResult();
+            return;
+        }
+
+        const qint64 size = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        const bool acceptsRanges = (reply->rawHeader("Accept-Ranges").trimmed().toLower() == "bytes");
+        if (reply->error() || !acceptsRanges || size < 2 * m_minSegmentSize) {
+            qCDebug(kastsEnclosureDownload) << "Not using segmented download for" << m_url << "; range support:" << acceptsRanges << "size:" << size;
+            removePartialDownload(m_filename);
+            startSingleDownload();
+            return;
+        }
+
+        Fetcher::instance().cacheRedirect(QUrl(m_url), reply->url());
+        m_etag = QString::fromLatin1(reply->rawHeader("ETag"));
+        m_lastModified = QString::fromLatin1(reply->rawHeader("Last-Modified"));
+
+        // weak ETags can't be used to make sure that all segments belong to
+        // the same version of the file
+        QString validator = QString::fromLatin1(reply->rawHeader("ETag"));
+        if (validator.isEmpty() || validator.startsWith(QStringLiteral("W/"))) {
+            validator = QString::fromLatin1(reply->rawHeader("Last-Modified"));
+        }
+
+        startSegmentedDownload(reply->url(), size, validator);
+    });
+}
+
+void EnclosureDownloadJob::startSegmentedDownload(const QUrl &url, const qint64 size, const QString &validator)
+{
+    m_segmentUrl = url;
+    m_size = size;
+    m_validator = validator;
+
+    const bool resumed = loadSegments(size, validator);
+    if (!resumed) {
+        removePartialDownload(m_filename);
+        m_segments.clear();
+        const qint64 connections = std::min(static_cast<qint64>(SettingsManager::self()->episodeDownloadConnections()), size / m_minSegmentSize);
+        const qint64 segmentSize = (size + connections - 1) / connections;
+        for (qint64 start = 0; start < size; start += segmentSize) {
+            m_segments += Segment{start, std::min(start + segmentSize, size) - 1};
+        }
+    }
+
+    m_writer = openWriter(partFileName(m_filename), QIODevice::ReadWrite);
+    if (!m_writer) {
+        setError(1);
+        setErrorText(QStringLiteral("Cannot open file to write download to %1").arg(partFileName(m_filename)));
+        emitResult();
+        return;
+    }
+
+    // preallocate the whole file, such that every segment can be written
+    // to its final position right away
+    if (!resumed) {
+        m_writer->preallocate(size, false);
+    }
+
+    qCDebug(kastsEnclosureDownload) << (resumed ? "Resuming" : "Starting") << "segmented download of" << m_url << "over" << m_segments.count()
+                                    << "connections";
+
+    setTotalAmount(Bytes, m_size);
+    setProcessedAmount(Bytes, segmentedBytesDone());
+    saveSegments();
+    m_lastSave.start();
+
+    for (int i = 0; i < m_segments.count(); ++i) {
+        if (m_segments[i].start + m_segments[i].done <= m_segments[i].end) {
+            startSegment(i);
+        }
+    }
+
+    // in case all segments had already been downloaded before
+    finishSegmentedDownload();
+}
+
+void EnclosureDownloadJob::startSegment(const int index)
+{
+    Segment &segment = m_segments[index];
+
+    QNetworkRequest request(m_segmentUrl);
+    request.setTransferTimeout();
+    request.setRawHeader("Range", QByteArray("bytes=") + QByteArray::number(segment.start + segment.done) + "-" + QByteArray::number(segment.end));
+    // if the file has changed in the meantime, the server sends the complete
+    // new file instead, which is dealt with in readSegment
+    if (!m_validator.isEmpty()) {
+        request.setRawHeader("If-Range", m_validator.toLatin1());
+    }
+
+    segment.reply = Fetcher::instance().get(request);
+    segment.reply->setReadBufferSize(m_readBufferSize);
+    connect(segment.reply, &QNetworkReply::readyRead, this, [this, index]() {
+        readSegment(index);
+    });
+    connect(segment.reply, &QNetworkReply::finished, this, [this, index]() {
+        finishSegment(index);
+    });
+}
+
+void EnclosureDownloadJob::readSegment(const int index)
+{
+    Segment &segment = m_segments[index];
+    QNetworkReply *reply = segment.reply;
+    if (!reply || m_fallingBack || error() != 0) {
+        return;
+    }
+
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode == 200) {
+        // the server ignores the range after all
+        fallBackToSingleDownload();
+        return;
+    } else if (statusCode != 206) {
+        return; // errors are handled in finishSegment
+    }
+
+    segment.done += writeReplyData(reply, segment.start + segment.done, segment.end + 1 - segment.start - segment.done);
+
+    setProcessedAmount(Bytes, segmentedBytesDone());
+    if (m_lastSave.elapsed() > m_saveInterval) {
+        saveSegments();
+        m_lastSave.restart();
+    }
+}
+
+void EnclosureDownloadJob::finishSegment(const int index)
+{
+    readSegment(index);
+
+    Segment &segment = m_segments[index];
+    QNetworkReply *reply = segment.reply;
+    segment.reply = nullptr;
+    reply->deleteLater();
+
+    if (!m_fallingBack && error() == 0) {
+        if (reply->error()) {
+            setError(reply->error());
+            setErrorText(reply->errorString());
+        } else if (segment.start + segment.done <= segment.end) {
+            setError(QNetworkReply::RemoteHostClosedError);
+            setErrorText(i18n("Connection closed before the download was complete"));
+        }
+
+        // stop the other segments as well; they can be resumed later on
+        if (error() != 0) {
+            abortReplies();
+        }
+    }
+
+    finishSegmentedDownload();
+}
+
+void EnclosureDownloadJob::finishSegmentedDownload()
+{
+    for (const Segment &segment : std::as_const(m_segments)) {
+        if (segment.reply) {
+            return; // wait until all segments have finished
+        }
+    }
+
+    // the part file is renamed (or the fall back is started) once all data
+    // has been written and the file has been closed
+    if (!m_fallingBack && (error() != 0 || segmentedBytesDone() != m_size)) {
+        saveSegments();
+    }
+    m_writer->close();
+}
+
+void EnclosureDownloadJob::fallBackToSingleDownload()
+{
+    qCDebug(kastsEnclosureDownload) << "Server does not honour range requests for" << m_url << "; falling back to a single connection";
+    m_fallingBack = true;
+    abortReplies();
+}
+
+bool EnclosureDownloadJob::loadSegments(const qint64 size, const QString &validator)
+{
+    QFile file(segmentsFileName(m_filename));
+    if (QFileInfo(partFileName(m_filename)).size() != size || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // only resume if the file on the server is still the same
+    const QJsonObject object = QJsonDocument::fromJson(file.readAll()).object();
+    if (object.value(QStringLiteral("size")).toInteger() != size || object.value(QStringLiteral("validator")).toString() != validator) {
+        return false;
+    }
+
+    QList<Segment> segments;
+    const QJsonArray segmentArray = object.value(QStringLiteral("segments")).toArray();
+    for (const QJsonValue &value : segmentArray) {
+        const QJsonObject segmentObject = value.toObject();
+        Segment segment{segmentObject.value(QStringLiteral("start")).toInteger(), segmentObject.value(QStringLiteral("end")).toInteger()};
+        segment.done = segmentObject.value(QStringLiteral("done")).toInteger();
+        if (segment.start < 0 || segment.end >= size || segment.done < 0 || segment.start + segment.done > segment.end + 1) {
+            return false;
+        }
+        segments += segment;
+    }
+
+    m_segments = segments;
+    return !m_segments.isEmpty();
+}
+
+void EnclosureDownloadJob::saveSegments()
+{
+    QJsonArray segmentArray;
+    for (const Segment &segment : std::as_const(m_segments)) {
+        segmentArray.append(QJsonObject{{QStringLiteral("start"), segment.start}, {QStringLiteral("end"), segment.end}, {QStringLiteral("done"), segment.done}});
+    }
+    const QJsonObject object{{QStringLiteral("size"), m_size}, {QStringLiteral("validator"), m_validator}, {QStringLiteral("segments"), segmentArray}};
+
+    // the sidecar has to be written by the writer thread as well, such that
+    // it never claims data that isn't on disk yet
+    m_writer->saveFile(segmentsFileName(m_filename), QJsonDocument(object).toJson(QJsonDocument::Compact));
+}
+
+qint64 EnclosureDownloadJob::segmentedBytesDone() const
+{
+    qint64 done = 0;
+    for (const Segment &segment : std::as_const(m_segments)) {
+        done += segment.done;
+    }
+    return done;
+}
+
+QString EnclosureDownloadJob::partFileName(const QString &filename)
+{
+    return filename + QStringLiteral(".part");
+}
+
+QString EnclosureDownloadJob::segmentsFileName(const QString &filename)
+{
+    return filename + QStringLiteral(".segments");
+}
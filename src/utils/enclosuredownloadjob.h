@@ -6,12 +6,20 @@
 
 #pragma once
 
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QList>
 #include <QNetworkReply>
 #include <QObject>
 #include <QString>
+#include <QUrl>
 
 #include <KJob>
 
+#include "downloadratelimiter.h"
+
+class DownloadFileWriter;
+
 class EnclosureDownloadJob : public KJob
 {
     Q_OBJECT
@@ -30,18 +38,100 @@ public:
     void start() override;
     bool doKill() override;
     Status status() const;
+    qint64 entryuid() const;
+
+    // validators of the file that is being downloaded; used to make sure
+    // that a resumed download belongs to the same version of the file
+    void setValidators(const QString &etag, const QString &lastModified);
+    QString etag() const;
+    QString lastModified() const;
+
+    // including the data that had already been downloaded before
+    qint64 bytesDone() const;
+    qint64 totalSize() const; // 0 if unknown
+
+    // nanoseconds spent on the GUI thread handling downloaded data, in total
+    // and for the longest chunk
+    qint64 guiThreadTime() const;
+    qint64 maxGuiThreadTime() const;
+    int writtenChunks() const;
+
+    // determines the share of the bandwidth if downloads are rate limited
+    DownloadRateLimiter::Priority priority() const;
+    void setPriority(const DownloadRateLimiter::Priority priority);
+
+    // removes the data of an unfinished segmented download of filename
+    static void removePartialDownload(const QString &filename);
+    // bytes of an unfinished segmented download of filename that are on
+    // disk according to its sidecar file; 0 if there is none
+    static qint64 partialDownloadSize(const QString &filename);
 
 Q_SIGNALS:
     void statusChanged(EnclosureDownloadJob::Status status);
 
 private:
+    // part of the file that is downloaded over a separate connection
+    struct Segment {
+        qint64 start;
+        qint64 end; // inclusive
+        qint64 done = 0;
+        QNetworkReply *reply = nullptr;
+    };
+
     void startDownload();
-    QNetworkReply *getNetworkReply(const QString &url, const QString &filePath) const;
+    void startSingleDownload();
+    QNetworkReply *getNetworkReply(const QString &url, const QString &filePath);
+
+    // the downloaded data is written to disk in a worker thread
+    DownloadFileWriter *openWriter(const QString &filePath, const QIODevice::OpenMode mode);
+    qint64 writeReplyData(QNetworkReply *reply, const qint64 offset, const qint64 maxLength = -1);
+    void writerClosed(const bool success, const QString &errorString);
+    void abortReplies();
+
+    // segmented downloads are written to a preallocated part file; the
+    // progress of every segment is kept in a sidecar file, such that they
+    // can be resumed individually
+    bool useSegmentedDownload() const;
+    void probeSegmentedDownload();
+    void startSegmentedDownload(const QUrl &url, const qint64 size, const QString &validator);
+    void startSegment(const int index);
+    void readSegment(const int index);
+    void finishSegment(const int index);
+    void finishSegmentedDownload();
+    void fallBackToSingleDownload();
+    bool loadSegments(const qint64 size, const QString &validator);
+    void saveSegments();
+    qint64 segmentedBytesDone() const;
+    static QString partFileName(const QString &filename);
+    static QString segmentsFileName(const QString &filename);
 
     qint64 m_entryuid;
     QString m_url;
     QString m_filename;
     QString m_title;
     QNetworkReply *m_reply = nullptr;
+    DownloadFileWriter *m_writer = nullptr;
     Status m_status = Queued;
+    DownloadRateLimiter::Priority m_priority = DownloadRateLimiter::Normal;
+    QString m_etag;
+    QString m_lastModified;
+    qint64 m_resumedAt = 0;
+
+    // nanoseconds spent on the GUI thread handling downloaded data
+    qint64 m_guiThreadTime = 0;
+    qint64 m_maxGuiThreadTime = 0;
+    int m_writtenChunks = 0;
+
+    QNetworkReply *m_probeReply = nullptr;
+    QList<Segment> m_segments;
+    QUrl m_segmentUrl;
+    QString m_validator; // ETag or Last-Modified of the file that is being downloaded
+    qint64 m_size = 0;
+    QElapsedTimer m_lastSave;
+    bool m_fallingBack = false;
+
+    inline static const qint64 m_minSegmentSize = 4 * 1024 * 1024; // smaller files are not worth the extra connections
+    inline static const qint64 m_saveInterval = 2000; // milliseconds between updates of the sidecar file
+    inline static const qint64 m_writeChunkSize = 256 * 1024; // minimum amount of bytes handed over to the writer thread at once
+    inline static const qint64 m_readBufferSize = 4 * m_writeChunkSize; // limits the data that is received ahead of being read
 };
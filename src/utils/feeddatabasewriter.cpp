@@ -0,0 +1,622 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "feeddatabasewriter.h"
+
+#include <QElapsedTimer>
+#include <QSqlError>
+#include <QVariant>
+
+#include "database.h"
+#include "fetcher.h"
+#include "settingsmanager.h"
+#include "updaterlogging.h"
+
+using namespace DataTypes;
+
+FeedDatabaseWriter::FeedDatabaseWriter(QObject *parent)
+    : QObject(parent)
+    , m_flushTimer(new QTimer(this))
+{
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, &FeedDatabaseWriter::flush);
+
+    // connect to signals in Fetcher such that GUI can pick up the changes
+    connect(this, &FeedDatabaseWriter::feedDetailsUpdated, &Fetcher::instance(), &Fetcher::feedDetailsUpdated);
+    connect(this, &FeedDatabaseWriter::feedUpdated, &Fetcher::instance(), &Fetcher::feedUpdated);
+    connect(this, &FeedDatabaseWriter::entriesAdded, &Fetcher::instance(), &Fetcher::entriesAdded);
+    connect(this, &FeedDatabaseWriter::entriesUpdated, &Fetcher::instance(), &Fetcher::entriesUpdated);
+    connect(this, &FeedDatabaseWriter::feedUrlChanged, &Fetcher::instance(), &Fetcher::feedUrlChanged);
+    connect(this, &FeedDatabaseWriter::feedFailureStateChanged, &Fetcher::instance(), &Fetcher::feedFailureStateChanged);
+    connect(this, &FeedDatabaseWriter::error, &Fetcher::instance(), &Fetcher::error);
+}
+
+FeedDatabaseWriter::~FeedDatabaseWriter()
+{
+    flush();
+    if (m_databaseOpen) {
+        Database::closeDatabase(m_connectionName);
+    }
+}
+
+void FeedDatabaseWriter::enqueue(const DataTypes::FeedWrite &feedWrite)
+{
+    m_pending += feedWrite;
+
+    // estimate the amount of records that will have to be written
+    m_pendingChanges += 1;
+    if (feedWrite.processed) {
+        for (const EntryDetails &entryDetails : std::as_const(feedWrite.feed.entries)) {
+            if (entryDetails.state != RecordState::Unmodified) {
+                m_pendingChanges += 1 + entryDetails.enclosures.count() + entryDetails.authors.count() + entryDetails.chapters.count();
+            }
+        }
+    }
+
+    if (m_pendingChanges >= m_maxBatchChanges) {
+        flush();
+    } else if (!m_flushTimer->isActive()) {
+        m_flushTimer->start(m_maxBatchDelay);
+    }
+}
+
+void FeedDatabaseWriter::flush()
+{
+    m_flushTimer->stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    // the connection has to be opened in the thread that will be using it
+    if (!m_databaseOpen) {
+        Database::openDatabase(m_connectionName);
+        m_databaseOpen = true;
+    }
+
+    QList<FeedWrite> batch;
+    batch.swap(m_pending);
+    m_pendingChanges = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // this includes the time spent waiting for other connections to release
+    // the write lock
+    dbTransaction();
+    const qint64 lockWaitTime = timer.elapsed();
+
+    QHash<qint64, QSet<qint64>> newEntryuids, updatedEntryuids; // key = feeduid
+    QList<qint64> feeduids;
+    int items = 0;
+    for (FeedWrite &feedWrite : batch) {
+        writeFeed(feedWrite, newEntryuids[feedWrite.feeduid], updatedEntryuids[feedWrite.feeduid]);
+        feeduids += feedWrite.feeduid;
+        items += feedWrite.stats.items;
+    }
+
+    const bool committed = dbCommit();
+    const qint64 writeTime = timer.elapsed() - lockWaitTime;
+    qCDebug(kastsUpdater) << "Wrote" << batch.count() << "feeds to the database in" << writeTime << "ms after waiting" << lockWaitTime << "ms for the lock";
+
+    for (const FeedWrite &feedWrite : std::as_const(batch)) {
+        const FeedDetails &updatedFeed = feedWrite.feed;
+        if (committed) {
+            // emit one signal for all new entries and one for all updated
+            // entries (or entries with new/updated authors, enclosures or
+            // chapters); the entryuids of new entries are not reported as
+            // updated
+            QSet<qint64> &updated = updatedEntryuids[feedWrite.feeduid];
+            const QSet<qint64> &added = newEntryuids[feedWrite.feeduid];
+            updated.subtract(added);
+            if (!added.isEmpty()) {
+                qCDebug(kastsUpdater) << "new episodes" << added;
+                Q_EMIT entriesAdded(feedWrite.feeduid, added);
+            }
+            if (!updated.isEmpty()) {
+                qCDebug(kastsUpdater) << "updated episodes" << updated;
+                Q_EMIT entriesUpdated(feedWrite.feeduid, updated);
+            }
+        }
+
+        if (committed && feedWrite.feedDetailsChanged) {
+            Q_EMIT feedDetailsUpdated(updatedFeed.feeduid,
+                                      updatedFeed.url,
+                                      updatedFeed.name,
+                                      updatedFeed.image,
+                                      updatedFeed.link,
+                                      updatedFeed.description,
+                                      feedWrite.lastUpdated,
+                                      updatedFeed.dirname);
+        }
+
+        if (committed && feedWrite.processed && (feedWrite.entriesChanged || updatedFeed.isNew)) {
+            Q_EMIT feedUpdated(updatedFeed.feeduid);
+        }
+
+        if (committed && !feedWrite.redirectedUrl.isEmpty()) {
+            Q_EMIT feedUrlChanged(feedWrite.feeduid, updatedFeed.url, feedWrite.redirectedUrl);
+        }
+
+        if (committed && feedWrite.failureStateChanged) {
+            Q_EMIT feedFailureStateChanged(feedWrite.feeduid, feedWrite.failureCount, QDateTime::fromSecsSinceEpoch(feedWrite.retryAfter), feedWrite.paused);
+        }
+    }
+
+    Q_EMIT feedsWritten(feeduids, items, lockWaitTime, writeTime);
+}
+
+void FeedDatabaseWriter::writeFeed(DataTypes::FeedWrite &feedWrite, QSet<qint64> &newEntryuids, QSet<qint64> &updatedEntryuids)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlQuery writeQuery(QSqlDatabase::database(m_connectionName));
+
+    if (feedWrite.processed) {
+        writeFeedDetails(feedWrite.feed, newEntryuids, updatedEntryuids);
+    } else if (feedWrite.validatorsChanged) {
+        // the feed itself is unchanged, but we still need to store the
+        // (possibly new) validators to be able to do conditional requests
+        writeQuery.prepare(QStringLiteral("UPDATE Feeds SET etag=:etag, lastModified=:lastModified, lastSize=:lastSize WHERE feeduid=:feeduid;"));
+        writeQuery.bindValue(QStringLiteral(":feeduid"), feedWrite.feeduid);
+        writeQuery.bindValue(QStringLiteral(":etag"), feedWrite.feed.etag);
+        writeQuery.bindValue(QStringLiteral(":lastModified"), feedWrite.feed.lastModified);
+        writeQuery.bindValue(QStringLiteral(":lastSize"), feedWrite.feed.lastSize);
+        dbExecute(writeQuery);
+        writeQuery.clear();
+    }
+
+    if (feedWrite.nextUpdate > 0) {
+        writeQuery.prepare(QStringLiteral("UPDATE Feeds SET nextUpdate=:nextUpdate WHERE feeduid=:feeduid;"));
+        writeQuery.bindValue(QStringLiteral(":feeduid"), feedWrite.feeduid);
+        writeQuery.bindValue(QStringLiteral(":nextUpdate"), feedWrite.nextUpdate);
+        dbExecute(writeQuery);
+        writeQuery.clear();
+    }
+
+    if (feedWrite.failureStateChanged) {
+        writeQuery.prepare(QStringLiteral("UPDATE Feeds SET failureCount=:failureCount, retryAfter=:retryAfter, paused=:paused WHERE feeduid=:feeduid;"));
+        writeQuery.bindValue(QStringLiteral(":feeduid"), feedWrite.feeduid);
+        writeQuery.bindValue(QStringLiteral(":failureCount"), feedWrite.failureCount);
+        writeQuery.bindValue(QStringLiteral(":retryAfter"), feedWrite.retryAfter);
+        writeQuery.bindValue(QStringLiteral(":paused"), feedWrite.paused);
+        dbExecute(writeQuery);
+        writeQuery.clear();
+    }
+
+    if (!feedWrite.redirectedUrl.isEmpty()) {
+        writeFeedUrl(feedWrite);
+    }
+
+    feedWrite.stats.writeTime = timer.elapsed();
+    writeFeedStats(feedWrite.feeduid, feedWrite.stats);
+}
+
+void FeedDatabaseWriter::writeFeedUrl(DataTypes::FeedWrite &feedWrite)
+{
+    QSqlQuery writeQuery(QSqlDatabase::database(m_connectionName));
+
+    // two subscriptions can end up at the same location; in that case we
+    // keep the old url rather than creating a duplicate feed
+    writeQuery.prepare(QStringLiteral("SELECT COUNT(*) FROM Feeds WHERE url=:url AND feeduid!=:feeduid;"));
+    writeQuery.bindValue(QStringLiteral(":url"), feedWrite.redirectedUrl);
+    writeQuery.bindValue(QStringLiteral(":feeduid"), feedWrite.feeduid);
+    if (!dbExecute(writeQuery) || !writeQuery.next() || writeQuery.value(0).toInt() > 0) {
+        qCDebug(kastsUpdater) << "Not moving feed" << feedWrite.feeduid << "to" << feedWrite.redirectedUrl << "since another feed already uses it";
+        feedWrite.redirectedUrl.clear();
+        return;
+    }
+    writeQuery.clear();
+
+    writeQuery.prepare(QStringLiteral("UPDATE Feeds SET url=:url WHERE feeduid=:feeduid;"));
+    writeQuery.bindValue(QStringLiteral(":url"), feedWrite.redirectedUrl);
+    writeQuery.bindValue(QStringLiteral(":feeduid"), feedWrite.feeduid);
+    dbExecute(writeQuery);
+    writeQuery.clear();
+
+    // keep the old url around, such that it is still recognized when it
+    // shows up again, e.g. through sync or an OPML import
+    writeQuery.prepare(QStringLiteral("INSERT INTO FeedRedirects (feeduid, oldUrl, newUrl, timestamp) VALUES (:feeduid, :oldUrl, :newUrl, :timestamp);"));
+    writeQuery.bindValue(QStringLiteral(":feeduid"), feedWrite.feeduid);
+    writeQuery.bindValue(QStringLiteral(":oldUrl"), feedWrite.feed.url);
+    writeQuery.bindValue(QStringLiteral(":newUrl"), feedWrite.redirectedUrl);
+    writeQuery.bindValue(QStringLiteral(":timestamp"), QDateTime::currentSecsSinceEpoch());
+    dbExecute(writeQuery);
+}
+
+void FeedDatabaseWriter::writeFeedStats(const qint64 feeduid, const DataTypes::FeedStats &stats)
+{
+    QSqlQuery writeQuery(QSqlDatabase::database(m_connectionName));
+    writeQuery.prepare(
+        QStringLiteral("INSERT INTO FeedStats (feeduid, time, outcome, lookupTime, connectTime, firstByteTime, downloadTime, bytes, parseTime, processTime, "
+                       "writeTime, items, processedItems, skippedItems) VALUES (:feeduid, :time, :outcome, :lookupTime, :connectTime, :firstByteTime, "
+                       ":downloadTime, :bytes, :parseTime, :processTime, :writeTime, :items, :processedItems, :skippedItems);"));
+    writeQuery.bindValue(QStringLiteral(":feeduid"), feeduid);
+    writeQuery.bindValue(QStringLiteral(":time"), QDateTime::currentSecsSinceEpoch());
+    writeQuery.bindValue(QStringLiteral(":outcome"), static_cast<int>(stats.outcome));
+    writeQuery.bindValue(QStringLiteral(":lookupTime"), stats.lookupTime);
+    writeQuery.bindValue(QStringLiteral(":connectTime"), stats.connectTime);
+    writeQuery.bindValue(QStringLiteral(":firstByteTime"), stats.firstByteTime);
+    writeQuery.bindValue(QStringLiteral(":downloadTime"), stats.downloadTime);
+    writeQuery.bindValue(QStringLiteral(":bytes"), stats.bytes);
+    writeQuery.bindValue(QStringLiteral(":parseTime"), stats.parseTime);
+    writeQuery.bindValue(QStringLiteral(":processTime"), stats.processTime);
+    writeQuery.bindValue(QStringLiteral(":writeTime"), stats.writeTime);
+    writeQuery.bindValue(QStringLiteral(":items"), stats.items);
+    writeQuery.bindValue(QStringLiteral(":processedItems"), stats.processedItems);
+    writeQuery.bindValue(QStringLiteral(":skippedItems"), stats.skippedItems);
+    dbExecute(writeQuery);
+
+    // only keep the most recent runs of every feed
+    writeQuery.prepare(
+        QStringLiteral("DELETE FROM FeedStats WHERE feeduid=:feeduid AND rowid NOT IN (SELECT rowid FROM FeedStats WHERE feeduid=:feeduid ORDER BY rowid DESC "
+                       "LIMIT :limit);"));
+    writeQuery.bindValue(QStringLiteral(":feeduid"), feeduid);
+    writeQuery.bindValue(QStringLiteral(":limit"), m_maxStatsPerFeed);
+    dbExecute(writeQuery);
+}
+
+void FeedDatabaseWriter::writeFeedDetails(DataTypes::FeedDetails &updatedFeed, QSet<qint64> &newEntryuids, QSet<qint64> &updatedEntryuids)
+{
+    QSqlQuery writeQuery(QSqlDatabase::database(m_connectionName));
+
+    // update feed details
+    writeQuery.prepare(
+        QStringLiteral("UPDATE Feeds SET url=:url, name=:name, image=:image, link=:link, description=:description, lastUpdated=:lastUpdated, dirname=:dirname "
+                       "WHERE feeduid=:feeduid;"));
+    writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
+    writeQuery.bindValue(QStringLiteral(":url"), updatedFeed.url);
+    writeQuery.bindValue(QStringLiteral(":name"), updatedFeed.name);
+    writeQuery.bindValue(QStringLiteral(":link"), updatedFeed.link);
+    writeQuery.bindValue(QStringLiteral(":description"), updatedFeed.description);
+    writeQuery.bindValue(QStringLiteral(":lastUpdated"), updatedFeed.lastUpdated);
+    writeQuery.bindValue(QStringLiteral(":image"), updatedFeed.image);
+    writeQuery.bindValue(QStringLiteral(":dirname"), updatedFeed.dirname);
+    // we only write the new lastHash to the database after entries etc. have
+    // all been updated!
+    dbExecute(writeQuery);
+    writeQuery.clear(); // make sure this writeQuery is not blocking anything anymore
+
+    // new feed authors
+    writeQuery.prepare(QStringLiteral("INSERT INTO FeedAuthors (feeduid, name, email) VALUES (:feeduid, :name, :email);"));
+    for (const AuthorDetails &authorDetails : std::as_const(updatedFeed.authors)) {
+        if (authorDetails.state == RecordState::New) {
+            writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
+            writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
+            writeQuery.bindValue(QStringLiteral(":email"), authorDetails.email);
+            dbExecute(writeQuery);
+        }
+    }
+    writeQuery.clear();
+
+    // update feed authors
+    writeQuery.prepare(QStringLiteral("UPDATE FeedAuthors SET email=:email WHERE feeduid=:feeduid AND name=:name;"));
+    for (const AuthorDetails &authorDetails : std::as_const(updatedFeed.authors)) {
+        if (authorDetails.state == RecordState::Modified) {
+            writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
+            writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
+            writeQuery.bindValue(QStringLiteral(":email"), authorDetails.email);
+            dbExecute(writeQuery);
+        }
+    }
+    writeQuery.clear();
+
+    // deleted removed feed authors
+    writeQuery.prepare(QStringLiteral("DELETE FROM FeedAuthors WHERE feeduid=:feeduid and name=:name;"));
+    for (const AuthorDetails &authorDetails : std::as_const(updatedFeed.authors)) {
+        if (authorDetails.state == RecordState::Deleted) {
+            writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
+            writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
+            dbExecute(writeQuery);
+            qCDebug(kastsUpdater) << "deleted old feed author:" << updatedFeed.feeduid << authorDetails.name;
+        }
+    }
+    writeQuery.clear();
+
+    // new entries
+    writeQuery.prepare(
+        QStringLiteral("INSERT INTO Entries (feeduid, id, title, content, created, updated, link, read, new, hasEnclosure, image, favorite, removed, "
+                       "contentHash) VALUES (:feeduid, :id, :title, :content, :created, :updated, :link, :read, :new, :hasEnclosure, :image, :favorite, "
+                       ":removed, :contentHash);"));
+    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+        if (entryDetails.state == RecordState::New) {
+            writeQuery.bindValue(QStringLiteral(":feeduid"), entryDetails.feeduid);
+            writeQuery.bindValue(QStringLiteral(":id"), entryDetails.id);
+            writeQuery.bindValue(QStringLiteral(":title"), entryDetails.title);
+            writeQuery.bindValue(QStringLiteral(":content"), entryDetails.content);
+            writeQuery.bindValue(QStringLiteral(":created"), entryDetails.created);
+            writeQuery.bindValue(QStringLiteral(":updated"), entryDetails.updated);
+            writeQuery.bindValue(QStringLiteral(":link"), entryDetails.link);
+            writeQuery.bindValue(QStringLiteral(":hasEnclosure"), entryDetails.hasEnclosure);
+            writeQuery.bindValue(QStringLiteral(":read"), entryDetails.read);
+            writeQuery.bindValue(QStringLiteral(":new"), entryDetails.isNew);
+            writeQuery.bindValue(QStringLiteral(":image"), entryDetails.image);
+            writeQuery.bindValue(QStringLiteral(":favorite"), false);
+            writeQuery.bindValue(QStringLiteral(":removed"), false);
+            writeQuery.bindValue(QStringLiteral(":contentHash"), entryDetails.contentHash);
+            if (dbExecute(writeQuery)) {
+                QVariant lastId = writeQuery.lastInsertId();
+                if (lastId.isValid()) {
+                    updatedFeed.entries[entryDetails.id].entryuid = lastId.toLongLong();
+                    newEntryuids.insert(lastId.toLongLong());
+                } else {
+                    qCDebug(kastsUpdater) << "new episode did not get a valid entryuid" << entryDetails.id;
+                }
+            }
+        }
+    }
+    writeQuery.clear();
+
+    // update entries
+    writeQuery.prepare(
+        QStringLiteral("UPDATE Entries SET id=:id, title=:title, content=:content, created=:created, updated=:updated, link=:link, hasEnclosure=:hasEnclosure, "
+                       "image=:image WHERE entryuid=:entryuid;"));
+    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+        if (entryDetails.state == RecordState::Modified) {
+            updatedEntryuids.insert(entryDetails.entryuid);
+            writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
+            writeQuery.bindValue(QStringLiteral(":id"), entryDetails.id);
+            writeQuery.bindValue(QStringLiteral(":title"), entryDetails.title);
+            writeQuery.bindValue(QStringLiteral(":content"), entryDetails.content);
+            writeQuery.bindValue(QStringLiteral(":created"), entryDetails.created);
+            writeQuery.bindValue(QStringLiteral(":updated"), entryDetails.updated);
+            writeQuery.bindValue(QStringLiteral(":link"), entryDetails.link);
+            writeQuery.bindValue(QStringLiteral(":hasEnclosure"), entryDetails.hasEnclosure);
+            writeQuery.bindValue(QStringLiteral(":image"), entryDetails.image);
+            dbExecute(writeQuery);
+        }
+    }
+    writeQuery.clear();
+
+    // store content hashes of existing entries that have been (re)processed
+    writeQuery.prepare(QStringLiteral("UPDATE Entries SET contentHash=:contentHash WHERE entryuid=:entryuid;"));
+    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+        if (entryDetails.state != RecordState::New && entryDetails.state != RecordState::Deleted && (entryDetails.changedFields & EntryDetails::ContentHash)) {
+            writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
+            writeQuery.bindValue(QStringLiteral(":contentHash"), entryDetails.contentHash);
+            dbExecute(writeQuery);
+        }
+    }
+    writeQuery.clear();
+
+    // removed entries
+    // rather than actually remove the episodes, we mark them as such through
+    // the column "removed"
+    writeQuery.prepare(QStringLiteral("UPDATE Entries SET removed=:removed WHERE entryuid=:entryuid;"));
+    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+        if (entryDetails.state == RecordState::Deleted && !entryDetails.removed) {
+            updatedEntryuids.insert(entryDetails.entryuid);
+            writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
+            writeQuery.bindValue(QStringLiteral(":removed"), true);
+            dbExecute(writeQuery);
+        }
+    }
+    writeQuery.clear();
+
+    // new authors
+    writeQuery.prepare(QStringLiteral("INSERT INTO EntryAuthors (entryuid, name, email) VALUES (:entryuid, :name, :email);"));
+    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+        if (entryDetails.entryuid == 0) {
+            qCDebug(kastsUpdater) << "new episode did not get a valid entryuid; skipping authors for id:" << entryDetails.id;
+        } else {
+            for (const AuthorDetails &authorDetails : std::as_const(entryDetails.authors)) {
+                if (authorDetails.state == RecordState::New) {
+                    updatedEntryuids.insert(entryDetails.entryuid);
+                    writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
+                    writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
+                    writeQuery.bindValue(QStringLiteral(":email"), authorDetails.email);
+                    dbExecute(writeQuery);
+                }
+            }
+        }
+    }
+    writeQuery.clear();
+
+    // update authors
+    writeQuery.prepare(QStringLiteral("UPDATE EntryAuthors SET email=:email WHERE entryuid=:entryuid AND name=:name;"));
+    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+        for (const AuthorDetails &authorDetails : std::as_const(entryDetails.authors)) {
+            if (authorDetails.state == RecordState::Modified) {
+                updatedEntryuids.insert(entryDetails.entryuid);
+                writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
+                writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
+                writeQuery.bindValue(QStringLiteral(":email"), authorDetails.email);
+                dbExecute(writeQuery);
+            }
+        }
+    }
+    writeQuery.clear();
+
+    // delete entry authors that were removed
+    if (SettingsManager::self()->doFullUpdate()) { // only if this is a full update
+        writeQuery.prepare(QStringLiteral("DELETE FROM EntryAuthors WHERE entryuid=:entryuid AND name=:name;"));
+        for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+            if (entryDetails.state != RecordState::Deleted) {
+                for (const AuthorDetails &authorDetails : std::as_const(entryDetails.authors)) {
+                    if (authorDetails.state == RecordState::Deleted) {
+                        updatedEntryuids.insert(entryDetails.entryuid);
+                        writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
+                        writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
+                        dbExecute(writeQuery);
+                        qCDebug(kastsUpdater) << "deleted old entry author:" << updatedFeed.feeduid << entryDetails.entryuid << authorDetails.name;
+                    }
+                }
+            }
+        }
+        writeQuery.clear();
+    }
+
+    // new enclosures
+    writeQuery.prepare(
+        QStringLiteral("INSERT INTO Enclosures (entryuid, feeduid, url, duration, size, type, playposition, downloaded) VALUES (:entryuid, :feeduid, "
+                       ":url, :duration, :size, :type, :playposition, :downloaded);"));
+    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+        if (entryDetails.entryuid == 0) {
+            qCDebug(kastsUpdater) << "new episode did not get a valid entryuid; skipping enclosures for id:" << entryDetails.id;
+        } else {
+            for (const EnclosureDetails &enclosureDetails : std::as_const(entryDetails.enclosures)) {
+                if (enclosureDetails.state == RecordState::New) {
+                    updatedEntryuids.insert(entryDetails.entryuid);
+                    writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
+                    writeQuery.bindValue(QStringLiteral(":feeduid"), entryDetails.feeduid);
+                    writeQuery.bindValue(QStringLiteral(":duration"), enclosureDetails.duration);
+                    writeQuery.bindValue(QStringLiteral(":size"), enclosureDetails.size);
+                    writeQuery.bindValue(QStringLiteral(":type"), enclosureDetails.type);
+                    writeQuery.bindValue(QStringLiteral(":url"), enclosureDetails.url);
+                    writeQuery.bindValue(QStringLiteral(":playposition"), enclosureDetails.playPosition);
+                    writeQuery.bindValue(QStringLiteral(":downloaded"), Enclosure::statusToDb(enclosureDetails.downloaded));
+                    dbExecute(writeQuery);
+                }
+            }
+        }
+    }
+    writeQuery.clear();
+
+    // update enclosures
+    writeQuery.prepare(
+        QStringLiteral("UPDATE Enclosures SET duration=:duration, size=:size, title=:title, type=:type, url=:url WHERE entryuid=:entryuid "
+                       "AND enclosureuid=:enclosureuid;"));
+    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+        for (const EnclosureDetails &enclosureDetails : std::as_const(entryDetails.enclosures)) {
+            if (enclosureDetails.state == RecordState::Modified) {
+                updatedEntryuids.insert(entryDetails.entryuid);
+                writeQuery.bindValue(QStringLiteral(":enclosureuid"), enclosureDetails.enclosureuid);
+                writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
+                writeQuery.bindValue(QStringLiteral(":duration"), enclosureDetails.duration);
+                writeQuery.bindValue(QStringLiteral(":size"), enclosureDetails.size);
+                writeQuery.bindValue(QStringLiteral(":type"), enclosureDetails.type);
+                writeQuery.bindValue(QStringLiteral(":url"), enclosureDetails.url);
+                dbExecute(writeQuery);
+            }
+        }
+    }
+    writeQuery.clear();
+
+    // delete removed enclosures
+    if (SettingsManager::self()->doFullUpdate()) { // only if this is a full update
+        writeQuery.prepare(QStringLiteral("DELETE FROM Enclosures WHERE enclosureuid=:enclosureuid;"));
+        for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+            if (entryDetails.state != RecordState::Deleted) {
+                for (const EnclosureDetails &enclosureDetails : std::as_const(entryDetails.enclosures)) {
+                    if (enclosureDetails.state == RecordState::Deleted) {
+                        updatedEntryuids.insert(entryDetails.entryuid);
+                        writeQuery.bindValue(QStringLiteral(":enclosureuid"), enclosureDetails.enclosureuid);
+                        dbExecute(writeQuery);
+                        qCDebug(kastsUpdater) << "deleted old enclosure:" << updatedFeed.feeduid << enclosureDetails.enclosureuid << enclosureDetails.url;
+                    }
+                }
+            }
+        }
+        writeQuery.clear();
+    }
+
+    // new chapters
+    writeQuery.prepare(QStringLiteral("INSERT INTO Chapters (entryuid, start, title, link, image) VALUES (:entryuid, :start, :title, :link, :image);"));
+    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+        if (entryDetails.entryuid == 0) {
+            qCDebug(kastsUpdater) << "new episode did not get a valid entryuid; skipping chapters for id:" << entryDetails.id;
+        } else {
+            for (const ChapterDetails &chapterDetails : std::as_const(entryDetails.chapters)) {
+                if (chapterDetails.state == RecordState::New) {
+                    updatedEntryuids.insert(entryDetails.entryuid);
+                    writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
+                    writeQuery.bindValue(QStringLiteral(":start"), chapterDetails.start);
+                    writeQuery.bindValue(QStringLiteral(":title"), chapterDetails.title);
+                    writeQuery.bindValue(QStringLiteral(":link"), chapterDetails.link);
+                    writeQuery.bindValue(QStringLiteral(":image"), chapterDetails.image);
+                    dbExecute(writeQuery);
+                }
+            }
+        }
+    }
+    writeQuery.clear();
+
+    // update chapters
+    writeQuery.prepare(QStringLiteral("UPDATE Chapters SET title=:title, link=:link, image=:image WHERE entryuid=:entryuid AND start=:start;"));
+    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
+        for (const ChapterDetails &chapterDetails : std::as_const(entryDetails.chapters)) {
+            if (chapterDetails.state == RecordState::Modified) {
+                updatedEntryuids.insert(entryDetails.entryuid);
+                writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
+                writeQuery.bindValue(QStringLiteral(":start"), chapterDetails.start);
+                writeQuery.bindValue(QStringLiteral(":title"), chapterDetails.title);
+                writeQuery.bindValue(QStringLiteral(":link"), chapterDetails.link);
+                writeQuery.bindValue(QStringLiteral(":image"), chapterDetails.image);
+                dbExecute(writeQuery);
+            }
+        }
+    }
+    writeQuery.clear();
+
+    // We don't delete chapters that haven't been found anymore, since they could also have been added through other means
+    // e.g. id3 tags.
+
+    // set custom amount of episodes to unread/new if required
+    if (updatedFeed.isNew && (SettingsManager::self()->markUnreadOnNewFeed() == 1) && (SettingsManager::self()->markUnreadOnNewFeedCustomAmount() > 0)) {
+        writeQuery.prepare(
+            QStringLiteral("UPDATE Entries SET read=:read, new=:new WHERE entryuid in (SELECT entryuid FROM Entries WHERE feeduid =:feeduid ORDER BY updated "
+                           "DESC LIMIT :recentUnread);"));
+        writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
+        writeQuery.bindValue(QStringLiteral(":read"), false);
+        writeQuery.bindValue(QStringLiteral(":new"), true);
+        writeQuery.bindValue(QStringLiteral(":recentUnread"), SettingsManager::self()->markUnreadOnNewFeedCustomAmount());
+        dbExecute(writeQuery);
+        writeQuery.clear();
+    }
+
+    if (updatedFeed.isNew) {
+        // Finally, reset the new flag to false now that the new feed has been
+        // fully processed.  If we would reset the flag sooner, then too many
+        // episodes will get flagged as new if the initial import gets
+        // interrupted somehow.
+        writeQuery.prepare(QStringLiteral("UPDATE Feeds SET new=:new WHERE feeduid=:feeduid;"));
+        writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
+        writeQuery.bindValue(QStringLiteral(":new"), false);
+        dbExecute(writeQuery);
+        writeQuery.clear();
+    }
+
+    if (updatedFeed.changedFields & FeedDetails::LastHash) {
+        // the validators for conditional requests belong with the hash: they
+        // should only be stored once the feed has been fully processed
+        writeQuery.prepare(
+            QStringLiteral("UPDATE Feeds SET lastHash=:lastHash, etag=:etag, lastModified=:lastModified, lastSize=:lastSize WHERE feeduid=:feeduid;"));
+        writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
+        writeQuery.bindValue(QStringLiteral(":lastHash"), updatedFeed.lastHash);
+        writeQuery.bindValue(QStringLiteral(":etag"), updatedFeed.etag);
+        writeQuery.bindValue(QStringLiteral(":lastModified"), updatedFeed.lastModified);
+        writeQuery.bindValue(QStringLiteral(":lastSize"), updatedFeed.lastSize);
+        dbExecute(writeQuery);
+        writeQuery.clear();
+    }
+}
+
+bool FeedDatabaseWriter::dbExecute(QSqlQuery &query)
+{
+    bool state = Database::executeThread(query);
+
+    if (!state) {
+        Q_EMIT error(Error::Type::Database, QString(), QString(), query.lastError().type(), query.lastQuery(), query.lastError().text());
+    }
+
+    return state;
+}
+
+bool FeedDatabaseWriter::dbTransaction()
+{
+    // use raw sqlite query to benefit from automatic retries on execute
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.prepare(QStringLiteral("BEGIN IMMEDIATE TRANSACTION;"));
+    return dbExecute(query);
+}
+
+bool FeedDatabaseWriter::dbCommit()
+{
+    // use raw sqlite query to benefit from automatic retries on execute
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.prepare(QStringLiteral("COMMIT TRANSACTION;"));
+    return dbExecute(query);
+}
@@ -0,0 +1,77 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QSqlQuery>
+#include <QString>
+#include <QTimer>
+
+#include "datatypes.h"
+#include "error.h"
+
+// Writes the changes of updated feeds to the database.  It is meant to live
+// in a dedicated thread: rather than having every feed update compete for
+// the database write lock, the changes of several feeds are collected and
+// committed in a single transaction.  A batch is committed as soon as it
+// contains enough changes or when the oldest change has been waiting long
+// enough.
+class FeedDatabaseWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FeedDatabaseWriter(QObject *parent = nullptr);
+    ~FeedDatabaseWriter();
+
+    // both have to be called from the thread that this object lives in
+    void enqueue(const DataTypes::FeedWrite &feedWrite);
+    void flush();
+
+Q_SIGNALS:
+    void feedDetailsUpdated(const qint64 feeduid,
+                            const QString &url,
+                            const QString &name,
+                            const QString &image,
+                            const QString &link,
+                            const QString &description,
+                            const QDateTime &lastUpdated,
+                            const QString &dirname);
+    void feedUpdated(const qint64 feeduid);
+    void entriesAdded(const qint64 feeduid, const QSet<qint64> &entryuids);
+    void entriesUpdated(const qint64 feeduid, const QSet<qint64> &entryuids);
+    void feedUrlChanged(const qint64 feeduid, const QString &oldUrl, const QString &newUrl);
+    void feedFailureStateChanged(const qint64 feeduid, const int failureCount, const QDateTime &retryAfter, const bool paused);
+    void error(Error::Type type, const QString &url, const QString &id, const int errorId, const QString &errorString, const QString &title);
+
+    // emitted after every commit; items is the total amount of items in
+    // the processed feeds and times are in milliseconds
+    void feedsWritten(const QList<qint64> &feeduids, const int items, const qint64 lockWaitTime, const qint64 writeTime);
+
+private:
+    void writeFeed(DataTypes::FeedWrite &feedWrite, QSet<qint64> &newEntryuids, QSet<qint64> &updatedEntryuids);
+    void writeFeedUrl(DataTypes::FeedWrite &feedWrite);
+    void writeFeedStats(const qint64 feeduid, const DataTypes::FeedStats &stats);
+    void writeFeedDetails(DataTypes::FeedDetails &updatedFeed, QSet<qint64> &newEntryuids, QSet<qint64> &updatedEntryuids);
+
+    bool dbExecute(QSqlQuery &query);
+    bool dbTransaction();
+    bool dbCommit();
+
+    QList<DataTypes::FeedWrite> m_pending;
+    int m_pendingChanges = 0;
+    QTimer *m_flushTimer;
+    bool m_databaseOpen = false;
+
+    inline static const QString m_connectionName = QStringLiteral("FeedDatabaseWriter");
+    inline static const int m_maxBatchChanges = 2000; // commit once this amount of records has to be written
+    inline static const int m_maxBatchDelay = 250; // commit at the latest this amount of milliseconds after the first change has been queued
+    inline static const int m_maxStatsPerFeed = 20; // amount of update runs for which the metrics are kept
+};
@@ -0,0 +1,285 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "feeddownloader.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QNetworkRequest>
+#include <QUrl>
+
+#include <algorithm>
+
+#include <KLocalizedString>
+
+#include "updaterlogging.h"
+
+FeedDownloader::FeedDownloader(QObject *parent)
+    : QObject(parent)
+    , m_manager(new NetworkAccessManager(this))
+{
+}
+
+FeedDownloader::~FeedDownloader()
+{
+    const QList<QNetworkReply *> replies = m_downloads.keys();
+    for (QNetworkReply *reply : replies) {
+        PendingDownload *pending = m_downloads.take(reply);
+        reply->disconnect(this);
+        reply->abort();
+        pending->file.remove();
+        delete pending;
+    }
+}
+
+void FeedDownloader::download(const qint64 feeduid, const QString &url, const QString &etag, const QString &lastModified)
+{
+    // Stream the body into a temporary file and hash it on the fly, such
+    // that memory usage stays bounded, even for huge feeds
+    PendingDownload *pending = new PendingDownload;
+    pending->feeduid = feeduid;
+    pending->url = url;
+    pending->etag = etag;
+    pending->lastModified = lastModified;
+    pending->file.setFileTemplate(QDir::tempPath() + QStringLiteral("/kasts-feed-XXXXXX"));
+    pending->file.setAutoRemove(false); // the file will be removed by the job processing it
+
+    if (m_abort || !pending->file.open()) {
+        if (!m_abort) {
+            qCDebug(kastsUpdater) << "Could not open temporary file to store feed" << feeduid << pending->file.errorString();
+        }
+        delete pending;
+        DataTypes::FeedDownload result;
+        result.feeduid = feeduid;
+        Q_EMIT downloadFinished(result);
+        return;
+    }
+
+    pending->timer.start();
+    startRequest(pending, QUrl(url));
+
+    qCDebug(kastsUpdater) << "Started download of feed" << feeduid;
+}
+
+void FeedDownloader::startRequest(PendingDownload *pending, const QUrl &url)
+{
+    QNetworkRequest request(url);
+    request.setTransferTimeout();
+    // this is the default, but make it explicit since it allows for several
+    // feeds on the same server to be downloaded over a single connection
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::ManualRedirectPolicy);
+    if (!pending->etag.isEmpty()) {
+        request.setRawHeader("If-None-Match", pending->etag.toLatin1());
+    }
+    if (!pending->lastModified.isEmpty()) {
+        request.setRawHeader("If-Modified-Since", pending->lastModified.toLatin1());
+    }
+
+    QNetworkReply *reply = m_manager->get(request);
+    m_downloads[reply] = pending;
+
+    // these signals are used to find out where the time is being spent;
+    // socketStartedConnecting is not emitted if a connection is reused
+    connect(reply, &QNetworkReply::socketStartedConnecting, this, [pending]() {
+        if (pending->connectingStarted < 0) {
+            pending->connectingStarted = pending->timer.elapsed();
+        }
+    });
+    connect(reply, &QNetworkReply::encrypted, this, [pending]() {
+        pending->tlsHandshake = true;
+    });
+    connect(reply, &QNetworkReply::requestSent, this, [pending]() {
+        pending->requestSent = pending->timer.elapsed();
+    });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [pending]() {
+        if (pending->firstByte < 0) {
+            pending->firstByte = pending->timer.elapsed();
+        }
+    });
+    connect(reply, &QNetworkReply::readyRead, this, [this, reply]() {
+        readData(reply);
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        finishDownload(reply);
+    });
+}
+
+void FeedDownloader::abort()
+{
+    m_abort = true;
+    const QList<QNetworkReply *> replies = m_downloads.keys();
+    for (QNetworkReply *reply : replies) {
+        reply->abort();
+    }
+}
+
+void FeedDownloader::readData(QNetworkReply *reply)
+{
+    PendingDownload *pending = m_downloads.value(reply);
+    if (!pending || pending->writeError) {
+        return;
+    }
+
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode < 200 || statusCode >= 300) {
+        return; // don't store redirect, "not modified" or error bodies
+    }
+
+    const QByteArray chunk = reply->readAll();
+    pending->hash.addData(chunk);
+    if (pending->file.write(chunk) != chunk.size()) {
+        pending->writeError = true;
+        reply->abort();
+    }
+}
+
+void FeedDownloader::finishDownload(QNetworkReply *reply)
+{
+    // make sure that everything has been read and written to disk
+    readData(reply);
+
+    PendingDownload *pending = m_downloads.take(reply);
+    if (!pending) {
+        reply->deleteLater();
+        return;
+    }
+
+    if (followRedirect(reply, pending)) {
+        reply->deleteLater();
+        return;
+    }
+
+    DataTypes::FeedDownload result;
+    result.feeduid = pending->feeduid;
+    result.stats = networkStats(pending);
+    result.httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    result.networkError = reply->error();
+    result.writeError = pending->writeError;
+    result.retryAfter = retryAfter(reply);
+    result.connectionReused = (pending->connectingStarted < 0 && pending->requestSent >= 0);
+    result.tlsHandshake = pending->tlsHandshake;
+    result.http2 = reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+
+    if (pending->writeError) {
+        qCDebug(kastsUpdater) << "Could not write feed to temporary file" << pending->file.fileName() << pending->file.errorString();
+    } else if (reply->error()) {
+        if (!m_abort) {
+            qCDebug(kastsUpdater) << "Error fetching feed" << pending->feeduid << reply->errorString();
+            Q_EMIT error(Error::Type::FeedUpdate, pending->url, QString(), reply->error(), reply->errorString(), QString());
+        } else {
+            qCDebug(kastsUpdater) << "Aborted network reply to fetch feed" << pending->feeduid;
+        }
+    } else if (result.httpStatus >= 300 && result.httpStatus < 400 && result.httpStatus != 304) {
+        // redirect that could not be followed
+        if (!m_abort) {
+            QNetworkReply::NetworkError errorId = QNetworkReply::InsecureRedirectError;
+            QString errorString = i18n("Insecure redirect");
+            if (pending->redirects >= m_maxRedirects) {
+                errorId = QNetworkReply::TooManyRedirectsError;
+                errorString = i18n("Too many redirects");
+            } else if (!reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl().isValid()) {
+                errorId = QNetworkReply::ProtocolFailure;
+                errorString = i18n("Redirect without target");
+            }
+            qCDebug(kastsUpdater) << "Error fetching feed" << pending->feeduid << errorString;
+            Q_EMIT error(Error::Type::FeedUpdate, pending->url, QString(), errorId, errorString, QString());
+        }
+    } else if (result.httpStatus == 304) {
+        result.status = DataTypes::NotModified;
+    } else {
+        pending->file.flush();
+        result.status = DataTypes::Downloaded;
+        result.fileName = pending->file.fileName();
+        result.hash = QString::fromLatin1(pending->hash.result().toHex());
+        result.etag = QString::fromLatin1(reply->rawHeader("ETag"));
+        result.lastModified = QString::fromLatin1(reply->rawHeader("Last-Modified"));
+        result.size = pending->file.size();
+        result.stats.bytes = result.size;
+    }
+
+    // only move the feed if the new location actually works
+    if (result.status != DataTypes::DownloadFailed && pending->permanentUrl.isValid()) {
+        result.redirectedUrl = pending->permanentUrl.toString();
+    }
+
+    pending->file.close();
+    if (result.status != DataTypes::Downloaded) {
+        pending->file.remove();
+    }
+    delete pending;
+    reply->deleteLater();
+
+    qCDebug(kastsUpdater) << "Finished download of feed" << result.feeduid << "with status" << result.status;
+    Q_EMIT downloadFinished(result);
+}
+
+bool FeedDownloader::followRedirect(QNetworkReply *reply, PendingDownload *pending)
+{
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const QUrl target = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+    if (m_abort || pending->writeError || reply->error() || statusCode < 300 || statusCode >= 400 || statusCode == 304 || !target.isValid()) {
+        return false;
+    }
+
+    // same restrictions as QNetworkRequest::NoLessSafeRedirectPolicy, which
+    // is used for all other requests
+    const QUrl url = reply->url().resolved(target);
+    if (pending->redirects >= m_maxRedirects || (reply->url().scheme() == QStringLiteral("https") && url.scheme() == QStringLiteral("http"))) {
+        return false;
+    }
+    pending->redirects++;
+
+    // the feed has only moved permanently if every hop up to here was
+    // permanent; a temporary hop (e.g. through a tracking service) ends the
+    // part of the chain that can be skipped in the future
+    if (pending->onlyPermanentRedirects && (statusCode == 301 || statusCode == 308)) {
+        pending->permanentUrl = url;
+    } else {
+        pending->onlyPermanentRedirects = false;
+    }
+
+    qCDebug(kastsUpdater) << "Feed" << pending->feeduid << "redirected with status" << statusCode << "to" << url;
+
+    // the time until the first byte of the final response has to be measured
+    // from the last request onwards
+    pending->firstByte = -1;
+    startRequest(pending, url);
+    return true;
+}
+
+DataTypes::FeedStats FeedDownloader::networkStats(const PendingDownload *pending) const
+{
+    const qint64 finished = pending->timer.elapsed();
+    const qint64 connectingStarted = pending->connectingStarted;
+    const qint64 requestSent = pending->requestSent >= 0 ? pending->requestSent : std::max(connectingStarted, qint64(0));
+    const qint64 firstByte = pending->firstByte >= 0 ? pending->firstByte : finished;
+
+    DataTypes::FeedStats stats;
+    stats.lookupTime = connectingStarted >= 0 ? connectingStarted : requestSent;
+    stats.connectTime = connectingStarted >= 0 ? std::max(requestSent - connectingStarted, qint64(0)) : 0;
+    stats.firstByteTime = std::max(firstByte - requestSent, qint64(0));
+    stats.downloadTime = std::max(finished - firstByte, qint64(0));
+    return stats;
+}
+
+qint64 FeedDownloader::retryAfter(const QNetworkReply *reply) const
+{
+    // Retry-After can either be a delay in seconds or an HTTP date
+    const QString value = QString::fromLatin1(reply->rawHeader("Retry-After")).trimmed();
+    if (value.isEmpty()) {
+        return 0;
+    }
+
+    bool ok;
+    const qint64 delay = value.toLongLong(&ok);
+    if (ok) {
+        return QDateTime::currentSecsSinceEpoch() + std::max(delay, qint64(0));
+    }
+
+    const QDateTime date = QDateTime::fromString(value, Qt::RFC2822Date);
+    return date.isValid() ? date.toSecsSinceEpoch() : 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QNetworkReply>
+#include <QObject>
+#include <QString>
+#include <QTemporaryFile>
+#include <QUrl>
+
+#include "datatypes.h"
+#include "error.h"
+#include "networkaccessmanager.h"
+
+// Downloads feeds asynchronously using a single, shared network access
+// manager.  It is meant to live in a dedicated network thread, such that
+// the threads that parse and process the feeds never wait for the network.
+// Since all feeds share the same network access manager, connections
+// (including TLS sessions and HTTP/2 connections) to the same server are
+// reused between feeds.
+class FeedDownloader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FeedDownloader(QObject *parent = nullptr);
+    ~FeedDownloader();
+
+    // etag and lastModified are used to make a conditional request; pass
+    // empty strings to unconditionally download the feed
+    void download(const qint64 feeduid, const QString &url, const QString &etag, const QString &lastModified);
+    void abort();
+
+Q_SIGNALS:
+    void downloadFinished(const DataTypes::FeedDownload &download);
+    void error(Error::Type type, const QString &url, const QString &id, const int errorId, const QString &errorString, const QString &title);
+
+private:
+    struct PendingDownload {
+        qint64 feeduid;
+        QString url;
+        QString etag;
+        QString lastModified;
+        QTemporaryFile file;
+        QCryptographicHash hash{QCryptographicHash::Sha256};
+        bool writeError = false;
+
+        // milliseconds since the request was started; -1 if the
+        // corresponding stage has not been reached (yet)
+        QElapsedTimer timer;
+        qint64 connectingStarted = -1;
+        qint64 requestSent = -1;
+        qint64 firstByte = -1;
+        bool tlsHandshake = false;
+
+        // redirects are followed manually in order to find out whether the
+        // feed has moved permanently
+        int redirects = 0;
+        bool onlyPermanentRedirects = true;
+        QUrl permanentUrl;
+    };
+
+    void startRequest(PendingDownload *pending, const QUrl &url);
+    void readData(QNetworkReply *reply);
+    void finishDownload(QNetworkReply *reply);
+    bool followRedirect(QNetworkReply *reply, PendingDownload *pending);
+    DataTypes::FeedStats networkStats(const PendingDownload *pending) const;
+    qint64 retryAfter(const QNetworkReply *reply) const;
+
+    NetworkAccessManager *m_manager;
+    QHash<QNetworkReply *, PendingDownload *> m_downloads;
+    bool m_abort = false;
+
+    inline static const int m_maxRedirects = 50; // same as the default of QNetworkRequest
+};
@@ -7,6 +7,7 @@
 #include "fetchfeedsjob.h"
 
 #include <QCryptographicHash>
+#include <QDateTime>
 #include <QObject>
 #include <QSqlQuery>
 #include <QTimer>
@@ -14,11 +15,17 @@
 #include <KLocalizedString>
 #include <ThreadWeaver/Queue>
 #include <ThreadWeaver/ThreadWeaver>
+#include <algorithm>
+#include <limits>
 #include <utility>
 
 #include "database.h"
 #include "datamanager.h"
+#include "feeddatabasewriter.h"
+#include "feeddownloader.h"
 #include "fetcher.h"
+#include "jobqueues.h"
+#include "memoryusage.h"
 #include "settingsmanager.h"
 #include "updatefeedjob.h"
 #include "updaterlogging.h"
@@ -26,13 +33,23 @@
 using namespace ThreadWeaver;
 
 // TODO: refactor to feeduids
-FetchFeedsJob::FetchFeedsJob(const QStringList &urls, QObject *parent)
+FetchFeedsJob::FetchFeedsJob(const QStringList &urls, DataTypes::FetchPriority priority, QObject *parent)
     : KJob(parent)
     , m_urls(urls)
+    , m_priority(priority)
 {
     connect(this, &FetchFeedsJob::processedAmountChanged, this, &FetchFeedsJob::monitorProgress);
 }
 
+FetchFeedsJob::~FetchFeedsJob()
+{
+    m_networkThread.quit();
+    m_networkThread.wait();
+    // the writer will commit any remaining changes when it is destroyed
+    m_writerThread.quit();
+    m_writerThread.wait();
+}
+
 void FetchFeedsJob::start()
 {
     QTimer::singleShot(0, this, &FetchFeedsJob::fetch);
@@ -45,80 +62,332 @@ void FetchFeedsJob::fetch()
         return;
     }
 
-    QHash<QString, QList<qint64>> feeduidsPerHost;
+    m_refreshTimer.start();
+    setProcessedAmount(KJob::Unit::Items, 0);
+
+    // The feeds are downloaded asynchronously on a dedicated network thread;
+    // the CPU queue, which is sized to the number of cores, is only used to
+    // parse and process the downloaded feeds
+    m_downloader = new FeedDownloader;
+    m_downloader->moveToThread(&m_networkThread);
+    connect(&m_networkThread, &QThread::finished, m_downloader, &QObject::deleteLater);
+    connect(m_downloader, &FeedDownloader::downloadFinished, this, &FetchFeedsJob::processDownload);
+    connect(m_downloader, &FeedDownloader::error, &Fetcher::instance(), &Fetcher::error);
+    connect(this, &FetchFeedsJob::aborting, m_downloader, &FeedDownloader::abort);
+    m_networkThread.start();
+
+    // All changes are written to the database by a single writer, which
+    // commits the changes of several feeds in one transaction
+    m_writer = new FeedDatabaseWriter;
+    m_writer->moveToThread(&m_writerThread);
+    connect(&m_writerThread, &QThread::finished, m_writer, &QObject::deleteLater);
+    connect(m_writer,
+            &FeedDatabaseWriter::feedsWritten,
+            this,
+            [this](const QList<qint64> &feeduids, const int items, const qint64 lockWaitTime, const qint64 writeTime) {
+                m_items += items;
+                m_lockWaitTime += lockWaitTime;
+                m_writeTime += writeTime;
+                for (const qint64 feeduid : feeduids) {
+                    feedFinished(feeduid);
+                }
+            });
+    // keep track of the entries that have been added during this refresh,
+    // such that only those have to be considered for auto-queueing
+    connect(m_writer, &FeedDatabaseWriter::entriesAdded, this, [this](const qint64 feeduid, const QSet<qint64> &entryuids) {
+        m_newEntryuids += entryuids;
+        if (m_interactiveRequests.contains(feeduid)) {
+            qCInfo(kastsUpdater) << "Time to first entries for feed" << feeduid << ":" << m_interactiveRequests.take(feeduid).elapsed() << "ms";
+        }
+    });
+    m_writerThread.start();
+
+    qCDebug(kastsUpdater) << "Number of feed update threads:" << JobQueues::cpuQueue()->maximumNumberOfThreads();
+
+    queueFeeds(m_urls, m_priority);
+
+    if (m_feeduids.isEmpty()) {
+        qCInfo(kastsUpdater) << "No feeds left to fetch; skipped" << m_skippedFeeds << "feeds because of failed previous updates, saving an estimated"
+                             << m_skippedTime << "ms";
+        emitResult();
+        return;
+    }
+
+    startFeedDownloads();
+    qCDebug(kastsUpdater) << "End of FetchFeedsJob::fetch";
+}
+
+void FetchFeedsJob::addFeeds(const QStringList &urls, DataTypes::FetchPriority priority)
+{
+    if (!m_downloader) {
+        // the job has not started yet
+        m_urls += urls;
+        m_priority = std::min(m_priority, priority);
+        return;
+    }
+
+    if (m_abort) {
+        return;
+    }
+
+    queueFeeds(urls, priority);
+    startFeedDownloads();
+}
 
-    // First get the last hashes from the database to know which feeds have actually been updated
+void FetchFeedsJob::queueFeeds(const QStringList &urls, DataTypes::FetchPriority priority)
+{
+    // First get the feeduids from the database, together with the size of
+    // the previous download, which is used as an estimate for the cost of
+    // updating the feed
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    QList<qint64> newFeeduids;
+    QList<qint64> skippedFeeduids;
     QSqlQuery query;
-    query.prepare(QStringLiteral("SELECT feeduid FROM Feeds WHERE url=:url;"));
-    for (const QString &url : std::as_const(m_urls)) {
+    query.prepare(QStringLiteral("SELECT feeduid, lastHash, etag, lastModified, lastSize, retryAfter, paused FROM Feeds WHERE url=:url;"));
+    for (const QString &url : urls) {
         query.bindValue(QStringLiteral(":url"), url);
         if (!Database::instance().execute(query)) {
             return;
         }
-        if (query.next()) {
-            qint64 feeduid = query.value(QStringLiteral("feeduid")).toLongLong();
-            m_feeduids += feeduid;
-            feeduidsPerHost[QUrl(url).host()] += feeduid;
+        if (!query.next()) {
+            continue;
+        }
+
+        const qint64 feeduid = query.value(QStringLiteral("feeduid")).toLongLong();
+
+        // The feed might already be part of this refresh: if it's still
+        // waiting to be downloaded, it might have to move up the queue; if it
+        // is being processed, there is nothing to do
+        if (m_feeduids.contains(feeduid) && !m_finishedFeeds.contains(feeduid)) {
+            for (PendingFeed &pendingFeed : m_pendingFeeds) {
+                if (pendingFeed.feeduid == feeduid && priority < pendingFeed.priority) {
+                    pendingFeed.priority = priority;
+                }
+            }
+            if (priority == DataTypes::InteractiveFetch && !m_interactiveRequests.contains(feeduid)) {
+                m_interactiveRequests[feeduid].start();
+            }
+            continue;
+        }
+
+        // Don't waste time on feeds that keep on failing, unless the user
+        // explicitly asked for an update
+        if (priority != DataTypes::InteractiveFetch
+            && (query.value(QStringLiteral("paused")).toBool() || query.value(QStringLiteral("retryAfter")).toLongLong() > now)) {
+            skippedFeeduids += feeduid;
+            continue;
+        }
+
+        PendingFeed pendingFeed;
+        pendingFeed.feeduid = feeduid;
+        pendingFeed.url = url;
+        pendingFeed.host = QUrl(url).host();
+        pendingFeed.priority = priority;
+        pendingFeed.lastSize = query.value(QStringLiteral("lastSize")).toLongLong();
+        // feeds that have never been downloaded before are considered to
+        // be the most expensive, since they will have to be processed
+        // completely
+        pendingFeed.cost = pendingFeed.lastSize > 0 ? pendingFeed.lastSize : std::numeric_limits<qint64>::max();
+        // Make this a conditional request if the server has provided
+        // validators during the previous update.  This is only done if
+        // that update has been fully processed (i.e. lastHash is set);
+        // otherwise we have to get the full feed anyway.
+        if (!query.value(QStringLiteral("lastHash")).toString().isEmpty()) {
+            pendingFeed.etag = query.value(QStringLiteral("etag")).toString();
+            pendingFeed.lastModified = query.value(QStringLiteral("lastModified")).toString();
+        }
+        if (priority == DataTypes::InteractiveFetch) {
+            m_interactiveRequests[feeduid].start();
         }
+        m_finishedFeeds.remove(feeduid);
+        m_feeduids += feeduid;
+        newFeeduids += feeduid;
+        m_pendingFeeds += pendingFeed;
     }
     query.finish(); // release lock on database
 
-    qCDebug(kastsUpdater) << "list of feeduids to fetch" << m_feeduids;
-    qCDebug(kastsUpdater) << "list of feeduids per host" << feeduidsPerHost;
+    // Estimate the time saved by skipping feeds from their previous updates
+    if (!skippedFeeduids.isEmpty()) {
+        m_skippedFeeds += skippedFeeduids.count();
+        query.prepare(QStringLiteral("SELECT AVG(lookupTime + connectTime + firstByteTime + downloadTime + parseTime + processTime + writeTime) "
+                                     "FROM FeedStats WHERE feeduid=:feeduid;"));
+        for (const qint64 feeduid : std::as_const(skippedFeeduids)) {
+            query.bindValue(QStringLiteral(":feeduid"), feeduid);
+            Database::instance().execute(query);
+            if (query.next()) {
+                m_skippedTime += qRound64(query.value(0).toDouble());
+            }
+        }
+        query.finish();
+        qCDebug(kastsUpdater) << "Skipping feeds that are backing off or paused:" << skippedFeeduids;
+    }
 
-    setTotalAmount(KJob::Unit::Items, m_feeduids.count());
-    setProcessedAmount(KJob::Unit::Items, 0);
+    // Higher priority updates go first; within the same priority, start the
+    // most expensive updates first, such that they don't end up being the
+    // stragglers at the end of the refresh
+    std::stable_sort(m_pendingFeeds.begin(), m_pendingFeeds.end(), [](const PendingFeed &a, const PendingFeed &b) {
+        return a.priority != b.priority ? a.priority < b.priority : a.cost > b.cost;
+    });
 
-    qCDebug(kastsUpdater) << "Number of feed update threads:" << Queue::instance()->currentNumberOfThreads();
-
-    // we make sure to download and process feeds from the same host in sequence
-    // because otherwise there is a chance that we get temporarily banned for
-    // too many simultaneous downloads
-    for (const QList<qint64> &feeduids : std::as_const(feeduidsPerHost)) {
-        ThreadWeaver::Sequence *s = new ThreadWeaver::Sequence;
-        for (const qint64 feeduid : std::as_const(feeduids)) {
-            qCDebug(kastsUpdater) << "Starting to fetch" << feeduid;
-            Q_EMIT Fetcher::instance().feedUpdateStatusChanged(feeduid, true);
-
-            UpdateFeedJob *updateFeedJob = new UpdateFeedJob(feeduid, this);
-            connect(this, &FetchFeedsJob::aborting, updateFeedJob, &UpdateFeedJob::abort);
-            connect(updateFeedJob, &UpdateFeedJob::finished, this, [this, feeduid]() {
-                // TODO: add error processing
-                setProcessedAmount(KJob::Unit::Items, processedAmount(KJob::Unit::Items) + 1);
-                Q_EMIT Fetcher::instance().feedUpdateStatusChanged(feeduid, false);
-            });
+    qCDebug(kastsUpdater) << "list of feeduids to fetch with priority" << priority << newFeeduids;
+    for (const qint64 feeduid : std::as_const(newFeeduids)) {
+        Q_EMIT Fetcher::instance().feedUpdateStatusChanged(feeduid, true);
+    }
+
+    if (!newFeeduids.isEmpty()) {
+        setTotalAmount(KJob::Unit::Items, totalAmount(KJob::Unit::Items) + newFeeduids.count());
+    }
+}
 
-            *s << updateFeedJob;
-            qCDebug(kastsUpdater) << "Enqueued updateFeedJob for feed" << feeduid;
+void FetchFeedsJob::startFeedDownloads()
+{
+    // If the job has been aborted, the pending updates are not started at
+    // all, but they still have to be accounted for
+    if (m_abort) {
+        const QList<PendingFeed> pendingFeeds = m_pendingFeeds;
+        m_pendingFeeds.clear();
+        for (const PendingFeed &pendingFeed : pendingFeeds) {
+            Q_EMIT Fetcher::instance().feedUpdateStatusChanged(pendingFeed.feeduid, false);
         }
-        Queue::instance()->stream() << s;
+        setProcessedAmount(KJob::Unit::Items, processedAmount(KJob::Unit::Items) + pendingFeeds.count());
+        return;
+    }
+
+    // We limit the number of simultaneous downloads from the same host
+    // because otherwise there is a chance that we get temporarily banned
+    const int maxParallel = std::max(1, SettingsManager::self()->maximumParallelFeedUpdates());
+    const int maxParallelPerHost = std::max(1, SettingsManager::self()->maximumParallelFeedUpdatesPerHost());
+
+    // Interactive updates get one extra slot that other updates can't use,
+    // such that the user doesn't have to wait until a slot becomes free; any
+    // further interactive updates wait for a slot like the others
+    constexpr int interactiveSlots = 1;
+    for (auto it = m_pendingFeeds.begin(); it != m_pendingFeeds.end();) {
+        const int slots = it->priority == DataTypes::InteractiveFetch ? maxParallel + interactiveSlots : maxParallel;
+        if (m_downloading.count() >= slots) {
+            break; // the pending feeds are sorted by priority
+        }
+        if (m_runningPerHost.value(it->host) >= maxParallelPerHost) {
+            ++it;
+            continue;
+        }
+
+        const PendingFeed pendingFeed = *it;
+        it = m_pendingFeeds.erase(it);
+
+        m_downloading[pendingFeed.feeduid] = pendingFeed;
+        ++m_runningPerHost[pendingFeed.host];
+
+        qCDebug(kastsUpdater) << "Starting to fetch" << pendingFeed.feeduid;
+        QMetaObject::invokeMethod(m_downloader, [downloader = m_downloader, pendingFeed]() {
+            downloader->download(pendingFeed.feeduid, pendingFeed.url, pendingFeed.etag, pendingFeed.lastModified);
+        });
     }
-    qCDebug(kastsUpdater) << "End of FetchFeedsJob::fetch";
+}
+
+void FetchFeedsJob::processDownload(const DataTypes::FeedDownload &download)
+{
+    const PendingFeed pendingFeed = m_downloading.take(download.feeduid);
+    if (--m_runningPerHost[pendingFeed.host] <= 0) {
+        m_runningPerHost.remove(pendingFeed.host);
+    }
+
+    // connection statistics; only for requests that reached the server
+    if (download.httpStatus > 0) {
+        ++(download.connectionReused ? m_reusedConnections : m_newConnections);
+        m_tlsHandshakes += download.tlsHandshake ? 1 : 0;
+        m_http2Requests += download.http2 ? 1 : 0;
+    }
+
+    if (download.status == DataTypes::Downloaded) {
+        m_bytesReceived += download.size;
+    } else if (download.status == DataTypes::NotModified) {
+        // the server confirmed that the feed has not changed since the last update
+        m_bytesSaved += pendingFeed.lastSize;
+        qCDebug(kastsUpdater) << "feed not modified according to server; skipping feed update for" << download.feeduid;
+    }
+
+    // the network slot has been freed up, so start the next download
+    startFeedDownloads();
+
+    // Even if nothing has to be parsed, the job will still have to
+    // schedule the next update of the feed
+    const qint64 feeduid = download.feeduid;
+    UpdateFeedJob *updateFeedJob = new UpdateFeedJob(download, m_writer, pendingFeed.priority, this);
+    connect(this, &FetchFeedsJob::aborting, updateFeedJob, &UpdateFeedJob::abort);
+    if (m_abort) {
+        updateFeedJob->abort();
+    }
+    connect(updateFeedJob, &UpdateFeedJob::finished, this, [this, feeduid, updateFeedJob]() {
+        // TODO: add error processing
+        // If changes have been handed over to the writer, the feed is only
+        // finished once these have been committed
+        if (!updateFeedJob->writeQueued()) {
+            feedFinished(feeduid);
+        }
+    });
+
+    JobQueues::cpuQueue()->stream() << updateFeedJob;
+    qCDebug(kastsUpdater) << "Enqueued updateFeedJob for feed" << feeduid;
+    JobQueues::logOccupancy(QStringLiteral("Enqueued feed update"));
+}
+
+void FetchFeedsJob::feedFinished(const qint64 feeduid)
+{
+    m_finishedFeeds.insert(feeduid);
+    m_interactiveRequests.remove(feeduid);
+
+    Q_EMIT Fetcher::instance().feedUpdateStatusChanged(feeduid, false);
+    setProcessedAmount(KJob::Unit::Items, processedAmount(KJob::Unit::Items) + 1);
 }
 
 void FetchFeedsJob::monitorProgress()
 {
     // Check if all required feeds have finished updating
     if (processedAmount(KJob::Unit::Items) == totalAmount(KJob::Unit::Items)) {
+        // Throughput figures to be able to spot performance regressions
+        // between refreshes of the same set of feeds
+        const qint64 elapsed = m_refreshTimer.elapsed();
+        const double seconds = std::max(elapsed, qint64(1)) / 1000.0;
+        qCInfo(kastsUpdater) << "Feed refresh finished:" << m_feeduids.count() << "feeds in" << elapsed << "ms (" << m_feeduids.count() / seconds << "feeds/s,"
+                             << m_items / seconds << "items/s)";
+        qCInfo(kastsUpdater) << "Feed refresh network:" << m_bytesReceived << "bytes downloaded," << m_bytesSaved << "bytes saved through conditional requests,"
+                             << m_newConnections << "new connections," << m_reusedConnections << "reused connections," << m_tlsHandshakes << "TLS handshakes,"
+                             << m_http2Requests << "requests over HTTP/2";
+        qCInfo(kastsUpdater) << "Feed refresh database:" << m_lockWaitTime << "ms waiting for the database lock," << m_writeTime
+                             << "ms writing to the database, database size" << Database::size() << "bytes";
+        qCInfo(kastsUpdater) << "Feed refresh memory:" << MemoryUsage::peakResidentSetSize() << "bytes peak memory usage";
+        qCInfo(kastsUpdater) << "Feed refresh skipped" << m_skippedFeeds << "feeds because of failed previous updates, saving an estimated" << m_skippedTime
+                             << "ms";
+
         // TODO: this should actually be done after syncing has finished...
 
-        // Check for "new" entries and queue them if necessary
-        if (SettingsManager::self()->autoQueue()) {
+        // Check which of the entries added during this refresh are marked
+        // as "new" and queue them if necessary
+        if (SettingsManager::self()->autoQueue() && !m_newEntryuids.isEmpty()) {
+            QStringList uids;
+            for (const qint64 entryuid : std::as_const(m_newEntryuids)) {
+                uids += QString::number(entryuid);
+            }
+
             QList<qint64> entryuids;
             QSqlQuery query;
-            query.prepare(QStringLiteral("SELECT entryuid FROM Entries WHERE new=:new ORDER BY updated ASC;"));
+            query.prepare(
+                QStringLiteral("SELECT entryuid FROM Entries WHERE new=:new AND entryuid IN (%1) ORDER BY updated ASC;").arg(uids.join(QLatin1Char(','))));
             query.bindValue(QStringLiteral(":new"), true);
             Database::instance().execute(query);
             while (query.next()) {
                 entryuids += query.value(QStringLiteral("entryuid")).toLongLong();
             }
-
-            qCDebug(kastsUpdater) << "Queueing new entries:" << entryuids;
-            DataManager::instance().bulkQueueStatus(true, entryuids);
+            query.finish();
 
             if (SettingsManager::self()->autoDownload()) {
-                qCDebug(kastsUpdater) << "Start downloading queued entries:" << entryuids;
+                // this will also add the entries to the queue
+                qCDebug(kastsUpdater) << "Queueing and downloading new entries:" << entryuids;
                 DataManager::instance().bulkDownloadEnclosures(entryuids);
+            } else {
+                qCDebug(kastsUpdater) << "Queueing new entries:" << entryuids;
+                DataManager::instance().bulkQueueStatus(true, entryuids);
             }
         }
 
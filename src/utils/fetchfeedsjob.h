@@ -7,28 +7,85 @@
 #pragma once
 
 #include <KJob>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QThread>
 #include <QVector>
 
+#include "datatypes.h"
+
+class FeedDatabaseWriter;
+class FeedDownloader;
+
 class FetchFeedsJob : public KJob
 {
     Q_OBJECT
 
 public:
-    explicit FetchFeedsJob(const QStringList &urls, QObject *parent = nullptr);
+    // unless priority is InteractiveFetch, feeds that are backing off after
+    // failed updates or whose updates are paused are skipped
+    explicit FetchFeedsJob(const QStringList &urls, DataTypes::FetchPriority priority, QObject *parent = nullptr);
+    ~FetchFeedsJob();
 
     void start() override;
     bool aborted();
     void abort();
 
+    // add feeds to a job that is already running
+    void addFeeds(const QStringList &urls, DataTypes::FetchPriority priority);
+
 Q_SIGNALS:
     void aborting();
 
 private:
     QStringList m_urls;
+    DataTypes::FetchPriority m_priority;
     QList<qint64> m_feeduids;
+    QSet<qint64> m_newEntryuids; // entries that have been added during this refresh
 
     void fetch();
+    void queueFeeds(const QStringList &urls, DataTypes::FetchPriority priority);
+    void startFeedDownloads();
+    void processDownload(const DataTypes::FeedDownload &download);
+    void feedFinished(const qint64 feeduid);
     void monitorProgress();
 
+    struct PendingFeed {
+        qint64 feeduid = 0;
+        QString url;
+        QString host;
+        DataTypes::FetchPriority priority = DataTypes::NormalFetch;
+        QString etag;
+        QString lastModified;
+        qint64 lastSize = 0;
+        qint64 cost = 0; // estimated cost of the update: size of the previous download
+    };
+
+    QList<PendingFeed> m_pendingFeeds; // sorted by priority and descending cost
+    QSet<qint64> m_finishedFeeds;
+    QHash<qint64, QElapsedTimer> m_interactiveRequests; // key = feeduid; used to measure time to first entries
+    QHash<qint64, PendingFeed> m_downloading; // key = feeduid
+    QHash<QString, int> m_runningPerHost;
+
+    QThread m_networkThread;
+    FeedDownloader *m_downloader = nullptr; // lives in m_networkThread
+    QThread m_writerThread;
+    FeedDatabaseWriter *m_writer = nullptr; // lives in m_writerThread
+    QElapsedTimer m_refreshTimer;
+
     bool m_abort = false;
+
+    qint64 m_bytesReceived = 0;
+    qint64 m_bytesSaved = 0;
+    int m_newConnections = 0;
+    int m_reusedConnections = 0;
+    int m_tlsHandshakes = 0;
+    int m_http2Requests = 0;
+    qint64 m_items = 0;
+    int m_skippedFeeds = 0; // because of backoff or paused updates
+    qint64 m_skippedTime = 0; // estimated update time saved by skipping feeds
+    qint64 m_lockWaitTime = 0;
+    qint64 m_writeTime = 0;
 };
@@ -0,0 +1,204 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "htmlutils.h"
+
+#include <QHash>
+#include <QStringList>
+#include <QStringView>
+
+namespace
+{
+// the named entities that are likely to show up in titles; unknown entities
+// are kept as they are
+const QHash<QString, char32_t> &namedEntities()
+{
+    static const QHash<QString, char32_t> entities = {
+        {QStringLiteral("amp"), U'&'},
+        {QStringLiteral("lt"), U'<'},
+        {QStringLiteral("gt"), U'>'},
+        {QStringLiteral("quot"), U'"'},
+        {QStringLiteral("apos"), U'\''},
+        {QStringLiteral("nbsp"), 0x00A0},
+        {QStringLiteral("ndash"), 0x2013},
+        {QStringLiteral("mdash"), 0x2014},
+        {QStringLiteral("hellip"), 0x2026},
+        {QStringLiteral("lsquo"), 0x2018},
+        {QStringLiteral("rsquo"), 0x2019},
+        {QStringLiteral("ldquo"), 0x201C},
+        {QStringLiteral("rdquo"), 0x201D},
+        {QStringLiteral("laquo"), 0x00AB},
+        {QStringLiteral("raquo"), 0x00BB},
+        {QStringLiteral("copy"), 0x00A9},
+        {QStringLiteral("reg"), 0x00AE},
+        {QStringLiteral("trade"), 0x2122},
+        {QStringLiteral("euro"), 0x20AC},
+        {QStringLiteral("pound"), 0x00A3},
+        {QStringLiteral("deg"), 0x00B0},
+        {QStringLiteral("middot"), 0x00B7},
+        {QStringLiteral("bull"), 0x2022},
+        {QStringLiteral("times"), 0x00D7},
+    };
+    return entities;
+}
+
+bool isBlockElement(QStringView name)
+{
+    static const QStringList blockElements = {QStringLiteral("br"),
+                                              QStringLiteral("p"),
+                                              QStringLiteral("div"),
+                                              QStringLiteral("li"),
+                                              QStringLiteral("tr"),
+                                              QStringLiteral("h1"),
+                                              QStringLiteral("h2"),
+                                              QStringLiteral("h3"),
+                                              QStringLiteral("h4"),
+                                              QStringLiteral("h5"),
+                                              QStringLiteral("h6"),
+                                              QStringLiteral("blockquote")};
+    for (const QString &element : blockElements) {
+        if (name.compare(element, Qt::CaseInsensitive) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Appends character c while collapsing whitespace; newlines are kept, but
+// never more than one in a row.  Non-breaking spaces count as whitespace too,
+// like in QString::simplified().
+void appendChar(QString &result, QChar c)
+{
+    if (c == QLatin1Char('\n')) {
+        while (result.endsWith(QLatin1Char(' '))) {
+            result.chop(1);
+        }
+        if (!result.isEmpty() && !result.endsWith(QLatin1Char('\n'))) {
+            result += c;
+        }
+    } else if (c.isSpace()) {
+        if (!result.isEmpty() && !result.endsWith(QLatin1Char(' ')) && !result.endsWith(QLatin1Char('\n'))) {
+            result += QLatin1Char(' ');
+        }
+    } else {
+        result += c;
+    }
+}
+
+// Decodes the entity starting at html[pos] (which is '&'); returns the
+// amount of characters consumed, or 0 if this is not a valid entity
+qsizetype decodeEntity(QStringView html, qsizetype pos, QString &result)
+{
+    const qsizetype end = html.indexOf(QLatin1Char(';'), pos + 1);
+    if (end < 0 || end - pos > 12) {
+        return 0;
+    }
+    const QStringView name = html.mid(pos + 1, end - pos - 1);
+    if (name.isEmpty()) {
+        return 0;
+    }
+
+    char32_t codePoint = 0;
+    if (name.startsWith(QLatin1Char('#'))) {
+        bool ok = false;
+        if (name.size() > 1 && (name[1] == QLatin1Char('x') || name[1] == QLatin1Char('X'))) {
+            codePoint = name.mid(2).toUInt(&ok, 16);
+        } else {
+            codePoint = name.mid(1).toUInt(&ok, 10);
+        }
+        if (!ok || codePoint == 0 || codePoint > 0x10FFFF) {
+            return 0;
+        }
+    } else {
+        const auto it = namedEntities().constFind(name.toString());
+        if (it == namedEntities().constEnd()) {
+            return 0;
+        }
+        codePoint = it.value();
+    }
+
+    const QString decoded = QString::fromUcs4(&codePoint, 1);
+    for (const QChar c : decoded) {
+        appendChar(result, c);
+    }
+    return end - pos + 1;
+}
+}
+
+QString HtmlUtils::toPlainText(const QString &html)
+{
+    // nothing to do for text that contains neither tags nor entities, which
+    // is the most common case
+    if (!html.contains(QLatin1Char('<')) && !html.contains(QLatin1Char('&'))) {
+        return html.simplified();
+    }
+
+    const QStringView view(html);
+    const qsizetype length = view.size();
+    QString result;
+    result.reserve(length);
+
+    qsizetype pos = 0;
+    bool unterminated = false; // no '>' left, so no more tags either
+    while (pos < length) {
+        const QChar c = view[pos];
+
+        if (c == QLatin1Char('&')) {
+            const qsizetype consumed = decodeEntity(view, pos, result);
+            if (consumed > 0) {
+                pos += consumed;
+                continue;
+            }
+        } else if (c == QLatin1Char('<') && pos + 1 < length) {
+            const QChar next = view[pos + 1];
+
+            // comments
+            if (view.mid(pos, 4) == QLatin1String("<!--")) {
+                const qsizetype end = view.indexOf(QLatin1String("-->"), pos + 4);
+                pos = end < 0 ? length : end + 3;
+                continue;
+            }
+
+            // anything else that looks like a tag; a '<' followed by e.g. a
+            // digit or a space is just text, and so is an unterminated tag
+            const bool tag = next.isLetter() || next == QLatin1Char('/') || next == QLatin1Char('!') || next == QLatin1Char('?');
+            const qsizetype end = (tag && !unterminated) ? view.indexOf(QLatin1Char('>'), pos + 1) : -1;
+            unterminated = unterminated || (tag && end < 0);
+            if (end >= 0) {
+                const qsizetype nameStart = (next == QLatin1Char('/')) ? pos + 2 : pos + 1;
+                qsizetype nameEnd = nameStart;
+                while (nameEnd < end && view[nameEnd].isLetterOrNumber()) {
+                    ++nameEnd;
+                }
+                const QStringView name = view.mid(nameStart, nameEnd - nameStart);
+
+                // the content of scripts and style sheets is not text
+                const bool script = next != QLatin1Char('/') && name.compare(QLatin1String("script"), Qt::CaseInsensitive) == 0;
+                const bool style = next != QLatin1Char('/') && name.compare(QLatin1String("style"), Qt::CaseInsensitive) == 0;
+                if (script || style) {
+                    const QLatin1String closeTag = script ? QLatin1String("</script") : QLatin1String("</style");
+                    const qsizetype close = view.indexOf(closeTag, end, Qt::CaseInsensitive);
+                    const qsizetype closeEnd = close < 0 ? -1 : view.indexOf(QLatin1Char('>'), close);
+                    pos = closeEnd < 0 ? length : closeEnd + 1;
+                    continue;
+                }
+
+                if (isBlockElement(name)) {
+                    appendChar(result, QLatin1Char('\n'));
+                }
+                pos = end + 1;
+                continue;
+            }
+        }
+
+        // line breaks in the source are just whitespace, like in the fast path
+        appendChar(result, c.isSpace() ? QChar(QLatin1Char(' ')) : c);
+        ++pos;
+    }
+
+    // no leading or trailing whitespace
+    return result.trimmed();
+}
@@ -0,0 +1,20 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QString>
+
+// Lightweight HTML helpers that can be used from any thread.
+namespace HtmlUtils
+{
+// Converts an HTML fragment into plain text in a single pass: tags are
+// removed, line breaks and block-level elements become newlines, character
+// entities are decoded and other whitespace is collapsed.  This is meant for
+// short fragments like episode titles; it's much cheaper than building a
+// QTextDocument, but it doesn't apply any layout.
+QString toPlainText(const QString &html);
+}
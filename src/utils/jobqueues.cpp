@@ -0,0 +1,47 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "jobqueues.h"
+#include "jobqueueslogging.h"
+
+#include <QCoreApplication>
+#include <QThread>
+
+#include <algorithm>
+
+ThreadWeaver::Queue *JobQueues::cpuQueue()
+{
+    static ThreadWeaver::Queue *queue = createQueue(std::max(QThread::idealThreadCount(), 1));
+    return queue;
+}
+
+ThreadWeaver::Queue *JobQueues::diskQueue()
+{
+    static ThreadWeaver::Queue *queue = createQueue(1);
+    return queue;
+}
+
+void JobQueues::logOccupancy(const QString &reason)
+{
+    if (!kastsJobQueues().isDebugEnabled()) {
+        return;
+    }
+
+    const ThreadWeaver::Queue *cpu = cpuQueue();
+    const ThreadWeaver::Queue *disk = diskQueue();
+    qCDebug(kastsJobQueues) << reason << "- CPU queue:" << cpu->queueLength() << "waiting," << cpu->currentNumberOfThreads() << "of"
+                            << cpu->maximumNumberOfThreads() << "threads; disk queue:" << disk->queueLength() << "waiting,"
+                            << disk->currentNumberOfThreads() << "of" << disk->maximumNumberOfThreads() << "threads";
+}
+
+ThreadWeaver::Queue *JobQueues::createQueue(const int threads)
+{
+    // the queues are deleted together with the application, which waits for
+    // running jobs to finish
+    ThreadWeaver::Queue *queue = new ThreadWeaver::Queue(QCoreApplication::instance());
+    queue->setMaximumNumberOfThreads(threads);
+    return queue;
+}
@@ -0,0 +1,32 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QString>
+
+#include <ThreadWeaver/Queue>
+
+// Dedicated ThreadWeaver queues for the different kinds of background work,
+// such that e.g. a long running storage move can't starve feed parsing.
+// Network transfers don't need a queue of their own: they are asynchronous
+// and run on the network threads of the jobs that start them.
+class JobQueues
+{
+public:
+    // CPU bound work like parsing and processing feeds; one thread per core
+    static ThreadWeaver::Queue *cpuQueue();
+
+    // file operations; a single thread, since parallel reads and writes on
+    // the same disk mostly result in seeking
+    static ThreadWeaver::Queue *diskQueue();
+
+    // writes the current occupancy of the queues to the debug log
+    static void logOccupancy(const QString &reason);
+
+private:
+    static ThreadWeaver::Queue *createQueue(const int threads);
+};
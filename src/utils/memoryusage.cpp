@@ -0,0 +1,47 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "memoryusage.h"
+
+#include <QByteArray>
+#include <QFile>
+
+namespace
+{
+qint64 readProcStatusField(const QByteArray &field)
+{
+#if defined(Q_OS_LINUX) || defined(Q_OS_ANDROID)
+    // The relevant lines look like "VmRSS:	  123456 kB"
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    const QByteArray prefix = field + ':';
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith(prefix)) {
+            const QByteArray value = line.mid(prefix.size()).trimmed();
+            bool ok = false;
+            const qint64 kiloBytes = value.left(value.indexOf(' ')).toLongLong(&ok);
+            return ok ? kiloBytes * 1024 : -1;
+        }
+    }
+#else
+    Q_UNUSED(field)
+#endif
+    return -1;
+}
+}
+
+qint64 MemoryUsage::residentSetSize()
+{
+    return readProcStatusField(QByteArrayLiteral("VmRSS"));
+}
+
+qint64 MemoryUsage::peakResidentSetSize()
+{
+    return readProcStatusField(QByteArrayLiteral("VmHWM"));
+}
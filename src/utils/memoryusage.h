@@ -0,0 +1,18 @@
+/**
+ * SPDX-FileCopyrightText: 2025 Bart De Vries <bart@mogwai.be>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+// Helpers to monitor the memory footprint of the app, e.g. while updating
+// feeds.  The values are in bytes; -1 is returned if they are not available
+// on the current platform.
+namespace MemoryUsage
+{
+qint64 residentSetSize(); // current resident set size of the process
+qint64 peakResidentSetSize(); // highest resident set size since the process started
+}
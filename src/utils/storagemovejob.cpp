@@ -12,6 +12,9 @@
 #include <QTimer>
 
 #include <KLocalizedString>
+#include <ThreadWeaver/ThreadWeaver>
+
+#include "jobqueues.h"
 
 StorageMoveJob::StorageMoveJob(const QString &from, const QString &to, QStringList &list, QObject *parent)
     : KJob(parent)
@@ -23,7 +26,14 @@ StorageMoveJob::StorageMoveJob(const QString &from, const QString &to, QStringLi
 
 void StorageMoveJob::start()
 {
-    QTimer::singleShot(0, this, &StorageMoveJob::moveFiles);
+    // copying the enclosures can take minutes; do this on the disk queue to
+    // keep the GUI responsive and to keep the CPU queue free for other work
+    QTimer::singleShot(0, this, [this]() {
+        JobQueues::diskQueue()->stream() << ThreadWeaver::make_job([this]() {
+            moveFiles();
+        });
+        JobQueues::logOccupancy(QStringLiteral("Enqueued storage move"));
+    });
 }
 
 void StorageMoveJob::moveFiles()
@@ -54,14 +64,12 @@ void StorageMoveJob::moveFiles()
     }
 
     if (!success) {
-        setError(2);
-        setErrorText(i18n("Destination path not writable"));
-        emitResult();
+        finishMove(2, i18n("Destination path not writable"));
         return;
     }
 
-    setTotalAmount(Files, fileList.size());
-    setProcessedAmount(Files, 0);
+    setTotalFiles(fileList.size());
+    setProcessedFiles(0);
 
     for (int i = 0; i < fileList.size(); i++) {
         // First check if we need to abort this job
@@ -71,9 +79,7 @@ void StorageMoveJob::moveFiles()
                 qCDebug(kastsStorageMoveJob) << "Removing file" << QDir(m_to).absoluteFilePath(fileList[j]);
                 QFile(QDir(m_to).absoluteFilePath(fileList[j])).remove();
             }
-            setError(1);
-            setErrorText(i18n("Operation aborted by user"));
-            emitResult();
+            finishMove(1, i18n("Operation aborted by user"));
             return;
         }
 
@@ -88,12 +94,11 @@ void StorageMoveJob::moveFiles()
         }
         if (!success)
             break;
-        setProcessedAmount(Files, i + 1);
+        setProcessedFiles(i + 1);
     }
 
     if (m_abort) {
-        setError(1);
-        setErrorText(i18n("Operation aborted by user"));
+        finishMove(1, i18n("Operation aborted by user"));
     } else if (success) {
         // now it's safe to delete all the files from the original location
         for (const QString &file : std::as_const(fileList)) {
@@ -107,12 +112,35 @@ void StorageMoveJob::moveFiles()
                 QDir(m_from).rmdir(item);
             }
         }
+        finishMove(0, QString());
     } else {
-        setError(2);
-        setErrorText(i18n("An error occurred while copying data"));
+        finishMove(2, i18n("An error occurred while copying data"));
     }
+}
+
+void StorageMoveJob::setTotalFiles(const qulonglong amount)
+{
+    QMetaObject::invokeMethod(this, [this, amount]() {
+        setTotalAmount(Files, amount);
+    });
+}
 
-    emitResult();
+void StorageMoveJob::setProcessedFiles(const qulonglong amount)
+{
+    QMetaObject::invokeMethod(this, [this, amount]() {
+        setProcessedAmount(Files, amount);
+    });
+}
+
+void StorageMoveJob::finishMove(const int errorCode, const QString &errorString)
+{
+    QMetaObject::invokeMethod(this, [this, errorCode, errorString]() {
+        if (errorCode != 0) {
+            setError(errorCode);
+            setErrorText(errorString);
+        }
+        emitResult();
+    });
 }
 
 bool StorageMoveJob::doKill()
@@ -8,6 +8,8 @@
 
 #include <KJob>
 
+#include <atomic>
+
 class StorageMoveJob : public KJob
 {
 public:
@@ -17,10 +19,15 @@ public:
     bool doKill() override;
 
 private:
+    // runs on the disk queue; progress and the result are passed back to the
+    // thread of the job
     void moveFiles();
+    void setTotalFiles(const qulonglong amount);
+    void setProcessedFiles(const qulonglong amount);
+    void finishMove(const int errorCode, const QString &errorString);
 
     QString m_from;
     QString m_to;
     QStringList m_list;
-    bool m_abort = false;
+    std::atomic<bool> m_abort = false;
 };
@@ -7,33 +7,36 @@
 #include "updatefeedjob.h"
 
 #include <QCryptographicHash>
-#include <QDir>
 #include <QDomElement>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QHash>
 #include <QList>
 #include <QLoggingCategory>
 #include <QMultiHash>
 #include <QMultiMap>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QNetworkRequest>
 #include <QObject>
+#include <QRandomGenerator>
 #include <QSet>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QString>
-#include <QTextDocumentFragment>
+#include <QTextStream>
 #include <QTimer>
 
 #include <KLocalizedString>
 #include <ThreadWeaver/Thread>
+#include <algorithm>
+#include <functional>
 
 #include "database.h"
 #include "datatypes.h"
 #include "enclosure.h"
 #include "error.h"
+#include "feeddatabasewriter.h"
 #include "fetcher.h"
-#include "fetchfeedsjob.h"
+#include "htmlutils.h"
+#include "memoryusage.h"
 #include "settingsmanager.h"
 #include "storagemanager.h"
 #include "updaterlogging.h"
@@ -41,49 +44,144 @@
 using namespace ThreadWeaver;
 using namespace DataTypes;
 
-UpdateFeedJob::UpdateFeedJob(const qint64 feeduid, QObject *parent)
+namespace
+{
+// Retrieves the xml element of an item as it appears in the feed; this is
+// not available for RDF (RSS 1.0) items
+class ItemElementVisitor : public Syndication::SpecificItemVisitor
+{
+public:
+    bool visitRSS2Item(Syndication::RSS2::Item *item) override
+    {
+        element = item->element();
+        return true;
+    }
+
+    bool visitAtomEntry(Syndication::Atom::Entry *entry) override
+    {
+        element = entry->element();
+        return true;
+    }
+
+    QDomElement element;
+};
+
+// assigns value to field and records in changedFields whether this is
+// actually a change
+template<typename T, typename Fields>
+void setField(T &field, const T &value, Fields &changedFields, typename Fields::enum_type flag)
+{
+    if (field != value) {
+        field = value;
+        changedFields |= flag;
+    }
+}
+}
+
+UpdateFeedJob::UpdateFeedJob(const DataTypes::FeedDownload &download, FeedDatabaseWriter *writer, DataTypes::FetchPriority priority, QObject *parent)
     : QObject(parent)
-    , m_feeduid(feeduid)
+    , m_feeduid(download.feeduid)
+    , m_download(download)
+    , m_writer(writer)
+    , m_priority(priority)
 {
     // connect to signals in Fetcher such that GUI can pick up the changes
-    connect(this, &UpdateFeedJob::feedDetailsUpdated, &Fetcher::instance(), &Fetcher::feedDetailsUpdated);
-    connect(this, &UpdateFeedJob::feedUpdated, &Fetcher::instance(), &Fetcher::feedUpdated);
-    connect(this, &UpdateFeedJob::entryAdded, &Fetcher::instance(), &Fetcher::entryAdded);
-    connect(this, &UpdateFeedJob::entryUpdated, &Fetcher::instance(), &Fetcher::entryUpdated);
     connect(this, &UpdateFeedJob::error, &Fetcher::instance(), &Fetcher::error);
 }
 
+int UpdateFeedJob::priority() const
+{
+    // ThreadWeaver executes jobs with a higher priority first
+    switch (m_priority) {
+    case DataTypes::InteractiveFetch:
+        return 2;
+    case DataTypes::NormalFetch:
+        return 1;
+    case DataTypes::BackgroundFetch:
+    default:
+        return 0;
+    }
+}
+
 void UpdateFeedJob::run(JobPointer, Thread *)
 {
     if (m_abort) {
+        removeDownloadedFile();
         Q_EMIT finished();
         return;
     }
 
     Database::openDatabase(QString::number(m_feeduid));
 
-    DataTypes::FeedDetails updatedFeed;
-    QByteArray data;
+    DataTypes::FeedWrite feedWrite;
+    feedWrite.feeduid = m_feeduid;
+    feedWrite.stats = m_download.stats;
+    feedWrite.stats.outcome = m_download.status == DataTypes::NotModified ? DataTypes::UpdateNotModified : DataTypes::UpdateFailed;
+
+    const qint64 rssBefore = MemoryUsage::residentSetSize();
+    qint64 rssPeak = rssBefore;
+
+    const bool feedLoaded = loadFeed(feedWrite.feed);
+    if (feedLoaded && m_download.status == DataTypes::Downloaded && !feedChanged(feedWrite)) {
+        feedWrite.stats.outcome = DataTypes::UpdateUnchanged;
+    } else if (feedLoaded && m_download.status == DataTypes::Downloaded) {
+        QFile feedFile(m_download.fileName);
+        if (feedFile.open(QIODevice::ReadOnly)) {
+            // Parse straight from a memory mapping of the downloaded file
+            // rather than reading it into memory first
+            const qint64 size = feedFile.size();
+            const uchar *mapped = size > 0 ? feedFile.map(0, size) : nullptr;
+            const QByteArray data = mapped ? QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), size) : feedFile.readAll();
+
+            QElapsedTimer timer;
+            timer.start();
+            Syndication::DocumentSource document(data, m_url);
+            Syndication::FeedPtr feed = Syndication::parserCollection()->parse(document, QStringLiteral("Atom"));
+            feedWrite.stats.parseTime = timer.restart();
+            rssPeak = std::max(rssPeak, MemoryUsage::residentSetSize());
+            processFeed(feed, feedWrite, m_download.hash);
+            feedWrite.stats.processTime = timer.elapsed();
+            feedWrite.stats.outcome = feed.isNull() ? DataTypes::UpdateParseFailed : DataTypes::UpdateProcessed;
+            rssPeak = std::max(rssPeak, MemoryUsage::residentSetSize());
+        } else {
+            qCDebug(kastsUpdater) << "Could not open downloaded feed" << m_download.fileName << feedFile.errorString();
+        }
+    }
 
-    if (downloadFeed(updatedFeed, data)) {
-        Syndication::DocumentSource document(data, m_url);
-        Syndication::FeedPtr feed = Syndication::parserCollection()->parse(document, QStringLiteral("Atom"));
-        processFeed(feed, updatedFeed, data);
-    } else {
-        // TODO: add some kind of error reporting
+    if (feedLoaded && !m_abort) {
+        feedWrite.nextUpdate = nextUpdateTime(feedWrite.feed);
+        updateFailureState(feedWrite);
+        if (!m_download.redirectedUrl.isEmpty() && m_download.redirectedUrl != m_url) {
+            qCDebug(kastsUpdater) << "Feed" << m_feeduid << "has moved permanently from" << m_url << "to" << m_download.redirectedUrl;
+            feedWrite.redirectedUrl = m_download.redirectedUrl;
+        }
     }
 
+    // Note that feeds are updated in parallel, so this is only indicative
+    qCDebug(kastsUpdater) << "RSS memory for feed" << m_feeduid << "before update:" << rssBefore << "peak during update:" << rssPeak
+                          << "process peak:" << MemoryUsage::peakResidentSetSize();
+
     Database::closeDatabase(QString::number(m_feeduid));
+    removeDownloadedFile();
+
+    // hand the changes over to the writer, which will commit them together
+    // with the changes of other feeds
+    if (feedLoaded && !m_abort) {
+        m_writeQueued = true;
+        QMetaObject::invokeMethod(m_writer, [writer = m_writer, feedWrite]() {
+            writer->enqueue(feedWrite);
+        });
+    }
 
     Q_EMIT finished();
 }
 
-bool UpdateFeedJob::downloadFeed(DataTypes::FeedDetails &updatedFeed, QByteArray &data)
+bool UpdateFeedJob::loadFeed(DataTypes::FeedDetails &updatedFeed)
 {
     qCDebug(kastsUpdater) << "get old feed data from DB for" << m_feeduid;
 
     // First get the current data from the DB, we'll check the lastHash to decide
-    // whether we actually have to update the feed or can simply skip it
+    // whether we actually have to process the feed or can simply skip it
     QSqlQuery query(QSqlDatabase::database(QString::number(m_feeduid)));
     query.prepare(QStringLiteral("SELECT * FROM Feeds WHERE feeduid=:feeduid;"));
     query.bindValue(QStringLiteral(":feeduid"), m_feeduid);
@@ -104,80 +202,60 @@ bool UpdateFeedJob::downloadFeed(DataTypes::FeedDetails &updatedFeed, QByteArray
         updatedFeed.isNew = query.value(QStringLiteral("new")).toBool();
         updatedFeed.dirname = query.value(QStringLiteral("dirname")).toString();
         updatedFeed.lastHash = query.value(QStringLiteral("lastHash")).toString();
+        updatedFeed.etag = query.value(QStringLiteral("etag")).toString();
+        updatedFeed.lastModified = query.value(QStringLiteral("lastModified")).toString();
+        updatedFeed.lastSize = query.value(QStringLiteral("lastSize")).toLongLong();
+        updatedFeed.failureCount = query.value(QStringLiteral("failureCount")).toInt();
+        updatedFeed.paused = query.value(QStringLiteral("paused")).toBool();
         updatedFeed.filterType = query.value(QStringLiteral("filterType")).toInt();
         updatedFeed.sortType = query.value(QStringLiteral("sortType")).toInt();
         updatedFeed.state = RecordState::Unmodified;
         m_url = updatedFeed.url;
-
-        // already set the content of all the "old" fields
-        updatedFeed.oldName = updatedFeed.name;
-        updatedFeed.oldUrl = updatedFeed.url;
-        updatedFeed.oldImage = updatedFeed.image;
-        updatedFeed.oldLink = updatedFeed.link;
-        updatedFeed.oldDescription = updatedFeed.description;
-        updatedFeed.oldLastUpdated = updatedFeed.lastUpdated;
-        updatedFeed.oldDirname = updatedFeed.dirname;
-        updatedFeed.oldLastHash = updatedFeed.lastHash;
     } else {
         return false;
     }
     query.finish(); // release lock on database
 
-    // we continue to retrieve the updated feed
-    // note that this has to be done with an eventloop to do the network
-    // request/reply in a blocking way since we're in a separate thread
-    // managed by ThreadWeaver
-    QEventLoop loop;
-    NetworkAccessManager manager;
-    bool continueProcessFeed = false;
-
-    QNetworkRequest request((QUrl(m_url)));
-    request.setTransferTimeout();
-    QNetworkReply *reply = manager.get(request);
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-
-    // HACK: if this object is parented by a FetchFeedsJob, then also connect
-    // its "aborting" signal to the qnetworkreply; it's done this way because
-    // we cannot connect signals to "this" inside a ThreadWeaver job
-    FetchFeedsJob *fetchfeedjob = qobject_cast<FetchFeedsJob *>(parent());
-    if (fetchfeedjob) {
-        connect(fetchfeedjob, &FetchFeedsJob::aborting, reply, &QNetworkReply::abort);
-    }
+    return true;
+}
 
-    qCDebug(kastsUpdater) << "Eventloop started for" << m_feeduid;
-    loop.exec();
-    qCDebug(kastsUpdater) << "Eventloop finished" << m_feeduid;
+bool UpdateFeedJob::feedChanged(DataTypes::FeedWrite &feedWrite)
+{
+    DataTypes::FeedDetails &updatedFeed = feedWrite.feed;
 
-    qCDebug(kastsUpdater) << "got networkreply for" << reply;
-    if (reply->error()) {
-        if (!m_abort) {
-            qCDebug(kastsUpdater) << "Error fetching feed" << reply->errorString();
-            Q_EMIT error(Error::Type::FeedUpdate, m_url, QString(), reply->error(), reply->errorString(), QString());
-        } else {
-            qCDebug(kastsUpdater) << "Aborted network reply to fetch feed" << m_feeduid;
-        }
-        continueProcessFeed = false;
-    } else {
-        data = reply->readAll();
+    const bool validatorsChanged =
+        (m_download.etag != updatedFeed.etag || m_download.lastModified != updatedFeed.lastModified || m_download.size != updatedFeed.lastSize);
+    updatedFeed.etag = m_download.etag;
+    updatedFeed.lastModified = m_download.lastModified;
+    updatedFeed.lastSize = m_download.size;
 
-        // check if the feed has been really been updated by checking if
-        // the hash is still the same
-        QString newHash = QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
-        qCDebug(kastsUpdater) << "RSS hashes (old and new)" << m_feeduid << updatedFeed.lastHash << newHash;
+    // check if the feed has been really been updated by checking if
+    // the hash is still the same
+    qCDebug(kastsUpdater) << "RSS hashes (old and new)" << m_feeduid << updatedFeed.lastHash << m_download.hash;
 
-        if (newHash == updatedFeed.lastHash) {
-            qCDebug(kastsUpdater) << "same RSS feed hash as last time; skipping feed update for" << m_feeduid;
-            continueProcessFeed = false;
-        } else {
-            continueProcessFeed = true;
-        }
+    if (m_download.hash != updatedFeed.lastHash) {
+        return true;
+    }
+
+    qCDebug(kastsUpdater) << "same RSS feed hash as last time; skipping feed update for" << m_feeduid;
+
+    // the feed itself is unchanged, but we still need to store the
+    // (possibly new) validators to be able to do conditional requests
+    feedWrite.validatorsChanged = validatorsChanged;
+    return false;
+}
+
+void UpdateFeedJob::removeDownloadedFile()
+{
+    if (!m_download.fileName.isEmpty()) {
+        QFile::remove(m_download.fileName);
     }
-    delete reply;
-    return continueProcessFeed;
 }
 
-void UpdateFeedJob::processFeed(const Syndication::FeedPtr feed, DataTypes::FeedDetails &updatedFeed, const QByteArray &data)
+void UpdateFeedJob::processFeed(const Syndication::FeedPtr feed, DataTypes::FeedWrite &feedWrite, const QString &newHash)
 {
+    DataTypes::FeedDetails &updatedFeed = feedWrite.feed;
+
     // Now that we now we have to update everything, we continue retrieving the
     // old data from the database
 
@@ -191,119 +269,29 @@ void UpdateFeedJob::processFeed(const Syndication::FeedPtr feed, DataTypes::Feed
         authorDetails.name = query.value(QStringLiteral("name")).toString();
         authorDetails.email = query.value(QStringLiteral("email")).toString();
         authorDetails.state = RecordState::Deleted; // will be reset to Unmodified if the author is found in the updated rss feed
-
-        // already set the content of all the "old" fields
-        authorDetails.oldEmail = authorDetails.email;
-
         updatedFeed.authors[authorDetails.name] = authorDetails;
     }
     query.finish();
 
     // Now that we have the feed details, we make vectors of the data that's
-    // already in the database relating to this feed
-    query.prepare(QStringLiteral("SELECT * FROM Entries WHERE feeduid=:feeduid;"));
+    // already in the database relating to this feed.  Only the ids and
+    // content hashes of the entries are loaded here; the full details are
+    // only retrieved for entries that have changed (see loadEntryDetails).
+    query.prepare(QStringLiteral("SELECT entryuid, id, removed, contentHash FROM Entries WHERE feeduid=:feeduid;"));
     query.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
     dbExecute(query);
     while (query.next()) {
         EntryDetails entryDetails;
         entryDetails.entryuid = query.value(QStringLiteral("entryuid")).toLongLong();
-        entryDetails.feeduid = query.value(QStringLiteral("feeduid")).toLongLong();
+        entryDetails.feeduid = updatedFeed.feeduid;
         entryDetails.id = query.value(QStringLiteral("id")).toString();
-        entryDetails.title = query.value(QStringLiteral("title")).toString();
-        entryDetails.content = query.value(QStringLiteral("content")).toString();
-        entryDetails.created = query.value(QStringLiteral("created")).toInt();
-        entryDetails.updated = query.value(QStringLiteral("updated")).toInt();
-        entryDetails.read = query.value(QStringLiteral("read")).toBool();
-        entryDetails.isNew = query.value(QStringLiteral("new")).toBool();
-        entryDetails.link = query.value(QStringLiteral("link")).toString();
         entryDetails.removed = query.value(QStringLiteral("removed")).toBool();
-        entryDetails.hasEnclosure = query.value(QStringLiteral("hasEnclosure")).toBool();
-        entryDetails.image = query.value(QStringLiteral("image")).toString();
+        entryDetails.contentHash = query.value(QStringLiteral("contentHash")).toString();
         entryDetails.state = RecordState::Deleted; // will be set to appropriate value if the entry is found in the updated rss feed
-
-        // already set the content of all the "old" fields
-        entryDetails.oldTitle = entryDetails.title;
-        entryDetails.oldContent = entryDetails.content;
-        entryDetails.oldCreated = entryDetails.created;
-        entryDetails.oldUpdated = entryDetails.updated;
-        entryDetails.oldLink = entryDetails.link;
-        entryDetails.oldRemoved = entryDetails.removed;
-        entryDetails.oldHasEnclosure = entryDetails.hasEnclosure;
-        entryDetails.oldImage = entryDetails.image;
-
         updatedFeed.entries[entryDetails.id] = entryDetails;
     }
     query.finish();
 
-    query.prepare(QStringLiteral("SELECT * FROM Enclosures JOIN Entries ON Entries.entryuid = Enclosures.entryuid WHERE Enclosures.feeduid=:feeduid;"));
-    query.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
-    dbExecute(query);
-    while (query.next()) {
-        EnclosureDetails enclosureDetails;
-        enclosureDetails.enclosureuid = query.value(QStringLiteral("enclosureuid")).toLongLong();
-        QString id = query.value(QStringLiteral("id")).toString();
-        enclosureDetails.duration = query.value(QStringLiteral("duration")).toInt();
-        enclosureDetails.size = query.value(QStringLiteral("size")).toInt();
-        enclosureDetails.type = query.value(QStringLiteral("type")).toString();
-        enclosureDetails.url = query.value(QStringLiteral("url")).toString();
-        enclosureDetails.playPosition = query.value(QStringLiteral("playposition")).toInt();
-        enclosureDetails.downloaded = Enclosure::dbToStatus(query.value(QStringLiteral("downloaded")).toInt());
-        enclosureDetails.state = RecordState::Deleted; // will be set to appropriate value if the enclosure is found in the updated rss feed
-
-        // already set the content of all the "old" fields
-        enclosureDetails.oldDuration = enclosureDetails.duration;
-        enclosureDetails.oldSize = enclosureDetails.size;
-        enclosureDetails.oldType = enclosureDetails.type;
-        enclosureDetails.oldUrl = enclosureDetails.url;
-
-        if (updatedFeed.entries.contains(id)) {
-            updatedFeed.entries[id].enclosures[enclosureDetails.url] = enclosureDetails;
-        }
-    }
-    query.finish();
-
-    query.prepare(QStringLiteral("SELECT id, name, email FROM EntryAuthors JOIN Entries ON Entries.entryuid = EntryAuthors.entryuid WHERE feeduid=:feeduid;"));
-    query.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
-    dbExecute(query);
-    while (query.next()) {
-        AuthorDetails authorDetails;
-        QString id = query.value(QStringLiteral("id")).toString();
-        authorDetails.name = query.value(QStringLiteral("name")).toString();
-        authorDetails.email = query.value(QStringLiteral("email")).toString();
-        authorDetails.state = RecordState::Deleted; // will be set to appropriate value if the author is found in the updated rss feed
-
-        // already set the content of all the "old" fields
-        authorDetails.oldEmail = authorDetails.email;
-
-        if (updatedFeed.entries.contains(id)) {
-            updatedFeed.entries[id].authors[authorDetails.name] = authorDetails;
-        }
-    }
-    query.finish();
-
-    query.prepare(QStringLiteral("SELECT * FROM Chapters JOIN Entries ON Entries.entryuid = Chapters.entryuid WHERE feeduid=:feeduid;"));
-    query.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
-    dbExecute(query);
-    while (query.next()) {
-        ChapterDetails chapterDetails;
-        QString id = query.value(QStringLiteral("id")).toString();
-        chapterDetails.start = query.value(QStringLiteral("start")).toInt();
-        chapterDetails.title = query.value(QStringLiteral("title")).toString();
-        chapterDetails.link = query.value(QStringLiteral("link")).toString();
-        chapterDetails.image = query.value(QStringLiteral("image")).toString();
-        chapterDetails.state = RecordState::Deleted; // will be set to appropriate value if the chapter is found in the updated rss feed
-
-        // already set the content of all the "old" fields
-        chapterDetails.oldTitle = chapterDetails.title;
-        chapterDetails.oldLink = chapterDetails.link;
-        chapterDetails.oldImage = chapterDetails.image;
-
-        if (updatedFeed.entries.contains(id)) {
-            updatedFeed.entries[id].chapters[chapterDetails.start] = chapterDetails;
-        }
-    }
-    query.finish();
-
     qCDebug(kastsUpdater) << "start process feed" << feed;
 
     if (feed.isNull())
@@ -316,36 +304,39 @@ void UpdateFeedJob::processFeed(const Syndication::FeedPtr feed, DataTypes::Feed
 
     QDateTime current = QDateTime::currentDateTime();
 
-    updatedFeed.name = feed->title();
-    updatedFeed.link = feed->link();
-    updatedFeed.description = feed->description();
-    updatedFeed.lastUpdated = current.toSecsSinceEpoch();
-    updatedFeed.lastHash = QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+    setField(updatedFeed.name, feed->title(), updatedFeed.changedFields, FeedDetails::Name);
+    setField(updatedFeed.link, feed->link(), updatedFeed.changedFields, FeedDetails::Link);
+    setField(updatedFeed.description, feed->description(), updatedFeed.changedFields, FeedDetails::Description);
+    setField(updatedFeed.lastUpdated, static_cast<int>(current.toSecsSinceEpoch()), updatedFeed.changedFields, FeedDetails::LastUpdated);
+    setField(updatedFeed.lastHash, newHash, updatedFeed.changedFields, FeedDetails::LastHash);
 
     // Retrieve "other" fields; this will include the "itunes" tags
     QMultiMap<QString, QDomElement> otherItems = feed->additionalProperties();
 
     // First try the itunes tags, if not, fall back to regular image tag
+    QString image;
     if (otherItems.value(QStringLiteral("http://www.itunes.com/dtds/podcast-1.0.dtdimage")).hasAttribute(QStringLiteral("href"))) {
-        updatedFeed.image = otherItems.value(QStringLiteral("http://www.itunes.com/dtds/podcast-1.0.dtdimage")).attribute(QStringLiteral("href"));
+        image = otherItems.value(QStringLiteral("http://www.itunes.com/dtds/podcast-1.0.dtdimage")).attribute(QStringLiteral("href"));
     } else {
-        updatedFeed.image = feed->image()->url();
+        image = feed->image()->url();
     }
 
-    if (updatedFeed.image.startsWith(QStringLiteral("/"))) {
-        updatedFeed.image = QUrl(m_url).adjusted(QUrl::RemovePath).toString() + updatedFeed.image;
+    if (image.startsWith(QStringLiteral("/"))) {
+        image = QUrl(m_url).adjusted(QUrl::RemovePath).toString() + image;
     }
+    setField(updatedFeed.image, image, updatedFeed.changedFields, FeedDetails::Image);
 
     // if the title has changed, we need to rename the corresponding enclosure
     // download directory name and move the files
     // TODO: The rename should happen simultaneously with the write to the database rather than here
-    if (updatedFeed.oldName != updatedFeed.name || updatedFeed.oldDirname.isEmpty() || updatedFeed.isNew) {
+    if ((updatedFeed.changedFields & FeedDetails::Name) || updatedFeed.dirname.isEmpty() || updatedFeed.isNew) {
         QString generatedDirname = generateFeedDirname(updatedFeed.name);
         if (generatedDirname != updatedFeed.dirname) {
-            updatedFeed.dirname = generatedDirname;
+            const QString oldDirname = updatedFeed.dirname;
+            setField(updatedFeed.dirname, generatedDirname, updatedFeed.changedFields, FeedDetails::Dirname);
             QString enclosurePath = StorageManager::instance().enclosureDirPath();
-            if (QDir(enclosurePath + updatedFeed.oldDirname).exists()) {
-                QDir().rename(enclosurePath + updatedFeed.oldDirname, enclosurePath + updatedFeed.dirname);
+            if (QDir(enclosurePath + oldDirname).exists()) {
+                QDir().rename(enclosurePath + oldDirname, enclosurePath + updatedFeed.dirname);
             } else {
                 QDir().mkpath(enclosurePath + updatedFeed.dirname);
             }
@@ -360,8 +351,7 @@ void UpdateFeedJob::processFeed(const Syndication::FeedPtr feed, DataTypes::Feed
 
     // check if any field has changed and only emit signal if there are changes
     bool hasFeedBeenUpdated = false;
-    if (updatedFeed.name != updatedFeed.name || updatedFeed.link != updatedFeed.link || updatedFeed.image != updatedFeed.image
-        || updatedFeed.description != updatedFeed.description || authorsChanged) {
+    if ((updatedFeed.changedFields & (FeedDetails::Name | FeedDetails::Link | FeedDetails::Image | FeedDetails::Description)) || authorsChanged) {
         hasFeedBeenUpdated = true;
     } else {
         hasFeedBeenUpdated = false;
@@ -372,34 +362,207 @@ void UpdateFeedJob::processFeed(const Syndication::FeedPtr feed, DataTypes::Feed
 
     // Now deal with the entries, enclosures, entry authors and chapter marks
     bool markUnreadOnNewFeed = !(SettingsManager::self()->markUnreadOnNewFeed() == 2); // retrieve this settings values once; will be reused in loop
+    bool doFullUpdate = SettingsManager::self()->doFullUpdate();
     bool updatedEntries = false;
     const auto items = feed->items();
+
+    // Compare the content hashes to find out which existing entries have
+    // changed and load the full details for those entries only
+    QList<QString> entryHashes;
+    QStringList changedEntryuids;
     for (const auto &entry : items) {
+        const bool existingEntry = updatedFeed.entries.contains(entry->id());
+        // existing entries are left alone if doFullUpdate is set to false,
+        // so there is no need to calculate their hash
+        entryHashes += (!existingEntry || doFullUpdate) ? entryHash(entry) : QString();
+        if (existingEntry && doFullUpdate) {
+            const EntryDetails &entryDetails = updatedFeed.entries[entry->id()];
+            if (entryDetails.state == RecordState::Deleted && entryDetails.contentHash != entryHashes.last()) {
+                changedEntryuids += QString::number(entryDetails.entryuid);
+            }
+        }
+    }
+    loadEntryDetails(changedEntryuids, updatedFeed);
+
+    int skippedEntries = 0;
+    int processedEntries = 0;
+    for (qsizetype i = 0; i < items.count(); ++i) {
         if (m_abort)
             return;
 
+        const auto &entry = items[i];
+        const QString id = entry->id();
+
+        // unchanged entries don't need any further processing
+        if (updatedFeed.entries.contains(id) && (!doFullUpdate || updatedFeed.entries[id].contentHash == entryHashes[i])) {
+            updatedFeed.entries[id].state = RecordState::Unmodified;
+            ++skippedEntries;
+            continue;
+        }
+
         bool isNewEntry = processEntry(entry, updatedFeed, markUnreadOnNewFeed);
+        EntryDetails &entryDetails = updatedFeed.entries[id];
+        setField(entryDetails.contentHash, entryHashes[i], entryDetails.changedFields, EntryDetails::ContentHash);
         updatedEntries = updatedEntries || isNewEntry;
+        ++processedEntries;
     }
+    qCDebug(kastsUpdater) << "feed" << m_feeduid << "has" << items.count() << "items:" << processedEntries << "processed," << skippedEntries
+                          << "skipped because they are unchanged";
+    feedWrite.stats.items = items.count();
+    feedWrite.stats.processedItems = processedEntries;
+    feedWrite.stats.skippedItems = skippedEntries;
+
+    // the actual writing to the database is done by the FeedDatabaseWriter
+    feedWrite.processed = true;
+    feedWrite.feedDetailsChanged = hasFeedBeenUpdated;
+    feedWrite.entriesChanged = updatedEntries;
+    feedWrite.lastUpdated = current;
 
-    writeToDatabase(updatedFeed);
-
-    if (hasFeedBeenUpdated) {
-        Q_EMIT feedDetailsUpdated(updatedFeed.feeduid,
-                                  m_url,
-                                  updatedFeed.name,
-                                  updatedFeed.image,
-                                  updatedFeed.link,
-                                  updatedFeed.description,
-                                  current,
-                                  updatedFeed.dirname);
+    qCDebug(kastsUpdater) << "done processing feed" << feed;
+}
+
+void UpdateFeedJob::loadEntryDetails(const QStringList &entryuids, DataTypes::FeedDetails &updatedFeed)
+{
+    if (entryuids.isEmpty()) {
+        return;
     }
 
-    if (updatedEntries || updatedFeed.isNew) {
-        Q_EMIT feedUpdated(updatedFeed.feeduid);
+    qCDebug(kastsUpdater) << "loading details of" << entryuids.count() << "changed entries for feed" << m_feeduid;
+
+    // The entryuids are integers, so they can safely be put directly into
+    // the query string instead of binding them one by one
+    const QString uidList = entryuids.join(QLatin1Char(','));
+    QSqlQuery query(QSqlDatabase::database(QString::number(m_feeduid)));
+
+    query.prepare(QStringLiteral("SELECT * FROM Entries WHERE entryuid IN (%1);").arg(uidList));
+    dbExecute(query);
+    while (query.next()) {
+        const QString id = query.value(QStringLiteral("id")).toString();
+        if (!updatedFeed.entries.contains(id)) {
+            continue;
+        }
+        EntryDetails &entryDetails = updatedFeed.entries[id];
+        entryDetails.title = query.value(QStringLiteral("title")).toString();
+        entryDetails.content = query.value(QStringLiteral("content")).toString();
+        entryDetails.created = query.value(QStringLiteral("created")).toInt();
+        entryDetails.updated = query.value(QStringLiteral("updated")).toInt();
+        entryDetails.read = query.value(QStringLiteral("read")).toBool();
+        entryDetails.isNew = query.value(QStringLiteral("new")).toBool();
+        entryDetails.link = query.value(QStringLiteral("link")).toString();
+        entryDetails.removed = query.value(QStringLiteral("removed")).toBool();
+        entryDetails.hasEnclosure = query.value(QStringLiteral("hasEnclosure")).toBool();
+        entryDetails.image = query.value(QStringLiteral("image")).toString();
     }
+    query.finish();
 
-    qCDebug(kastsUpdater) << "done processing feed" << feed;
+    query.prepare(
+        QStringLiteral("SELECT * FROM Enclosures JOIN Entries ON Entries.entryuid = Enclosures.entryuid WHERE Enclosures.entryuid IN (%1);").arg(uidList));
+    dbExecute(query);
+    while (query.next()) {
+        EnclosureDetails enclosureDetails;
+        enclosureDetails.enclosureuid = query.value(QStringLiteral("enclosureuid")).toLongLong();
+        QString id = query.value(QStringLiteral("id")).toString();
+        enclosureDetails.duration = query.value(QStringLiteral("duration")).toInt();
+        enclosureDetails.size = query.value(QStringLiteral("size")).toInt();
+        enclosureDetails.type = query.value(QStringLiteral("type")).toString();
+        enclosureDetails.url = query.value(QStringLiteral("url")).toString();
+        enclosureDetails.playPosition = query.value(QStringLiteral("playposition")).toInt();
+        enclosureDetails.downloaded = Enclosure::dbToStatus(query.value(QStringLiteral("downloaded")).toInt());
+        enclosureDetails.state = RecordState::Deleted; // will be set to appropriate value if the enclosure is found in the updated rss feed
+
+        if (updatedFeed.entries.contains(id)) {
+            updatedFeed.entries[id].enclosures[enclosureDetails.url] = enclosureDetails;
+        }
+    }
+    query.finish();
+
+    query.prepare(
+        QStringLiteral("SELECT id, name, email FROM EntryAuthors JOIN Entries ON Entries.entryuid = EntryAuthors.entryuid WHERE EntryAuthors.entryuid IN (%1);")
+            .arg(uidList));
+    dbExecute(query);
+    while (query.next()) {
+        AuthorDetails authorDetails;
+        QString id = query.value(QStringLiteral("id")).toString();
+        authorDetails.name = query.value(QStringLiteral("name")).toString();
+        authorDetails.email = query.value(QStringLiteral("email")).toString();
+        authorDetails.state = RecordState::Deleted; // will be set to appropriate value if the author is found in the updated rss feed
+
+        if (updatedFeed.entries.contains(id)) {
+            updatedFeed.entries[id].authors[authorDetails.name] = authorDetails;
+        }
+    }
+    query.finish();
+
+    query.prepare(QStringLiteral("SELECT * FROM Chapters JOIN Entries ON Entries.entryuid = Chapters.entryuid WHERE Chapters.entryuid IN (%1);").arg(uidList));
+    dbExecute(query);
+    while (query.next()) {
+        ChapterDetails chapterDetails;
+        QString id = query.value(QStringLiteral("id")).toString();
+        chapterDetails.start = query.value(QStringLiteral("start")).toInt();
+        chapterDetails.title = query.value(QStringLiteral("title")).toString();
+        chapterDetails.link = query.value(QStringLiteral("link")).toString();
+        chapterDetails.image = query.value(QStringLiteral("image")).toString();
+        chapterDetails.state = RecordState::Deleted; // will be set to appropriate value if the chapter is found in the updated rss feed
+
+        if (updatedFeed.entries.contains(id)) {
+            updatedFeed.entries[id].chapters[chapterDetails.start] = chapterDetails;
+        }
+    }
+    query.finish();
+}
+
+QString UpdateFeedJob::entryHash(const Syndication::ItemPtr &entry) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    // For RSS 2.0 and Atom feeds, simply hash the raw xml of the item; this
+    // avoids the relatively expensive parsing of the individual fields
+    ItemElementVisitor visitor;
+    const Syndication::SpecificItemPtr specificItem = entry->specificItem();
+    if (specificItem && visitor.visit(specificItem.data()) && !visitor.element.isNull()) {
+        QByteArray rawItem;
+        QTextStream stream(&rawItem);
+        visitor.element.save(stream, -1);
+        stream.flush();
+        hash.addData(rawItem);
+        return QString::fromLatin1(hash.result().toHex());
+    }
+
+    // Otherwise, hash everything that processEntry and its helpers look at;
+    // the hash only needs to change if any of that information changes
+    auto addField = [&hash](const QString &field) {
+        hash.addData(field.toUtf8());
+        hash.addData(QByteArrayView("\x1f"));
+    };
+
+    addField(entry->title());
+    addField(entry->link());
+    addField(entry->description());
+    addField(entry->content());
+    addField(QString::number(entry->datePublished()));
+    addField(QString::number(entry->dateUpdated()));
+    const auto authors = entry->authors();
+    for (const auto &author : authors) {
+        addField(author->name());
+        addField(author->email());
+    }
+    const auto enclosures = entry->enclosures();
+    for (const auto &enclosure : enclosures) {
+        addField(enclosure->url());
+        addField(enclosure->type());
+        addField(QString::number(enclosure->length()));
+        addField(QString::number(enclosure->duration()));
+    }
+    const QMultiMap<QString, QDomElement> otherItems = entry->additionalProperties();
+    for (auto it = otherItems.cbegin(); it != otherItems.cend(); ++it) {
+        QString element;
+        QTextStream stream(&element);
+        it.value().save(stream, 0);
+        addField(it.key());
+        addField(element);
+    }
+
+    return QString::fromLatin1(hash.result().toHex());
 }
 
 bool UpdateFeedJob::processFeedAuthors(const QList<Syndication::PersonPtr> &authors,
@@ -444,7 +607,7 @@ bool UpdateFeedJob::processFeedAuthor(const QString &name, const QString &email,
     if (updatedFeed.authors.contains(name)) {
         if (updatedFeed.authors[name].email != email) {
             isNewOrModified = true;
-            updatedFeed.authors[name].email = email;
+            setField(updatedFeed.authors[name].email, email, updatedFeed.authors[name].changedFields, AuthorDetails::Email);
             updatedFeed.authors[name].state = RecordState::Modified;
             qCDebug(kastsUpdater) << "author details have been updated for feed:" << m_url << name;
         } else {
@@ -474,11 +637,6 @@ bool UpdateFeedJob::processEntry(const Syndication::ItemPtr &entry, DataTypes::F
     if (updatedFeed.entries.contains(id)) {
         isNewOrModified = false;
         updatedFeed.entries[id].state = RecordState::Unmodified;
-
-        // stop here if doFullUpdate is set to false and this is an existing entry
-        if (!SettingsManager::self()->doFullUpdate()) {
-            return false;
-        }
     } else {
         isNewOrModified = true;
     }
@@ -492,7 +650,8 @@ bool UpdateFeedJob::processEntry(const Syndication::ItemPtr &entry, DataTypes::F
     //     qCDebug(kastsUpdater) << key << otherItems.value(key).tagName();
     // }
 
-    QString title = QTextDocumentFragment::fromHtml(entry->title()).toPlainText();
+    // much cheaper than QTextDocumentFragment, which builds a full document
+    QString title = HtmlUtils::toPlainText(entry->title());
     int created = static_cast<int>(entry->datePublished());
     int updated = static_cast<int>(entry->dateUpdated());
     QString link = entry->link();
@@ -520,21 +679,24 @@ bool UpdateFeedJob::processEntry(const Syndication::ItemPtr &entry, DataTypes::F
     }
     // qCDebug(kastsUpdater) << "Entry image found" << image;
 
+    // the previous title is needed to rename downloaded enclosures
+    QString previousTitle;
+
     // now we start updating the datastructure
     if (!isNewOrModified) {
-        if ((title != updatedFeed.entries[id].title) || (content != updatedFeed.entries[id].content) || (created != updatedFeed.entries[id].created)
-            || (updated != updatedFeed.entries[id].updated) || (link != updatedFeed.entries[id].link) || (hasEnclosure != updatedFeed.entries[id].hasEnclosure)
-            || (image != updatedFeed.entries[id].image)) {
+        EntryDetails &entryDetails = updatedFeed.entries[id];
+        previousTitle = entryDetails.title;
+        setField(entryDetails.title, title, entryDetails.changedFields, EntryDetails::Title);
+        setField(entryDetails.content, content, entryDetails.changedFields, EntryDetails::Content);
+        setField(entryDetails.created, created, entryDetails.changedFields, EntryDetails::Created);
+        setField(entryDetails.updated, updated, entryDetails.changedFields, EntryDetails::Updated);
+        setField(entryDetails.link, link, entryDetails.changedFields, EntryDetails::Link);
+        setField(entryDetails.hasEnclosure, hasEnclosure, entryDetails.changedFields, EntryDetails::HasEnclosure);
+        setField(entryDetails.image, image, entryDetails.changedFields, EntryDetails::Image);
+        if (entryDetails.changedFields) {
             isNewOrModified = true;
-            updatedFeed.entries[id].title = title;
-            updatedFeed.entries[id].content = content;
-            updatedFeed.entries[id].created = created;
-            updatedFeed.entries[id].updated = updated;
-            updatedFeed.entries[id].link = link;
-            updatedFeed.entries[id].removed = false;
-            updatedFeed.entries[id].hasEnclosure = hasEnclosure;
-            updatedFeed.entries[id].image = image;
-            updatedFeed.entries[id].state = RecordState::Modified;
+            setField(entryDetails.removed, false, entryDetails.changedFields, EntryDetails::Removed);
+            entryDetails.state = RecordState::Modified;
             qCDebug(kastsUpdater) << "episode details have been updated:" << id;
         } else {
             updatedFeed.entries[id].state = RecordState::Unmodified;
@@ -567,7 +729,7 @@ bool UpdateFeedJob::processEntry(const Syndication::ItemPtr &entry, DataTypes::F
     isUpdateDependencies = isUpdateDependencies | processChapters(id, otherItems, entry->link(), updatedFeed);
 
     // Process enclosures
-    isUpdateDependencies = isUpdateDependencies | processEnclosures(id, entry->enclosures(), updatedFeed);
+    isUpdateDependencies = isUpdateDependencies | processEnclosures(id, entry->enclosures(), previousTitle, updatedFeed);
 
     return isNewOrModified | isUpdateDependencies; // this is a new or updated entry, or an enclosure, chapter or author has been changed/added
 }
@@ -602,7 +764,8 @@ bool UpdateFeedJob::processEntryAuthor(const QString &id, const QString &name, c
     if (updatedFeed.entries[id].authors.contains(name)) {
         if (updatedFeed.entries[id].authors[name].email != email) {
             isNewOrModified = true;
-            updatedFeed.entries[id].authors[name].email = email;
+            AuthorDetails &authorDetails = updatedFeed.entries[id].authors[name];
+            setField(authorDetails.email, email, authorDetails.changedFields, AuthorDetails::Email);
             updatedFeed.entries[id].authors[name].state = RecordState::Modified;
             qCDebug(kastsUpdater) << "author details have been updated for:" << id << name;
         } else {
@@ -622,7 +785,10 @@ bool UpdateFeedJob::processEntryAuthor(const QString &id, const QString &name, c
     return isNewOrModified;
 }
 
-bool UpdateFeedJob::processEnclosures(const QString &id, const QList<Syndication::EnclosurePtr> &enclosures, DataTypes::FeedDetails &updatedFeed)
+bool UpdateFeedJob::processEnclosures(const QString &id,
+                                      const QList<Syndication::EnclosurePtr> &enclosures,
+                                      const QString &previousTitle,
+                                      DataTypes::FeedDetails &updatedFeed)
 {
     bool anyEnclosureUpdated = false;
 
@@ -639,7 +805,8 @@ bool UpdateFeedJob::processEnclosures(const QString &id, const QList<Syndication
             isNewEnclosure = false;
             if ((updatedFeed.entries[id].enclosures[url].type != type)) {
                 isUpdateEnclosure = true;
-                updatedFeed.entries[id].enclosures[url].type = type;
+                EnclosureDetails &enclosureDetails = updatedFeed.entries[id].enclosures[url];
+                setField(enclosureDetails.type, type, enclosureDetails.changedFields, EnclosureDetails::Type);
                 updatedFeed.entries[id].enclosures[url].state = RecordState::Modified;
                 qCDebug(kastsUpdater) << "enclosure details have been updated for:" << id << url;
             } else {
@@ -648,8 +815,8 @@ bool UpdateFeedJob::processEnclosures(const QString &id, const QList<Syndication
             }
 
             // Check if entry title or enclosure URL has changed
-            if (updatedFeed.entries[id].title != updatedFeed.entries[id].oldTitle) {
-                QString oldFilename = StorageManager::instance().enclosurePath(updatedFeed.entries[id].oldTitle, url, updatedFeed.dirname);
+            if (updatedFeed.entries[id].changedFields & EntryDetails::Title) {
+                QString oldFilename = StorageManager::instance().enclosurePath(previousTitle, url, updatedFeed.dirname);
                 QString newFilename = StorageManager::instance().enclosurePath(updatedFeed.entries[id].title, url, updatedFeed.dirname);
                 QFile::rename(oldFilename, newFilename);
             }
@@ -706,9 +873,10 @@ bool UpdateFeedJob::processChapters(const QString &id,
                     if ((updatedFeed.entries[id].chapters[startInt].title != title) || (updatedFeed.entries[id].chapters[startInt].link != link)
                         || (updatedFeed.entries[id].chapters[startInt].image != image)) {
                         isNewOrModified = true;
-                        updatedFeed.entries[id].chapters[startInt].title = title;
-                        updatedFeed.entries[id].chapters[startInt].link = link;
-                        updatedFeed.entries[id].chapters[startInt].image = image;
+                        ChapterDetails &chapterDetails = updatedFeed.entries[id].chapters[startInt];
+                        setField(chapterDetails.title, title, chapterDetails.changedFields, ChapterDetails::Title);
+                        setField(chapterDetails.link, link, chapterDetails.changedFields, ChapterDetails::Link);
+                        setField(chapterDetails.image, image, chapterDetails.changedFields, ChapterDetails::Image);
                         updatedFeed.entries[id].chapters[startInt].state = RecordState::Modified;
                         qCDebug(kastsUpdater) << "chapter details have been updated for:" << id << start;
                     } else {
@@ -734,341 +902,6 @@ bool UpdateFeedJob::processChapters(const QString &id,
     return newOrModifiedChapters;
 }
 
-void UpdateFeedJob::writeToDatabase(DataTypes::FeedDetails &updatedFeed)
-{
-    QSet<qint64> newEntryuids, updatedEntryuids;
-
-    QSqlQuery writeQuery(QSqlDatabase::database(QString::number(m_feeduid)));
-
-    dbTransaction();
-
-    // update feed details
-    writeQuery.prepare(
-        QStringLiteral("UPDATE Feeds SET url=:url, name=:name, image=:image, link=:link, description=:description, lastUpdated=:lastUpdated, dirname=:dirname "
-                       "WHERE feeduid=:feeduid;"));
-    writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
-    writeQuery.bindValue(QStringLiteral(":url"), updatedFeed.url);
-    writeQuery.bindValue(QStringLiteral(":name"), updatedFeed.name);
-    writeQuery.bindValue(QStringLiteral(":link"), updatedFeed.link);
-    writeQuery.bindValue(QStringLiteral(":description"), updatedFeed.description);
-    writeQuery.bindValue(QStringLiteral(":lastUpdated"), updatedFeed.lastUpdated);
-    writeQuery.bindValue(QStringLiteral(":image"), updatedFeed.image);
-    writeQuery.bindValue(QStringLiteral(":dirname"), updatedFeed.dirname);
-    // we only write the new lastHash to the database after entries etc. have
-    // all been updated!
-    dbExecute(writeQuery);
-    writeQuery.clear(); // make sure this writeQuery is not blocking anything anymore
-
-    // new feed authors
-    writeQuery.prepare(QStringLiteral("INSERT INTO FeedAuthors (feeduid, name, email) VALUES (:feeduid, :name, :email);"));
-    for (const AuthorDetails &authorDetails : std::as_const(updatedFeed.authors)) {
-        if (authorDetails.state == RecordState::New) {
-            writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
-            writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
-            writeQuery.bindValue(QStringLiteral(":email"), authorDetails.email);
-            dbExecute(writeQuery);
-        }
-    }
-    writeQuery.clear();
-
-    // update feed authors
-    writeQuery.prepare(QStringLiteral("UPDATE FeedAuthors SET email=:email WHERE feeduid=:feeduid AND name=:name;"));
-    for (const AuthorDetails &authorDetails : std::as_const(updatedFeed.authors)) {
-        if (authorDetails.state == RecordState::Modified) {
-            writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
-            writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
-            writeQuery.bindValue(QStringLiteral(":email"), authorDetails.email);
-            dbExecute(writeQuery);
-        }
-    }
-    writeQuery.clear();
-
-    // deleted removed feed authors
-    writeQuery.prepare(QStringLiteral("DELETE FROM FeedAuthors WHERE feeduid=:feeduid and name=:name;"));
-    for (const AuthorDetails &authorDetails : std::as_const(updatedFeed.authors)) {
-        if (authorDetails.state == RecordState::Deleted) {
-            writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
-            writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
-            dbExecute(writeQuery);
-            qCDebug(kastsUpdater) << "deleted old feed author:" << updatedFeed.feeduid << authorDetails.name;
-        }
-    }
-    writeQuery.clear();
-
-    // new entries
-    writeQuery.prepare(
-        QStringLiteral("INSERT INTO Entries (feeduid, id, title, content, created, updated, link, read, new, hasEnclosure, image, favorite, removed) VALUES "
-                       "(:feeduid, :id, :title, :content, :created, :updated, :link, :read, :new, :hasEnclosure, :image, :favorite, :removed);"));
-    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-        if (entryDetails.state == RecordState::New) {
-            writeQuery.bindValue(QStringLiteral(":feeduid"), entryDetails.feeduid);
-            writeQuery.bindValue(QStringLiteral(":id"), entryDetails.id);
-            writeQuery.bindValue(QStringLiteral(":title"), entryDetails.title);
-            writeQuery.bindValue(QStringLiteral(":content"), entryDetails.content);
-            writeQuery.bindValue(QStringLiteral(":created"), entryDetails.created);
-            writeQuery.bindValue(QStringLiteral(":updated"), entryDetails.updated);
-            writeQuery.bindValue(QStringLiteral(":link"), entryDetails.link);
-            writeQuery.bindValue(QStringLiteral(":hasEnclosure"), entryDetails.hasEnclosure);
-            writeQuery.bindValue(QStringLiteral(":read"), entryDetails.read);
-            writeQuery.bindValue(QStringLiteral(":new"), entryDetails.isNew);
-            writeQuery.bindValue(QStringLiteral(":image"), entryDetails.image);
-            writeQuery.bindValue(QStringLiteral(":favorite"), false);
-            writeQuery.bindValue(QStringLiteral(":removed"), false);
-            if (dbExecute(writeQuery)) {
-                QVariant lastId = writeQuery.lastInsertId();
-                if (lastId.isValid()) {
-                    updatedFeed.entries[entryDetails.id].entryuid = lastId.toLongLong();
-                    newEntryuids.insert(lastId.toLongLong());
-                } else {
-                    qCDebug(kastsUpdater) << "new episode did not get a valid entryuid" << entryDetails.id;
-                }
-            }
-        }
-    }
-    writeQuery.clear();
-
-    // update entries
-    writeQuery.prepare(
-        QStringLiteral("UPDATE Entries SET id=:id, title=:title, content=:content, created=:created, updated=:updated, link=:link, hasEnclosure=:hasEnclosure, "
-                       "image=:image WHERE entryuid=:entryuid;"));
-    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-        if (entryDetails.state == RecordState::Modified) {
-            updatedEntryuids.insert(entryDetails.entryuid);
-            writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
-            writeQuery.bindValue(QStringLiteral(":id"), entryDetails.id);
-            writeQuery.bindValue(QStringLiteral(":title"), entryDetails.title);
-            writeQuery.bindValue(QStringLiteral(":content"), entryDetails.content);
-            writeQuery.bindValue(QStringLiteral(":created"), entryDetails.created);
-            writeQuery.bindValue(QStringLiteral(":updated"), entryDetails.updated);
-            writeQuery.bindValue(QStringLiteral(":link"), entryDetails.link);
-            writeQuery.bindValue(QStringLiteral(":hasEnclosure"), entryDetails.hasEnclosure);
-            writeQuery.bindValue(QStringLiteral(":image"), entryDetails.image);
-            dbExecute(writeQuery);
-        }
-    }
-    writeQuery.clear();
-
-    // removed entries
-    // rather than actually remove the episodes, we mark them as such through
-    // the column "removed"
-    writeQuery.prepare(QStringLiteral("UPDATE Entries SET removed=:removed WHERE entryuid=:entryuid;"));
-    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-        if (entryDetails.state == RecordState::Deleted && !entryDetails.removed) {
-            updatedEntryuids.insert(entryDetails.entryuid);
-            writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
-            writeQuery.bindValue(QStringLiteral(":removed"), true);
-            dbExecute(writeQuery);
-        }
-    }
-    writeQuery.clear();
-
-    // new authors
-    writeQuery.prepare(QStringLiteral("INSERT INTO EntryAuthors (entryuid, name, email) VALUES (:entryuid, :name, :email);"));
-    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-        if (entryDetails.entryuid == 0) {
-            qCDebug(kastsUpdater) << "new episode did not get a valid entryuid; skipping authors for id:" << entryDetails.id;
-        } else {
-            for (const AuthorDetails &authorDetails : std::as_const(entryDetails.authors)) {
-                if (authorDetails.state == RecordState::New) {
-                    updatedEntryuids.insert(entryDetails.entryuid);
-                    writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
-                    writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
-                    writeQuery.bindValue(QStringLiteral(":email"), authorDetails.email);
-                    dbExecute(writeQuery);
-                }
-            }
-        }
-    }
-    writeQuery.clear();
-
-    // update authors
-    writeQuery.prepare(QStringLiteral("UPDATE EntryAuthors SET email=:email WHERE entryuid=:entryuid AND name=:name;"));
-    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-        for (const AuthorDetails &authorDetails : std::as_const(entryDetails.authors)) {
-            if (authorDetails.state == RecordState::Modified) {
-                updatedEntryuids.insert(entryDetails.entryuid);
-                writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
-                writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
-                writeQuery.bindValue(QStringLiteral(":email"), authorDetails.email);
-                dbExecute(writeQuery);
-            }
-        }
-    }
-    writeQuery.clear();
-
-    // delete entry authors that were removed
-    if (SettingsManager::self()->doFullUpdate()) { // only if this is a full update
-        writeQuery.prepare(QStringLiteral("DELETE FROM EntryAuthors WHERE entryuid=:entryuid AND name=:name;"));
-        for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-            if (entryDetails.state != RecordState::Deleted) {
-                for (const AuthorDetails &authorDetails : std::as_const(entryDetails.authors)) {
-                    if (authorDetails.state == RecordState::Deleted) {
-                        updatedEntryuids.insert(entryDetails.entryuid);
-                        writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
-                        writeQuery.bindValue(QStringLiteral(":name"), authorDetails.name);
-                        dbExecute(writeQuery);
-                        qCDebug(kastsUpdater) << "deleted old entry author:" << updatedFeed.feeduid << entryDetails.entryuid << authorDetails.name;
-                    }
-                }
-            }
-        }
-        writeQuery.clear();
-    }
-
-    // new enclosures
-    writeQuery.prepare(
-        QStringLiteral("INSERT INTO Enclosures (entryuid, feeduid, url, duration, size, type, playposition, downloaded) VALUES (:entryuid, :feeduid, "
-                       ":url, :duration, :size, :type, :playposition, :downloaded);"));
-    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-        if (entryDetails.entryuid == 0) {
-            qCDebug(kastsUpdater) << "new episode did not get a valid entryuid; skipping enclosures for id:" << entryDetails.id;
-        } else {
-            for (const EnclosureDetails &enclosureDetails : std::as_const(entryDetails.enclosures)) {
-                if (enclosureDetails.state == RecordState::New) {
-                    updatedEntryuids.insert(entryDetails.entryuid);
-                    writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
-                    writeQuery.bindValue(QStringLiteral(":feeduid"), entryDetails.feeduid);
-                    writeQuery.bindValue(QStringLiteral(":duration"), enclosureDetails.duration);
-                    writeQuery.bindValue(QStringLiteral(":size"), enclosureDetails.size);
-                    writeQuery.bindValue(QStringLiteral(":type"), enclosureDetails.type);
-                    writeQuery.bindValue(QStringLiteral(":url"), enclosureDetails.url);
-                    writeQuery.bindValue(QStringLiteral(":playposition"), enclosureDetails.playPosition);
-                    writeQuery.bindValue(QStringLiteral(":downloaded"), Enclosure::statusToDb(enclosureDetails.downloaded));
-                    dbExecute(writeQuery);
-                }
-            }
-        }
-    }
-    writeQuery.clear();
-
-    // update enclosures
-    writeQuery.prepare(
-        QStringLiteral("UPDATE Enclosures SET duration=:duration, size=:size, title=:title, type=:type, url=:url WHERE entryuid=:entryuid "
-                       "AND enclosureuid=:enclosureuid;"));
-    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-        for (const EnclosureDetails &enclosureDetails : std::as_const(entryDetails.enclosures)) {
-            if (enclosureDetails.state == RecordState::Modified) {
-                updatedEntryuids.insert(entryDetails.entryuid);
-                writeQuery.bindValue(QStringLiteral(":enclosureuid"), enclosureDetails.enclosureuid);
-                writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
-                writeQuery.bindValue(QStringLiteral(":duration"), enclosureDetails.duration);
-                writeQuery.bindValue(QStringLiteral(":size"), enclosureDetails.size);
-                writeQuery.bindValue(QStringLiteral(":type"), enclosureDetails.type);
-                writeQuery.bindValue(QStringLiteral(":url"), enclosureDetails.url);
-                dbExecute(writeQuery);
-            }
-        }
-    }
-    writeQuery.clear();
-
-    // delete removed enclosures
-    if (SettingsManager::self()->doFullUpdate()) { // only if this is a full update
-        writeQuery.prepare(QStringLiteral("DELETE FROM Enclosures WHERE enclosureuid=:enclosureuid;"));
-        for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-            if (entryDetails.state != RecordState::Deleted) {
-                for (const EnclosureDetails &enclosureDetails : std::as_const(entryDetails.enclosures)) {
-                    if (enclosureDetails.state == RecordState::Deleted) {
-                        updatedEntryuids.insert(entryDetails.entryuid);
-                        writeQuery.bindValue(QStringLiteral(":enclosureuid"), enclosureDetails.enclosureuid);
-                        dbExecute(writeQuery);
-                        qCDebug(kastsUpdater) << "deleted old enclosure:" << updatedFeed.feeduid << enclosureDetails.enclosureuid << enclosureDetails.url;
-                    }
-                }
-            }
-        }
-        writeQuery.clear();
-    }
-
-    // new chapters
-    writeQuery.prepare(QStringLiteral("INSERT INTO Chapters (entryuid, start, title, link, image) VALUES (:entryuid, :start, :title, :link, :image);"));
-    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-        if (entryDetails.entryuid == 0) {
-            qCDebug(kastsUpdater) << "new episode did not get a valid entryuid; skipping chapters for id:" << entryDetails.id;
-        } else {
-            for (const ChapterDetails &chapterDetails : std::as_const(entryDetails.chapters)) {
-                if (chapterDetails.state == RecordState::New) {
-                    updatedEntryuids.insert(entryDetails.entryuid);
-                    writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
-                    writeQuery.bindValue(QStringLiteral(":start"), chapterDetails.start);
-                    writeQuery.bindValue(QStringLiteral(":title"), chapterDetails.title);
-                    writeQuery.bindValue(QStringLiteral(":link"), chapterDetails.link);
-                    writeQuery.bindValue(QStringLiteral(":image"), chapterDetails.image);
-                    dbExecute(writeQuery);
-                }
-            }
-        }
-    }
-    writeQuery.clear();
-
-    // update chapters
-    writeQuery.prepare(QStringLiteral("UPDATE Chapters SET title=:title, link=:link, image=:image WHERE entryuid=:entryuid AND start=:start;"));
-    for (const EntryDetails &entryDetails : std::as_const(updatedFeed.entries)) {
-        for (const ChapterDetails &chapterDetails : std::as_const(entryDetails.chapters)) {
-            if (chapterDetails.state == RecordState::Modified) {
-                updatedEntryuids.insert(entryDetails.entryuid);
-                writeQuery.bindValue(QStringLiteral(":entryuid"), entryDetails.entryuid);
-                writeQuery.bindValue(QStringLiteral(":start"), chapterDetails.start);
-                writeQuery.bindValue(QStringLiteral(":title"), chapterDetails.title);
-                writeQuery.bindValue(QStringLiteral(":link"), chapterDetails.link);
-                writeQuery.bindValue(QStringLiteral(":image"), chapterDetails.image);
-                dbExecute(writeQuery);
-            }
-        }
-    }
-    writeQuery.clear();
-
-    // We don't delete chapters that haven't been found anymore, since they could also have been added through other means
-    // e.g. id3 tags.
-
-    // set custom amount of episodes to unread/new if required
-    if (updatedFeed.isNew && (SettingsManager::self()->markUnreadOnNewFeed() == 1) && (SettingsManager::self()->markUnreadOnNewFeedCustomAmount() > 0)) {
-        writeQuery.prepare(
-            QStringLiteral("UPDATE Entries SET read=:read, new=:new WHERE entryuid in (SELECT entryuid FROM Entries WHERE feeduid =:feeduid ORDER BY updated "
-                           "DESC LIMIT :recentUnread);"));
-        writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
-        writeQuery.bindValue(QStringLiteral(":read"), false);
-        writeQuery.bindValue(QStringLiteral(":new"), true);
-        writeQuery.bindValue(QStringLiteral(":recentUnread"), SettingsManager::self()->markUnreadOnNewFeedCustomAmount());
-        dbExecute(writeQuery);
-        writeQuery.clear();
-    }
-
-    if (updatedFeed.isNew) {
-        // Finally, reset the new flag to false now that the new feed has been
-        // fully processed.  If we would reset the flag sooner, then too many
-        // episodes will get flagged as new if the initial import gets
-        // interrupted somehow.
-        writeQuery.prepare(QStringLiteral("UPDATE Feeds SET new=:new WHERE feeduid=:feeduid;"));
-        writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
-        writeQuery.bindValue(QStringLiteral(":new"), false);
-        dbExecute(writeQuery);
-        writeQuery.clear();
-    }
-
-    if (updatedFeed.lastHash != updatedFeed.oldLastHash) {
-        writeQuery.prepare(QStringLiteral("UPDATE Feeds SET lastHash=:lastHash WHERE feeduid=:feeduid;"));
-        writeQuery.bindValue(QStringLiteral(":feeduid"), updatedFeed.feeduid);
-        writeQuery.bindValue(QStringLiteral(":lastHash"), updatedFeed.lastHash);
-        dbExecute(writeQuery);
-        writeQuery.clear();
-    }
-
-    if (dbCommit()) {
-        // emit signals for new entries
-        for (const qint64 entryuid : std::as_const(newEntryuids)) {
-            qCDebug(kastsUpdater) << "new episode" << entryuid;
-            Q_EMIT entryAdded(entryuid);
-        }
-
-        // emit signals for updated entries or entries with new/updated authors,
-        // enclosures or chapters
-        for (const qint64 entryuid : std::as_const(updatedEntryuids)) {
-            qCDebug(kastsUpdater) << "updated episode" << entryuid;
-            Q_EMIT entryUpdated(entryuid);
-        }
-    }
-}
-
 bool UpdateFeedJob::dbExecute(QSqlQuery &query)
 {
     bool state = Database::executeThread(query);
@@ -1080,22 +913,6 @@ bool UpdateFeedJob::dbExecute(QSqlQuery &query)
     return state;
 }
 
-bool UpdateFeedJob::dbTransaction()
-{
-    // use raw sqlite query to benefit from automatic retries on execute
-    QSqlQuery query(QSqlDatabase::database(QString::number(m_feeduid)));
-    query.prepare(QStringLiteral("BEGIN IMMEDIATE TRANSACTION;"));
-    return dbExecute(query);
-}
-
-bool UpdateFeedJob::dbCommit()
-{
-    // use raw sqlite query to benefit from automatic retries on execute
-    QSqlQuery query(QSqlDatabase::database(QString::number(m_feeduid)));
-    query.prepare(QStringLiteral("COMMIT TRANSACTION;"));
-    return dbExecute(query);
-}
-
 QString UpdateFeedJob::generateFeedDirname(const QString &name)
 {
     // Generate directory name for enclosures based on feed name
@@ -1120,6 +937,114 @@ QString UpdateFeedJob::generateFeedDirname(const QString &name)
     return dirName;
 }
 
+qint64 UpdateFeedJob::nextUpdateTime(const DataTypes::FeedDetails &updatedFeed)
+{
+    // Estimate how often this feed publishes new entries from the median
+    // interval between the most recent entries, and check it a few times per
+    // such interval.  The automatic update interval set by the user acts as
+    // the lower bound.
+    const qint64 now = QDateTime::currentDateTimeUtc().toSecsSinceEpoch();
+    const qint64 minInterval = 3600 * std::max(1, SettingsManager::self()->autoFeedUpdateInterval());
+    const qint64 maxInterval = std::max(minInterval, 3600 * qint64(SettingsManager::self()->maximumAdaptiveFeedUpdateInterval()));
+    const int checksPerInterval = 4;
+    const int sampleSize = 20;
+
+    QList<qint64> created;
+    QSqlQuery query(QSqlDatabase::database(QString::number(m_feeduid)));
+    query.prepare(QStringLiteral("SELECT created FROM Entries WHERE feeduid=:feeduid ORDER BY created DESC LIMIT :limit;"));
+    query.bindValue(QStringLiteral(":feeduid"), m_feeduid);
+    query.bindValue(QStringLiteral(":limit"), sampleSize + 1);
+    if (!dbExecute(query)) {
+        return 0;
+    }
+    while (query.next()) {
+        created += query.value(QStringLiteral("created")).toLongLong();
+    }
+    query.finish();
+
+    // the entries found in this update have not been written to the database
+    // yet, since that is left to the FeedDatabaseWriter
+    for (const DataTypes::EntryDetails &entry : std::as_const(updatedFeed.entries)) {
+        if (entry.state == DataTypes::New) {
+            created += entry.created;
+        }
+    }
+    std::sort(created.begin(), created.end(), std::greater<qint64>());
+    if (created.count() > sampleSize + 1) {
+        created.resize(sampleSize + 1);
+    }
+
+    qint64 interval = minInterval;
+    if (created.count() > 1) {
+        QList<qint64> intervals;
+        for (qsizetype i = 1; i < created.count(); ++i) {
+            intervals += created[i - 1] - created[i];
+        }
+        std::nth_element(intervals.begin(), intervals.begin() + intervals.count() / 2, intervals.end());
+        qint64 cadence = intervals[intervals.count() / 2];
+
+        // back off further if the feed has been quiet for longer than usual
+        cadence = std::max(cadence, (now - created.first()) / 2);
+
+        interval = std::clamp(cadence / checksPerInterval, minInterval, maxInterval);
+    }
+
+    // add some jitter (+/- 10%) to avoid that all feeds become due at the
+    // same time again
+    const qint64 jitter = interval / 10;
+    if (jitter > 0) {
+        interval += QRandomGenerator::global()->bounded(2 * jitter + 1) - jitter;
+    }
+
+    qCDebug(kastsUpdater) << "next update of feed" << m_feeduid << "scheduled in" << interval << "seconds";
+
+    return now + interval;
+}
+
+void UpdateFeedJob::updateFailureState(DataTypes::FeedWrite &feedWrite)
+{
+    const DataTypes::FeedDetails &updatedFeed = feedWrite.feed;
+    const bool failed = (feedWrite.stats.outcome == DataTypes::UpdateFailed || feedWrite.stats.outcome == DataTypes::UpdateParseFailed);
+
+    if (!failed) {
+        // a successful update resets the failure state, also if updates had
+        // been paused (i.e. if the user requested an update explicitly)
+        feedWrite.failureStateChanged = (updatedFeed.failureCount > 0 || updatedFeed.paused);
+        return;
+    }
+
+    // Only problems with the feed or its server count as failures. Being
+    // offline or not being able to store the download says nothing about the
+    // feed; counting those would back off or even pause all feeds at once.
+    if (feedWrite.stats.outcome == DataTypes::UpdateFailed && (m_download.writeError || Fetcher::isInterruption(m_download.networkError))) {
+        qCDebug(kastsUpdater) << "Update of feed" << m_feeduid << "failed without reaching the server; not counting it as a failure";
+        return;
+    }
+
+    // Exponential backoff, unless the server tells us how long to wait
+    feedWrite.failureStateChanged = true;
+    feedWrite.failureCount = updatedFeed.failureCount + 1;
+    const qint64 backoff = std::min(m_minBackoff << std::min(feedWrite.failureCount - 1, 16), m_maxBackoff);
+    feedWrite.retryAfter = std::max(QDateTime::currentSecsSinceEpoch() + backoff, m_download.retryAfter);
+
+    // 410 Gone means that the feed has been removed permanently; 404 is not
+    // treated that way, since servers also return it temporarily, e.g. while
+    // moving the feed, so it only leads to a pause after repeated failures
+    const int maxFailures = SettingsManager::self()->maximumFeedUpdateFailures();
+    feedWrite.paused = updatedFeed.paused || m_download.httpStatus == 410 || (maxFailures > 0 && feedWrite.failureCount >= maxFailures);
+
+    // also postpone the next automatic update
+    feedWrite.nextUpdate = std::max(feedWrite.nextUpdate, feedWrite.retryAfter);
+
+    qCDebug(kastsUpdater) << "Update of feed" << m_feeduid << "failed" << feedWrite.failureCount << "times in a row; next attempt at"
+                          << QDateTime::fromSecsSinceEpoch(feedWrite.retryAfter) << (feedWrite.paused ? "; updates are paused" : "");
+}
+
+bool UpdateFeedJob::writeQueued() const
+{
+    return m_writeQueued;
+}
+
 void UpdateFeedJob::abort()
 {
     m_abort = true;
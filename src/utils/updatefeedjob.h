@@ -18,38 +18,43 @@
 #include "datatypes.h"
 #include "error.h"
 
+class FeedDatabaseWriter;
+
 class UpdateFeedJob : public QObject, public ThreadWeaver::Job
 {
     Q_OBJECT
 
 public:
-    explicit UpdateFeedJob(const qint64 feeduid, QObject *parent = nullptr);
+    // parses and processes a feed that has already been downloaded; the
+    // resulting changes are handed over to writer
+    explicit UpdateFeedJob(const DataTypes::FeedDownload &download,
+                           FeedDatabaseWriter *writer,
+                           DataTypes::FetchPriority priority = DataTypes::NormalFetch,
+                           QObject *parent = nullptr);
 
+    int priority() const override;
     void run(ThreadWeaver::JobPointer, ThreadWeaver::Thread *) override;
     void abort();
 
+    // true if changes have been handed over to the writer; only valid after
+    // the job has finished
+    bool writeQueued() const;
+
 Q_SIGNALS:
-    void feedDetailsUpdated(const qint64 feeduid,
-                            const QString &url,
-                            const QString &name,
-                            const QString &image,
-                            const QString &link,
-                            const QString &description,
-                            const QDateTime &lastUpdated,
-                            const QString &dirname);
-    void feedUpdated(const qint64 feeduid);
-    void entryAdded(const qint64 entryuid);
-    void entryUpdated(const qint64 entryuid);
     void aborting();
     void finished();
     void error(Error::Type type, const QString &url, const QString &id, const int errorId, const QString &errorString, const QString &title);
 
 private:
-    bool downloadFeed(DataTypes::FeedDetails &updatedFeed, QByteArray &data);
-    void processFeed(const Syndication::FeedPtr feed, DataTypes::FeedDetails &updatedFeed, const QByteArray &data);
+    bool loadFeed(DataTypes::FeedDetails &updatedFeed);
+    bool feedChanged(DataTypes::FeedWrite &feedWrite);
+    void removeDownloadedFile();
+    void processFeed(const Syndication::FeedPtr feed, DataTypes::FeedWrite &feedWrite, const QString &newHash);
     bool
     processFeedAuthors(const QList<Syndication::PersonPtr> &authors, const QMultiMap<QString, QDomElement> &otherItems, DataTypes::FeedDetails &updatedFeed);
     bool processFeedAuthor(const QString &name, const QString &email, DataTypes::FeedDetails &updatedFeed);
+    void loadEntryDetails(const QStringList &entryuids, DataTypes::FeedDetails &updatedFeed);
+    QString entryHash(const Syndication::ItemPtr &entry) const;
     bool processEntry(const Syndication::ItemPtr &entry, DataTypes::FeedDetails &updatedFeed, bool markUnreadOnNew);
     bool processEntryAuthors(const QString &id,
                              const QList<Syndication::PersonPtr> &authors,
@@ -57,16 +62,25 @@ private:
                              DataTypes::FeedDetails &updatedFeed);
     bool processEntryAuthor(const QString &id, const QString &name, const QString &email, DataTypes::FeedDetails &updatedFeed);
     bool processChapters(const QString &id, const QMultiMap<QString, QDomElement> &otherItems, const QString &link, DataTypes::FeedDetails &updatedFeed);
-    bool processEnclosures(const QString &id, const QList<Syndication::EnclosurePtr> &enclosures, DataTypes::FeedDetails &updatedFeed);
-    void writeToDatabase(DataTypes::FeedDetails &updatedFeed);
+    bool processEnclosures(const QString &id,
+                           const QList<Syndication::EnclosurePtr> &enclosures,
+                           const QString &previousTitle,
+                           DataTypes::FeedDetails &updatedFeed);
+    qint64 nextUpdateTime(const DataTypes::FeedDetails &updatedFeed);
+    void updateFailureState(DataTypes::FeedWrite &feedWrite);
 
     bool dbExecute(QSqlQuery &query);
-    bool dbTransaction();
-    bool dbCommit();
 
     QString generateFeedDirname(const QString &name);
     bool m_abort = false;
 
     qint64 m_feeduid;
+    DataTypes::FeedDownload m_download;
+    FeedDatabaseWriter *m_writer;
+    bool m_writeQueued = false;
+    DataTypes::FetchPriority m_priority;
     QString m_url;
+
+    inline static const qint64 m_minBackoff = 15 * 60; // wait time in seconds after the first failed update; doubled on every next failure
+    inline static const qint64 m_maxBackoff = 24 * 60 * 60; // maximum wait time in seconds after failed updates
 };